@@ -72,6 +72,10 @@ install(DIRECTORY "${CMAKE_SOURCE_DIR}"
 
 set(CPACK_COMPONENTS_ALL package_files)
 set(CPACK_DOCKER_COMPONENT_INSTALL "ON")
+# Only stage the source files that changed since the last package.
+if(NOT DEFINED CPACK_INCREMENTAL_INSTALL)
+  set(CPACK_INCREMENTAL_INSTALL ON)
+endif()
 
 function(CREATE_DOCKERFILE)
   set(options "")
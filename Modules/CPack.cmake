@@ -162,6 +162,12 @@
 #
 #   cpack -D CPACK_GENERATOR="ZIP;TGZ" /path/to/build/tree
 #
+#  Archive generators listed together, such as ``TGZ``, ``TXZ`` and ``ZIP``,
+#  install the project only once and write all their archives from a
+#  single read of each file.  This is not done when a
+#  :variable:`CPACK_PROJECT_CONFIG_FILE` is used, because it may set up each
+#  generator differently.
+#
 # .. variable:: CPACK_OUTPUT_CONFIG_FILE
 #
 #  The name of the CPack binary configuration file. This file is the CPack
@@ -182,6 +188,37 @@
 #  will be a boolean variable which enables stripping of all files (a list
 #  of files evaluates to TRUE in CMake, so this change is compatible).
 #
+# .. variable:: CPACK_INCREMENTAL_INSTALL
+#
+#  If set to TRUE, the temporary install directory of the previous CPack
+#  run is updated instead of being recreated.  Files whose time stamp did
+#  not change are not copied again and files that are no longer installed
+#  are removed.  This speeds up packaging large trees that change little.
+#  Files that install scripts write themselves are removed and written
+#  again on each run.  It only applies to
+#  :variable:`CPACK_INSTALL_CMAKE_PROJECTS`, so it is ignored when
+#  :variable:`CPACK_INSTALL_COMMANDS`, ``CPACK_INSTALL_SCRIPT`` or
+#  :variable:`CPACK_INSTALLED_DIRECTORIES` are set.
+#
+# .. variable:: CPACK_INSTALL_PARALLEL_JOBS
+#
+#  The maximum number of components of a project in
+#  :variable:`CPACK_INSTALL_CMAKE_PROJECTS` that are installed at the same
+#  time.  Each of them is installed by its own ``cmake -P`` process.
+#  This includes components sharing an install directory, such as the
+#  components of a group, whose files are told apart by their install
+#  manifests.  Defaults to 1.
+#
+# .. variable:: CPACK_ARCHIVE_THREADS
+#
+#  The number of threads the archive generators use to compress ``TGZ``,
+#  ``TBZ2`` and ``TXZ`` packages, or 0 for one thread per processor.
+#  The DEB generator uses it for its ``data.tar`` with the ``gzip``,
+#  ``bzip2`` and ``xz`` :variable:`CPACK_DEBIAN_COMPRESSION_TYPE`.
+#  The data is compressed in independent blocks that are written as
+#  consecutive gzip members, bzip2 streams or xz streams, which stock
+#  tools decompress as one file.  Defaults to 1.
+#
 # The following CPack variables are specific to source packages, and
 # will not affect binary packages:
 #
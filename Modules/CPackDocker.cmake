@@ -292,6 +292,16 @@
 #
 #  Automatically builds the docker images of the components
 #
+#  The build context sent to ``docker build`` contains only the generated
+#  dockerfile and the staged files of the component, not the whole
+#  :variable:`CPACK_PACKAGE_DIRECTORY`.  It is streamed to ``docker build``
+#  through a pipe and never written to disk.
+#
+#  A fingerprint of the dockerfile and the staged files is stored next to
+#  the package as ``<package>.fingerprint``.  The image is not built again
+#  while the fingerprint is unchanged and the image still exists.  Files
+#  whose size and modification time did not change are not hashed again.
+#
 #  * Mandatory : NO
 #  * Default   : NO
 #
@@ -310,6 +320,114 @@
 #  Example::
 #
 #    set(CPACK_DOCKER_DELETE_CONTAINER TRUE)
+#
+#
+# .. variable:: CPACK_DOCKER_PARALLEL_JOBS
+#
+#  Maximum number of docker images built concurrently.  The dockerfiles of
+#  all packs are generated first, then their images are built.  The output
+#  of a failed build is written to ``Docker-<image>.log`` in
+#  :variable:`CPACK_PACKAGE_DIRECTORY`, and failures are reported in
+#  packaging order.
+#
+#  * Mandatory : NO
+#  * Default   : 1
+#
+#  Example::
+#
+#    set(CPACK_DOCKER_PARALLEL_JOBS 8)
+#
+#
+# .. variable:: CPACK_DOCKER_LAYERS
+#
+#  Ordered list of layer names used to split the staged files into several
+#  COPY layers, from the least to the most frequently changing.  The files
+#  of each layer are selected by :variable:`CPACK_DOCKER_LAYER_<NAME>`, and
+#  the files not selected by any layer are copied last.  Package
+#  dependencies and other instructions that do not depend on the staged
+#  files are placed before the COPY layers so that docker can reuse their
+#  cached layers.
+#
+#  * Mandatory : NO
+#  * Default   :
+#
+#  Example::
+#
+#    set(CPACK_DOCKER_LAYERS thirdparty data)
+#
+#
+# .. variable:: CPACK_DOCKER_LAYER_<NAME>
+#
+#  Globbing expressions, relative to the staged tree, selecting the files
+#  of layer ``<NAME>`` (upper case).  A file belongs to the first layer
+#  with an expression matching its path or one of its parent directories.
+#
+#  * Mandatory : NO
+#  * Default   :
+#
+#  Example::
+#
+#    set(CPACK_DOCKER_LAYER_THIRDPARTY "usr/lib/thirdparty")
+#    set(CPACK_DOCKER_LAYER_DATA "usr/share/*")
+#
+#
+# .. variable:: CPACK_DOCKER_RUNTIME_LIBRARIES
+#
+#  Derives the runtime dependencies of the image from the staged ELF files.
+#  The libraries they need (``DT_NEEDED``) are looked up like the dynamic
+#  loader does, through their RPATH or RUNPATH, ``/etc/ld.so.conf`` and the
+#  standard library directories, recursively.  Libraries shipped in the
+#  package itself are not looked up.
+#
+#  ``COPY`` copies the host libraries found, and the program interpreter,
+#  into a first layer at their host paths.  This is meant for an empty
+#  :variable:`CPACK_DOCKER_FROM` such as ``scratch`` or for
+#  :variable:`CPACK_DOCKER_IMAGE_FORMAT` ``OCI``.  ``LD_LIBRARY_PATH`` is set
+#  to the non-standard directories used, as such images have no
+#  ``ld.so.cache``.
+#
+#  ``PACKAGES`` asks the host package database (dpkg, rpm or pacman) which
+#  packages own the libraries and adds them to
+#  :variable:`CPACK_DOCKER_PACKAGE_DEPENDS`.  The base image must then use
+#  the package names of the host distribution.
+#
+#  * Mandatory : NO
+#  * Default   :
+#
+#  Example::
+#
+#    set(CPACK_DOCKER_FROM scratch)
+#    set(CPACK_DOCKER_RUNTIME_LIBRARIES COPY)
+#
+#
+# .. variable:: CPACK_DOCKER_IMAGE_FORMAT
+#
+#  Selects what the generator produces.  ``DOCKERFILE`` writes a Dockerfile
+#  for ``docker build``.  ``OCI`` writes the image itself as a ``.oci.tar``
+#  archive without running docker: an OCI image layout that can also be
+#  read by ``docker load``.  The OCI image has no base image, so
+#  :variable:`CPACK_DOCKER_FROM`, the package dependencies and the RUN and
+#  ONBUILD instructions are not used.  Its timestamps and file owners are
+#  fixed so that unchanged content keeps the same digests.
+#
+#  * Mandatory : NO
+#  * Default   : DOCKERFILE
+#
+#  Example::
+#
+#    set(CPACK_DOCKER_IMAGE_FORMAT OCI)
+#
+#
+# .. variable:: CPACK_DOCKER_IMAGE_ARCHITECTURE
+#
+#  The architecture recorded in the configuration of an OCI image.
+#
+#  * Mandatory : NO
+#  * Default   : Output of ``uname -m`` in Go notation (e.g. ``amd64``)
+#
+#  Example::
+#
+#    set(CPACK_DOCKER_IMAGE_ARCHITECTURE arm64)
 
 #=============================================================================
 # Copyright 2007-2009 Kitware, Inc.
@@ -413,6 +531,23 @@ function(cpack_docker_prepare_package_vars)
     set(CPACK_DOCKER_DELETE_CONTAINER FALSE)
   endif()
 
+  # Architecture: (OCI images only)
+  string(TOUPPER "${CPACK_DOCKER_IMAGE_FORMAT}" _image_format)
+  if(_image_format STREQUAL "OCI" AND NOT CPACK_DOCKER_IMAGE_ARCHITECTURE)
+    execute_process(COMMAND uname -m
+      OUTPUT_VARIABLE CPACK_DOCKER_IMAGE_ARCHITECTURE
+      OUTPUT_STRIP_TRAILING_WHITESPACE)
+    if(CPACK_DOCKER_IMAGE_ARCHITECTURE STREQUAL "x86_64")
+      set(CPACK_DOCKER_IMAGE_ARCHITECTURE "amd64")
+    elseif(CPACK_DOCKER_IMAGE_ARCHITECTURE MATCHES "^(aarch64|arm64)$")
+      set(CPACK_DOCKER_IMAGE_ARCHITECTURE "arm64")
+    elseif(CPACK_DOCKER_IMAGE_ARCHITECTURE MATCHES "^arm")
+      set(CPACK_DOCKER_IMAGE_ARCHITECTURE "arm")
+    elseif(CPACK_DOCKER_IMAGE_ARCHITECTURE MATCHES "^i[3-6]86$")
+      set(CPACK_DOCKER_IMAGE_ARCHITECTURE "386")
+    endif()
+  endif()
+
   if(CPACK_DOCKER_CONTAINER_COMPONENT)
     set(_component_depends_var "CPACK_DOCKER_${_local_component_name}_PACKAGE_DEPENDS")
 
@@ -473,6 +608,7 @@ function(cpack_docker_prepare_package_vars)
   set(GEN_CPACK_DOCKER_CONTAINER_HOMEPAGE       "${CPACK_DOCKER_CONTAINER_HOMEPAGE}"      PARENT_SCOPE)
   set(GEN_CPACK_DOCKER_BUILD_CONTAINER          "${CPACK_DOCKER_BUILD_CONTAINER}"         PARENT_SCOPE)
   set(GEN_CPACK_DOCKER_DELETE_CONTAINER         "${CPACK_DOCKER_DELETE_CONTAINER}"        PARENT_SCOPE)
+  set(GEN_CPACK_DOCKER_IMAGE_ARCHITECTURE      "${CPACK_DOCKER_IMAGE_ARCHITECTURE}"      PARENT_SCOPE)
   set(GEN_WDIR                                  "${WDIR}"                                 PARENT_SCOPE)
 endfunction()
 
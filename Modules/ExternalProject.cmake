@@ -66,7 +66,8 @@ Create custom targets to build projects in external trees
   ``URL /.../src.tgz``
     Full path or URL of source
   ``URL_HASH ALGO=value``
-    Hash of file at URL
+    Hash of file at URL, also used to find the file in the
+    :variable:`CMAKE_DOWNLOAD_CACHE`
   ``URL_MD5 md5``
     Equivalent to URL_HASH MD5=md5
   ``TLS_VERIFY <bool>``
@@ -836,8 +837,17 @@ function(_ep_write_downloadfile_script script_filename remote local timeout no_p
       "  endif()\n"
       "endif()\n"
       )
+    # Let the download use and fill the download cache.
+    set(hash_args "EXPECTED_HASH ${CMAKE_MATCH_1}=${CMAKE_MATCH_2}")
   else()
     set(hash_check "")
+    set(hash_args "# no EXPECTED_HASH")
+  endif()
+
+  if(DEFINED CMAKE_DOWNLOAD_CACHE)
+    set(download_cache "set(CMAKE_DOWNLOAD_CACHE \"${CMAKE_DOWNLOAD_CACHE}\")")
+  else()
+    set(download_cache "")
   endif()
 
   # check for curl globals in the project
@@ -870,12 +880,14 @@ function(_ep_write_downloadfile_script script_filename remote local timeout no_p
 
 ${tls_verify}
 ${tls_cainfo}
+${download_cache}
 
 file(DOWNLOAD
   \"${remote}\"
   \"${local}\"
   ${show_progress}
   ${timeout_args}
+  ${hash_args}
   STATUS status
   LOG log)
 
@@ -984,7 +996,7 @@ file(MAKE_DIRECTORY \"\${ut_dir}\")
 # Extract it:
 #
 message(STATUS \"extracting... [tar ${args}]\")
-execute_process(COMMAND \${CMAKE_COMMAND} -E tar ${args} \${filename}
+execute_process(COMMAND \${CMAKE_COMMAND} -E tar ${args} \${filename} --threads=0
   WORKING_DIRECTORY \${ut_dir}
   RESULT_VARIABLE rv)
 
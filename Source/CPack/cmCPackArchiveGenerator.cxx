@@ -19,10 +19,12 @@
 #include "cmMakefile.h"
 #include "cmGeneratedFileStream.h"
 #include "cmCPackLog.h"
+#include "cmAlgorithms.h"
 #include <errno.h>
 
 #include <cmsys/SystemTools.hxx>
 #include <cmsys/Directory.hxx>
+#include <cmsys/SystemInformation.hxx>
 #include <cm_libarchive.h>
 
 //----------------------------------------------------------------------
@@ -31,6 +33,7 @@ cmCPackArchiveGenerator::cmCPackArchiveGenerator(cmArchiveWrite::Compress t,
 {
   this->Compress = t;
   this->ArchiveFormat = format;
+  this->ArchiveThreads = 1;
 }
 
 //----------------------------------------------------------------------
@@ -42,6 +45,24 @@ cmCPackArchiveGenerator::~cmCPackArchiveGenerator()
 int cmCPackArchiveGenerator::InitializeInternal()
 {
   this->SetOptionIfNotSet("CPACK_INCLUDE_TOPLEVEL_DIRECTORY", "1");
+  const char* threadsStr = this->GetOption("CPACK_ARCHIVE_THREADS");
+  unsigned long threads = 1;
+  if (threadsStr && *threadsStr &&
+      !cmSystemTools::StringToULong(threadsStr, &threads))
+    {
+    cmCPackLogger(cmCPackLog::LOG_WARNING,
+                  "Invalid value for CPACK_ARCHIVE_THREADS: "
+                  << threadsStr << std::endl);
+    threads = 1;
+    }
+  if (threads == 0)
+    {
+    // Use every processor of the host
+    cmsys::SystemInformation info;
+    info.RunCPUCheck();
+    threads = info.GetNumberOfLogicalCPU();
+    }
+  this->ArchiveThreads = threads > 0 ? static_cast<unsigned int>(threads) : 1;
   return this->Superclass::InitializeInternal();
 }
 //----------------------------------------------------------------------
@@ -108,7 +129,8 @@ if (!GenerateHeader(&gf)) \
             << ">." << std::endl); \
     return 0; \
   } \
-cmArchiveWrite archive(gf,this->Compress, this->ArchiveFormat); \
+cmArchiveWrite archive(gf,this->Compress, this->ArchiveFormat, \
+                       this->ArchiveThreads); \
 if (!archive) \
   { \
   cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem to create archive < " \
@@ -117,8 +139,98 @@ if (!archive) \
      << archive.GetError() \
      << std::endl); \
   return 0; \
+  } \
+SharedArchives archive##Shared; \
+if (!this->OpenSharedArchives(filename, archive, archive##Shared)) \
+  { \
+  return 0; \
+  }
+
+/*
+ * The macro will finish the archive declared by DECLARE_AND_OPEN_ARCHIVE
+ * together with its shared archives, and return if that fails.
+ */
+#define FINISH_ARCHIVE(filename,archive) \
+if (!this->FinishArchives(filename, archive, archive##Shared)) \
+  { \
+  return 0; \
   }
 
+//----------------------------------------------------------------------
+cmCPackArchiveGenerator::SharedArchives::~SharedArchives()
+{
+  // Finish the archives before closing their files
+  cmDeleteAll(this->Archives);
+  cmDeleteAll(this->Streams);
+}
+
+//----------------------------------------------------------------------
+int cmCPackArchiveGenerator::OpenSharedArchives(std::string packageFileName,
+  cmArchiveWrite& archive, SharedArchives& shared)
+{
+  std::string ext = this->GetOutputExtension();
+  if (cmSystemTools::StringEndsWith(packageFileName.c_str(), ext.c_str()))
+    {
+    packageFileName.erase(packageFileName.size() - ext.size());
+    }
+  std::vector<cmCPackArchiveGenerator*>::const_iterator it;
+  for (it = this->SharedGenerators.begin();
+       it != this->SharedGenerators.end(); ++it)
+    {
+    std::string fileName = packageFileName + (*it)->GetOutputExtension();
+    cmGeneratedFileStream* gf = new cmGeneratedFileStream;
+    shared.Streams.push_back(gf);
+    gf->Open(fileName.c_str(), false, true);
+    if (!(*it)->GenerateHeader(gf))
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+        "Problem to generate Header for archive < "
+        << fileName << ">." << std::endl);
+      return 0;
+      }
+    cmArchiveWrite* a =
+      new cmArchiveWrite(*gf, (*it)->Compress, (*it)->ArchiveFormat,
+                         this->ArchiveThreads);
+    shared.Archives.push_back(a);
+    if (!*a)
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem to create archive < "
+        << fileName << ">. ERROR =" << a->GetError() << std::endl);
+      return 0;
+      }
+    archive.AddMirror(a);
+    shared.FileNames.push_back(fileName);
+    packageFileNames.push_back(fileName);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------
+int cmCPackArchiveGenerator::FinishArchives(
+  std::string const& packageFileName, cmArchiveWrite& archive,
+  SharedArchives& shared)
+{
+  // The last blocks of the archives are written here, so this is where
+  // a full disk shows.
+  if (!archive.Finish())
+    {
+    cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem to finish archive < "
+      << packageFileName << ">. ERROR =" << archive.GetError() << std::endl);
+    return 0;
+    }
+  for (size_t i = 0; i < shared.Archives.size(); ++i)
+    {
+    if (!shared.Archives[i]->Finish())
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem to finish archive < "
+        << shared.FileNames[i] << ">. ERROR ="
+        << shared.Archives[i]->GetError() << std::endl);
+      return 0;
+      }
+    }
+  return 1;
+}
+
 //----------------------------------------------------------------------
 int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
 {
@@ -154,6 +266,7 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
           // Add the files of this component to the archive
           addOneComponentToArchive(archive,*compIt);
           }
+        FINISH_ARCHIVE(packageFileName,archive);
       }
       // add the generated package to package file names list
       packageFileNames.push_back(packageFileName);
@@ -186,6 +299,7 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
           DECLARE_AND_OPEN_ARCHIVE(packageFileName,archive);
           // Add the files of this component to the archive
           addOneComponentToArchive(archive,&(compIt->second));
+          FINISH_ARCHIVE(packageFileName,archive);
         }
         // add the generated package to package file names list
         packageFileNames.push_back(packageFileName);
@@ -213,6 +327,7 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
         DECLARE_AND_OPEN_ARCHIVE(packageFileName,archive);
         // Add the files of this component to the archive
         addOneComponentToArchive(archive,&(compIt->second));
+        FINISH_ARCHIVE(packageFileName,archive);
       }
       // add the generated package to package file names list
       packageFileNames.push_back(packageFileName);
@@ -245,7 +360,7 @@ int cmCPackArchiveGenerator::PackageComponentsAllInOne()
     addOneComponentToArchive(archive,&(compIt->second));
     }
 
-  // archive goes out of scope so it will finalized and closed.
+  FINISH_ARCHIVE(packageFileNames[0],archive);
   return 1;
 }
 
@@ -297,7 +412,7 @@ int cmCPackArchiveGenerator::PackageFiles()
       }
     }
   cmSystemTools::ChangeDirectory(dir);
-  // The destructor of cmArchiveWrite will close and finish the write
+  FINISH_ARCHIVE(packageFileNames[0],archive);
   return 1;
 }
 
@@ -16,6 +16,7 @@
 #include "cmArchiveWrite.h"
 #include "cmCPackGenerator.h"
 
+class cmGeneratedFileStream;
 
 /** \class cmCPackArchiveGenerator
  * \brief A generator base for libarchive generation.
@@ -37,6 +38,14 @@ public:
   virtual int GenerateHeader(std::ostream* os);
   // component support
   virtual bool SupportsComponentInstallation() const;
+  // Whether the archives of other generators may be written along
+  virtual bool SupportsSharedArchives() const { return true; }
+  /**
+   * Also write the archives of the given generator, from the files
+   * installed for this one.  The generator needs not be initialized.
+   */
+  void AddSharedGenerator(cmCPackArchiveGenerator* gen)
+    { this->SharedGenerators.push_back(gen); }
 protected:
   virtual int InitializeInternal();
   /**
@@ -67,8 +76,35 @@ protected:
    */
   int PackageComponentsAllInOne();
   virtual const char* GetOutputExtension() = 0;
+
+  /**
+   * The archives of the shared generators written along one package.
+   */
+  class SharedArchives
+  {
+  public:
+    ~SharedArchives();
+    std::vector<cmGeneratedFileStream*> Streams;
+    std::vector<cmArchiveWrite*> Archives;
+    std::vector<std::string> FileNames;
+  };
+  /**
+   * Open the archives of the shared generators next to the given
+   * package and make the given archive write to them as well.
+   */
+  int OpenSharedArchives(std::string packageFileName,
+                         cmArchiveWrite& archive, SharedArchives& shared);
+  /**
+   * Finish the given archive and the archives of the shared generators
+   * written along, and report the first error.
+   */
+  int FinishArchives(std::string const& packageFileName,
+                     cmArchiveWrite& archive, SharedArchives& shared);
+
   cmArchiveWrite::Compress Compress;
   std::string ArchiveFormat;
+  unsigned int ArchiveThreads;
+  std::vector<cmCPackArchiveGenerator*> SharedGenerators;
   };
 
 #endif
@@ -415,6 +415,8 @@ int cmCPackDebGenerator::createDeb()
       compression_suffix = ".lzma";
   } else if(!strcmp(debian_compression_type, "xz")) {
       compression_suffix = ".xz";
+      compression_modifier = "J";
+      cmake_tar += "\"" + cmSystemTools::GetCMakeCommand() + "\" -E ";
   } else if(!strcmp(debian_compression_type, "bzip2")) {
       compression_suffix = ".bz2";
       compression_modifier = "j";
@@ -435,6 +437,23 @@ int cmCPackDebGenerator::createDeb()
 
   cmd += cmake_tar + "tar c" + compression_modifier + "f data.tar"
       + compression_suffix;
+  // cmake -E tar compresses gzip, bzip2 and xz data on several threads.
+  const char* threads = this->GetOption("CPACK_ARCHIVE_THREADS");
+  if(cmake_tar != " " && threads && *threads)
+    {
+    unsigned long n;
+    if(cmSystemTools::StringToULong(threads, &n))
+      {
+      cmd += " --threads=";
+      cmd += threads;
+      }
+    else
+      {
+      cmCPackLogger(cmCPackLog::LOG_WARNING,
+                    "Invalid value for CPACK_ARCHIVE_THREADS: "
+                    << threads << std::endl);
+      }
+    }
 
   // now add all directories which have to be compressed
   // collect all top level install dirs for that
@@ -15,13 +15,189 @@
 #include "cmMakefile.h"
 #include "cmGeneratedFileStream.h"
 #include "cmCPackLog.h"
+#include "cmArchiveWrite.h"
+#include "cmCryptoHash.h"
+#if defined(CMAKE_USE_ELF_PARSER)
+# include "cmELF.h"
+#endif
 
 #include <cmsys/SystemTools.hxx>
 #include <cmsys/Glob.hxx>
+#include <cmsys/FStream.hxx>
+#include <cmsys/RegularExpression.hxx>
+
+#include "cm_jsoncpp_value.h"
+#include "cm_jsoncpp_writer.h"
 
 #include <limits.h> // USHRT_MAX
 #include <algorithm> // std::sort
+#include <deque>
+#include <set>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// OCI images are written with a fixed timestamp and owner so that
+// unchanged content always produces the same digests.
+#define CPACK_DOCKER_OCI_MTIME "1970-01-01 00:00:00 UTC"
+#define CPACK_DOCKER_OCI_CREATED "1970-01-01T00:00:00Z"
+
+//----------------------------------------------------------------------
+// Stream buffer writing straight to a file descriptor, used to stream
+// the build context into a pipe.
+class cmCPackDockerPipeBuf : public std::streambuf
+{
+public:
+  cmCPackDockerPipeBuf(int fd) : Fd(fd), Error(0) {}
+  // The errno of the failed write, if any.
+  int GetError() const { return this->Error; }
+protected:
+  virtual int_type overflow(int_type c)
+  {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+      return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    return this->xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+  }
+  virtual std::streamsize xsputn(const char* s, std::streamsize n)
+  {
+    std::streamsize left = n;
+    while (left > 0) {
+      ssize_t r = write(this->Fd, s, static_cast<size_t>(left));
+      if (r < 0 && errno == EINTR) {
+        continue;
+      }
+      if (r <= 0) {
+        this->Error = r < 0 ? errno : EIO;
+        return 0;
+      }
+      s += r;
+      left -= r;
+    }
+    return n;
+  }
+private:
+  int Fd;
+  int Error;
+};
+
+//----------------------------------------------------------------------
+// Stream buffer forwarding to another stream while computing the
+// sha256 digest and size of everything written through it.
+class cmCPackDockerDigestBuf : public std::streambuf
+{
+public:
+  cmCPackDockerDigestBuf(std::ostream& os)
+    : Stream(os), Hash(cmCryptoHash::New("SHA256")), Size(0)
+  {
+    this->Hash->Initialize();
+  }
+  std::string GetDigest() { return "sha256:" + this->Hash->Finalize(); }
+  unsigned long GetSize() const { return this->Size; }
+protected:
+  virtual int_type overflow(int_type c)
+  {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+      return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    return this->xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+  }
+  virtual std::streamsize xsputn(const char* s, std::streamsize n)
+  {
+    if (!this->Stream.write(s, n)) {
+      return 0;
+    }
+    this->Hash->Append(reinterpret_cast<unsigned char const*>(s),
+                       static_cast<int>(n));
+    this->Size += static_cast<unsigned long>(n);
+    return n;
+  }
+private:
+  std::ostream& Stream;
+  cmsys::auto_ptr<cmCryptoHash> Hash;
+  unsigned long Size;
+};
+
+//----------------------------------------------------------------------
+// A file of a layer in the fingerprint of the image.
+struct cmCPackDockerFingerprintFile
+{
+  std::string Key;
+  std::string Path;
+  unsigned int Mode;
+  std::string Hash;
+};
+
+//----------------------------------------------------------------------
+static void cmCPackDockerNormalizeArchive(cmArchiveWrite& archive)
+{
+  archive.SetMTime(CPACK_DOCKER_OCI_MTIME);
+  archive.SetUIDAndGID(0, 0);
+  archive.SetUNAMEAndGNAME("root", "root");
+}
+
+#if defined(CMAKE_USE_ELF_PARSER)
+//----------------------------------------------------------------------
+// Append the directories listed by an ld.so.conf file, following its
+// include directives.
+static void cmCPackDockerReadLdSoConf(const std::string& file,
+                                      std::vector<std::string>& dirs,
+                                      int depth)
+{
+  cmsys::ifstream fin(file.c_str());
+  std::string line;
+  while (fin && cmSystemTools::GetLineFromStream(fin, line)) {
+    line = cmSystemTools::TrimWhitespace(line.substr(0, line.find('#')));
+    if (line.compare(0, 8, "include ") == 0 && depth < 8) {
+      std::string pattern = cmSystemTools::TrimWhitespace(line.substr(8));
+      if (!cmSystemTools::FileIsFullPath(pattern.c_str()))
+        pattern = cmSystemTools::GetFilenamePath(file) + "/" + pattern;
+      cmsys::Glob gl;
+      gl.FindFiles(pattern);
+      std::vector<std::string> confs = gl.GetFiles();
+      std::sort(confs.begin(), confs.end());
+      for (size_t i = 0; i < confs.size(); ++i) {
+        cmCPackDockerReadLdSoConf(confs[i], dirs, depth + 1);
+      }
+    } else if (!line.empty() && line[0] == '/') {
+      dirs.push_back(line);
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// Split an RPATH or RUNPATH and substitute $ORIGIN.
+static void cmCPackDockerExpandRPath(cmELF::StringEntry const* se,
+                                     const std::string& origin,
+                                     std::vector<std::string>& dirs)
+{
+  if (!se)
+    return;
+  std::vector<std::string> paths = cmSystemTools::tokenize(se->Value, ":");
+  for (size_t i = 0; i < paths.size(); ++i) {
+    cmSystemTools::ReplaceString(paths[i], "${ORIGIN}", origin.c_str());
+    cmSystemTools::ReplaceString(paths[i], "$ORIGIN", origin.c_str());
+    if (!paths[i].empty())
+      dirs.push_back(paths[i]);
+  }
+}
+
+//----------------------------------------------------------------------
+// Identify the ELF class, byte order and machine so that a library built
+// for another target found on the search path is skipped.
+static std::string cmCPackDockerELFTarget(cmELF const& elf)
+{
+  char buf[20];
+  if (!elf.ReadBytes(0, sizeof(buf), buf))
+    return std::string();
+  return std::string(buf + 4, 2) + std::string(buf + 18, 2);
+}
+#endif
 
 //----------------------------------------------------------------------
 cmCPackDockerGenerator::cmCPackDockerGenerator()
@@ -44,6 +220,19 @@ int cmCPackDockerGenerator::InitializeInternal()
   return this->Superclass::InitializeInternal();
 }
 
+//----------------------------------------------------------------------
+bool cmCPackDockerGenerator::isOCIImage() const
+{
+  const char* format = this->GetOption("CPACK_DOCKER_IMAGE_FORMAT");
+  return format && cmSystemTools::UpperCase(format) == "OCI";
+}
+
+//----------------------------------------------------------------------
+const char* cmCPackDockerGenerator::GetOutputExtension()
+{
+  return this->isOCIImage() ? ".oci.tar" : ".dockerfile";
+}
+
 //----------------------------------------------------------------------
 int cmCPackDockerGenerator::PackageOnePack(std::string initialTopLevel,
                                            std::string packageName)
@@ -83,6 +272,7 @@ int cmCPackDockerGenerator::PackageOnePack(std::string initialTopLevel,
   std::string findExpr(this->GetOption("GEN_WDIR"));
   findExpr += "/*";
   gl.RecurseOn();
+  gl.SetThreads(0);
   if ( !gl.FindFiles(findExpr) )
   {
     cmCPackLogger(cmCPackLog::LOG_ERROR,
@@ -205,6 +395,7 @@ int cmCPackDockerGenerator::PackageComponentsAllInOne()
   std::string findExpr(this->GetOption("GEN_WDIR"));
   findExpr += "/*";
   gl.RecurseOn();
+  gl.SetThreads(0);
   if ( !gl.FindFiles(findExpr) )
   {
     cmCPackLogger(cmCPackLog::LOG_ERROR,
@@ -227,12 +418,13 @@ int cmCPackDockerGenerator::PackageComponentsAllInOne()
 int cmCPackDockerGenerator::PackageFiles()
 {
   int retval = -1;
+  dockerJobs.clear();
   if (WantsComponentInstallation()) {
     if (componentPackageMethod == ONE_PACKAGE)
-      return PackageComponentsAllInOne();
+      retval = PackageComponentsAllInOne();
     else
-      return PackageComponents(componentPackageMethod ==
-                               ONE_PACKAGE_PER_COMPONENT);
+      retval = PackageComponents(componentPackageMethod ==
+                                 ONE_PACKAGE_PER_COMPONENT);
   } else {
     if (!this->ReadListFile("CPackDocker.cmake")) {
       cmCPackLogger(cmCPackLog::LOG_ERROR, "Error while parsing CPackDocker.cmake" << std::endl);
@@ -240,14 +432,21 @@ int cmCPackDockerGenerator::PackageFiles()
     }
     else {
       packageFiles = files;
-      return createDocker();
+      retval = createDocker();
     }
   }
+  // The images of all packs are built once their dockerfiles exist, so
+  // that independent packs can be built concurrently.
+  if (!this->runDockerJobs())
+    retval = 0;
   return retval;
 }
 
 int cmCPackDockerGenerator::createDocker()
 {
+  if (this->isOCIImage())
+    return this->createOCIImage();
+
   std::string dockerfilename = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
   dockerfilename += "/";
   dockerfilename += this->GetOption("CPACK_OUTPUT_FILE_NAME");
@@ -256,25 +455,34 @@ int cmCPackDockerGenerator::createDocker()
       this->GetOption("GEN_CPACK_DOCKER_FROM");
   const char* maintainer =
       this->GetOption("GEN_CPACK_DOCKER_MAINTAINER");
-  std::string packagemanager = this->getPackageManager();
-  cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: Package manager " << packagemanager << std::endl);
+  if (!this->partitionLayers() || !this->prepareRuntimeLibraries())
+    return 0;
+  // Probing the base image is only worth it if something gets installed.
+  std::string packagemanager;
+  const char* depends = this->GetOption("GEN_CPACK_DOCKER_PACKAGE_DEPENDS");
+  if ((depends && *depends) || !runtimePackages.empty()) {
+    packagemanager = this->getPackageManager();
+    cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: Package manager " << packagemanager << std::endl);
+  }
   std::string packagedepends = this->getDependencies(packagemanager);
   cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: Package dependencies " << packagedepends << std::endl);
   {
-    // Create dockerfile
+    // Create dockerfile.  Instructions that rarely change come first so
+    // that docker can reuse their cached layers when only the staged
+    // files change.
     cmGeneratedFileStream out(dockerfilename.c_str());
     out << "# Autogenerated Dockerfile using CPack" << std::endl;
     out << "FROM " << docker_base_image << std::endl;
     out << "MAINTAINER " << maintainer << std::endl;
     out << getEnv();
-    out << getLabels();
-    out << getVolume();
-    out << getFiles();
     out << getRun("GEN_CPACK_DOCKER_RUN_PREDEPENDS");
-    out << getDependencies(packagemanager);
+    out << packagedepends;
+    out << getFiles();
     out << getUser();
     out << getWorkdir();
     out << getRun("GEN_CPACK_DOCKER_RUN_POSTDEPENDS");
+    out << getVolume();
+    out << getLabels();
     out << getOnbuild();
     out << getEntrypoint();
     out << getCmd();
@@ -282,102 +490,730 @@ int cmCPackDockerGenerator::createDocker()
   cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: created dockerfile" << std::endl);
 
   if (IsOn("GEN_CPACK_DOCKER_BUILD_CONTAINER")) {
-    if (!buildDockerContainer())
+    if (cmSystemTools::FindProgram("docker").empty()) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "CPackDocker: docker is needed "
+                    "to build the image, set CPACK_DOCKER_IMAGE_FORMAT to OCI "
+                    "to write it without docker" << std::endl);
       return 0;
-    else {
-      if (IsOn("GEN_CPACK_DOCKER_DELETE_CONTAINER")) {
-        if (!deleteDockerContainer())
-          return 0;
-      }
     }
+    // Skip the docker round trip if neither the dockerfile nor the staged
+    // files changed since the image was last built.
+    std::string stampfile = this->GetOption("CPACK_PACKAGE_DIRECTORY");
+    stampfile += "/";
+    stampfile += this->GetOption("CPACK_OUTPUT_FILE_NAME");
+    stampfile += ".fingerprint";
+    std::string stamps;
+    std::string fingerprint = this->getFingerprint(dockerfilename, stampfile,
+                                                   stamps);
+    if (fingerprint.empty())
+      return 0;
+    if (this->isImageUpToDate(stampfile, fingerprint)) {
+      cmCPackLogger(cmCPackLog::LOG_OUTPUT, "- Docker image "
+                    << this->getTagName() << " is up to date" << std::endl);
+      return 1;
+    }
+    cmSystemTools::RemoveFile(stampfile);
+    if (!buildDockerContainer(stampfile, fingerprint + "\n" + stamps))
+      return 0;
   }
   return 1;
 }
 
-int cmCPackDockerGenerator::buildDockerContainer()
+int cmCPackDockerGenerator::buildDockerContainer(const std::string &stampfile,
+                                                 const std::string &stamp)
 {
-  // dockerimage
-  std::string output_name = this->GetOption("CPACK_PACKAGE_DIRECTORY");
-  output_name += "/_CPack_Packages/";
-  output_name += this->GetOption("CPACK_TOPLEVEL_TAG");
-  output_name += "/";
-  output_name += this->GetOption("CPACK_GENERATOR");
-  output_name += "/";
-  output_name += this->GetOption("CPACK_OUTPUT_FILE_NAME");
-  // docker policy enforces lower case for container tags
-  std::string tag_name = this->GetOption("CPACK_OUTPUT_FILE_NAME");
-  std::size_t found = tag_name.rfind(this->GetOutputExtension());
-  if (found!=std::string::npos)
-    tag_name = tag_name.substr(0, found);
-  tag_name = cmsys::SystemTools::LowerCase(tag_name);
-  std::stringstream cmd;
-  cmd << "docker build --file=\""
-      <<  output_name
-      << "\" --tag=\""
-      << tag_name
-      << "\" .";
-  std::string output;
-  int retval = -1;
-  bool res = cmSystemTools::RunSingleCommand(cmd.str().c_str(),
-                                             &output,
-                                             &output,
-                                             &retval,
-                                             this->GetOption("CPACK_PACKAGE_DIRECTORY"),
-                                             this->GeneratorVerbose,
-                                             0);
-  if (!res || retval) {
-    std::string tmpFile = this->GetOption("CPACK_PACKAGE_DIRECTORY");
-    tmpFile += "/Docker.log";
-    cmGeneratedFileStream ofs(tmpFile.c_str());
-    ofs << "# Run command: " << cmd.str() << std::endl
-        << "# Working directory: " << this->GetOption("CPACK_PACKAGE_DIRECTORY") << std::endl
-        << "# Output:" << std::endl
-        << output << std::endl;
-    cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem running docker command: "
-                  << cmd.str() << std::endl
-                  << "Please check " << tmpFile << " for errors" << std::endl);
-    return 0;
+  // Only the dockerfile and the staged GEN_WDIR are needed by the build,
+  // so send docker a tar of just those instead of CPACK_PACKAGE_DIRECTORY.
+  std::string dockerfile = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  dockerfile += "/";
+  dockerfile += this->GetOption("CPACK_OUTPUT_FILE_NAME");
+  // The context is streamed to docker when the job starts, so it is
+  // never written to disk.
+  DockerJob job;
+  job.Tag = this->getTagName();
+  job.Dockerfile = dockerfile;
+  job.LayerDirs = layerDirs;
+  job.ContextWriter = -1;
+  job.Log = this->GetOption("CPACK_PACKAGE_DIRECTORY");
+  job.Log += "/Docker-";
+  job.Log += job.Tag;
+  job.Log += ".log";
+  job.StampFile = stampfile;
+  job.Stamp = stamp;
+
+  std::vector<std::string> cmd;
+  cmd.push_back("docker");
+  cmd.push_back("build");
+  cmd.push_back("--file=" + cmSystemTools::GetFilenameName(dockerfile));
+  cmd.push_back("--tag=" + job.Tag);
+  cmd.push_back("-");
+  job.Commands.push_back(cmd);
+  if (IsOn("GEN_CPACK_DOCKER_DELETE_CONTAINER")) {
+    cmd.clear();
+    cmd.push_back("docker");
+    cmd.push_back("rmi");
+    cmd.push_back("-f");
+    cmd.push_back(job.Tag);
+    job.Commands.push_back(cmd);
   }
-  cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: created container" << std::endl);
+  dockerJobs.push_back(job);
   return 1;
 }
 
-int cmCPackDockerGenerator::deleteDockerContainer()
+std::string cmCPackDockerGenerator::getTagName()
 {
   // docker policy enforces lower case for container tags
   std::string tag_name = this->GetOption("CPACK_OUTPUT_FILE_NAME");
   std::size_t found = tag_name.rfind(this->GetOutputExtension());
   if (found!=std::string::npos)
     tag_name = tag_name.substr(0, found);
-  tag_name = cmsys::SystemTools::LowerCase(tag_name);
-  std::stringstream cmd;
-  cmd << "docker rmi -f " << tag_name;
-  std::string output;
-  int retval = -1;
-  bool res = cmSystemTools::RunSingleCommand(cmd.str().c_str(),
-                                             &output,
-                                             &output,
-                                             &retval,
-                                             this->GetOption("CPACK_PACKAGE_DIRECTORY"),
-                                             this->GeneratorVerbose,
-                                             0);
-  if (!res || retval) {
-    std::string tmpFile = this->GetOption("CPACK_PACKAGE_DIRECTORY");
-    tmpFile += "/Docker.log";
-    cmGeneratedFileStream ofs(tmpFile.c_str());
-    ofs << "# Run command: " << cmd.str() << std::endl
-        << "# Working directory: " << this->GetOption("CPACK_PACKAGE_DIRECTORY") << std::endl
-        << "# Output:" << std::endl
-        << output << std::endl;
-    cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem running docker command: "
-                  << cmd.str() << std::endl
-                  << "Please check " << tmpFile << " for errors" << std::endl);
+  return cmsys::SystemTools::LowerCase(tag_name);
+}
+
+std::string cmCPackDockerGenerator::getFingerprint(
+  const std::string &dockerfile, const std::string &stampfile,
+  std::string &stamps)
+{
+  // Hashes of files whose size and mtime did not change since the last
+  // build are reused from the stamp file instead of being recomputed.
+  // Each stamp line is "<size> <mtime> <hash> <path>".
+  std::map<std::string, std::string> previous;
+  cmsys::ifstream fin(stampfile.c_str());
+  std::string line;
+  if (fin && cmSystemTools::GetLineFromStream(fin, line)) {
+    while (cmSystemTools::GetLineFromStream(fin, line)) {
+      std::string::size_type pos = line.find(' ');
+      pos = pos == std::string::npos ? pos : line.find(' ', pos + 1);
+      pos = pos == std::string::npos ? pos : line.find(' ', pos + 1);
+      if (pos != std::string::npos) {
+        previous[line.substr(pos + 1)] = line.substr(0, pos);
+      }
+    }
+  }
+
+  cmsys::auto_ptr<cmCryptoHash> sha = cmCryptoHash::New("SHA256");
+  std::string dockerfileHash = sha->HashFile(dockerfile);
+  if (dockerfileHash.empty()) {
+    cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem reading dockerfile: "
+                  << dockerfile << std::endl);
+    return "";
+  }
+  std::ostringstream content;
+  content << this->getTagName() << "\n" << dockerfileHash << "\n";
+  std::string top_level_parent = this->GetOption("CPACK_PACKAGE_DIRECTORY");
+  std::vector<cmCPackDockerFingerprintFile> entries;
+  std::vector<std::string> changed;
+  std::vector<size_t> changedIndex;
+  for (size_t i = 0; i < layerDirs.size(); ++i) {
+    cmsys::Glob gl;
+    gl.RecurseOn();
+    gl.RecurseThroughSymlinksOff();
+    gl.FindFiles(layerDirs[i] + "/*");
+    std::vector<std::string> staged = gl.GetFiles();
+    std::sort(staged.begin(), staged.end());
+    for (std::vector<std::string>::const_iterator fi = staged.begin();
+         fi != staged.end(); ++fi) {
+      struct stat st;
+      if (lstat(fi->c_str(), &st) != 0)
+        continue;
+      cmCPackDockerFingerprintFile file;
+      file.Path = fi->substr(top_level_parent.length() + 1);
+      std::ostringstream key;
+      key << st.st_size << " " << st.st_mtime;
+      file.Key = key.str();
+      file.Mode = st.st_mode & 07777;
+      if (S_ISLNK(st.st_mode)) {
+        std::string target;
+        cmSystemTools::ReadSymlink(*fi, target);
+        file.Hash = sha->HashString(target);
+      } else {
+        std::map<std::string, std::string>::const_iterator pi =
+          previous.find(file.Path);
+        std::string::size_type klen = file.Key.length();
+        if (pi != previous.end() && pi->second.compare(0, klen, file.Key) == 0
+            && pi->second.length() > klen && pi->second[klen] == ' ') {
+          file.Hash = pi->second.substr(klen + 1);
+        } else {
+          changed.push_back(*fi);
+          changedIndex.push_back(entries.size());
+        }
+      }
+      entries.push_back(file);
+    }
+  }
+
+  // Hash the changed files of all layers together on every processor.
+  std::vector<std::string> hashes;
+  std::string error;
+  if (!cmCryptoHash::HashFiles("SHA256", changed, 0, hashes, error)) {
+    cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem hashing staged files: "
+                  << error << std::endl);
+    return "";
+  }
+  for (size_t i = 0; i < changed.size(); ++i) {
+    entries[changedIndex[i]].Hash = hashes[i];
+  }
+
+  std::ostringstream out;
+  for (std::vector<cmCPackDockerFingerprintFile>::const_iterator fi =
+         entries.begin(); fi != entries.end(); ++fi) {
+    out << fi->Key << " " << fi->Hash << " " << fi->Path << "\n";
+    content << std::oct << fi->Mode << std::dec << " "
+            << fi->Hash << " " << fi->Path << "\n";
+  }
+  stamps = out.str();
+  return sha->HashString(content.str());
+}
+
+bool cmCPackDockerGenerator::isImageUpToDate(const std::string &stampfile,
+                                             const std::string &fingerprint)
+{
+  cmsys::ifstream fin(stampfile.c_str());
+  std::string line;
+  if (!fin || !cmSystemTools::GetLineFromStream(fin, line) ||
+      line != fingerprint) {
+    return false;
+  }
+  // An image that is kept must still exist.
+  if (!IsOn("GEN_CPACK_DOCKER_DELETE_CONTAINER")) {
+    std::vector<std::string> cmd;
+    cmd.push_back("docker");
+    cmd.push_back("inspect");
+    cmd.push_back("--type=image");
+    cmd.push_back(this->getTagName());
+    int retval = -1;
+    if (!cmSystemTools::RunSingleCommand(cmd, 0, 0, &retval, 0,
+                                         cmSystemTools::OUTPUT_NONE) ||
+        retval != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool cmCPackDockerGenerator::writeBuildContext(DockerJob const& job, int fd)
+{
+  // The dockerfile goes at the root of the context and each layer
+  // directory keeps its path relative to CPACK_PACKAGE_DIRECTORY, matching
+  // the COPY sources written by getFiles().
+  std::string top_level_parent = this->GetOption("CPACK_PACKAGE_DIRECTORY");
+  cmCPackDockerPipeBuf buf(fd);
+  std::ostream os(&buf);
+  cmArchiveWrite archive(os, cmArchiveWrite::CompressNone, "paxr");
+  if (archive) {
+    archive.Add(job.Dockerfile,
+                cmSystemTools::GetFilenamePath(job.Dockerfile).length() + 1);
+  }
+  for (size_t i = 0; archive && i < job.LayerDirs.size(); ++i) {
+    archive.Add(job.LayerDirs[i], top_level_parent.length() + 1);
+  }
+  archive.Finish();
+  std::string error = archive.GetError();
+  // A closed pipe means the build failed, which it reports itself.
+  if (buf.GetError() == EPIPE) {
+    return false;
+  }
+  if (error.empty() && buf.GetError()) {
+    error = strerror(buf.GetError());
+  }
+  if (!error.empty()) {
+    std::string msg = "Problem writing docker build context for image " +
+      job.Tag + ". ERROR = " + error + "\n";
+    cmSystemTools::Stderr(msg.c_str(), msg.size());
+    return false;
+  }
+  return true;
+}
+
+bool cmCPackDockerGenerator::streamBuildContext(DockerJob &job,
+                                                cmsysProcess* cp)
+{
+  // docker reads the context from a pipe on its stdin.  A child process
+  // writes the tar into the pipe so that the output of the running builds
+  // is still read while the context is sent.
+  int fds[2];
+  if (pipe(fds) != 0) {
+    job.Output += "Cannot create a pipe for the build context: ";
+    job.Output += strerror(errno);
+    job.Output += "\n";
+    return false;
+  }
+  cmsysProcess_SetPipeNative(cp, cmsysProcess_Pipe_STDIN, fds);
+  cmsysProcess_Execute(cp);
+  // Only docker reads the pipe, and only the writer writes it.
+  close(fds[0]);
+  job.ContextWriter = -1;
+  if (cmsysProcess_GetState(cp) == cmsysProcess_State_Executing) {
+    job.ContextWriter = fork();
+    if (job.ContextWriter == 0) {
+      // A build that fails before reading all of the context closes the
+      // pipe, so report that as a write error rather than dying of it.
+      signal(SIGPIPE, SIG_IGN);
+      _exit(this->writeBuildContext(job, fds[1]) ? 0 : 1);
+    }
+    if (job.ContextWriter < 0) {
+      job.Output += "Cannot start writing the build context: ";
+      job.Output += strerror(errno);
+      job.Output += "\n";
+    }
+  }
+  close(fds[1]);
+  return true;
+}
+
+bool cmCPackDockerGenerator::waitBuildContext(DockerJob &job)
+{
+  if (job.ContextWriter < 0) {
+    return false;
+  }
+  int status;
+  while (waitpid(job.ContextWriter, &status, 0) < 0 && errno == EINTR) {
+  }
+  job.ContextWriter = -1;
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+cmsysProcess* cmCPackDockerGenerator::startDockerCommand(DockerJob &job,
+                                                         size_t step)
+{
+  std::vector<std::string> const& command = job.Commands[step];
+  std::vector<const char*> argv;
+  for (std::vector<std::string>::const_iterator a = command.begin();
+       a != command.end(); ++a) {
+    argv.push_back(a->c_str());
+  }
+  argv.push_back(0);
+  const char* wdir = this->GetOption("CPACK_PACKAGE_DIRECTORY");
+  job.Output += "# Run command: " + cmSystemTools::PrintSingleCommand(command)
+    + "\n# Working directory: " + wdir + "\n# Output:\n";
+
+  cmsysProcess* cp = cmsysProcess_New();
+  cmsysProcess_SetCommand(cp, &*argv.begin());
+  cmsysProcess_SetWorkingDirectory(cp, wdir);
+  if (step != 0) {
+    cmsysProcess_Execute(cp);
+  } else if (!this->streamBuildContext(job, cp)) {
+    cmsysProcess_Delete(cp);
+    return 0;
+  }
+  return cp;
+}
+
+bool cmCPackDockerGenerator::runDockerJobs()
+{
+  unsigned long max_jobs = 1;
+  const char* cstr = this->GetOption("CPACK_DOCKER_PARALLEL_JOBS");
+  if (cstr && *cstr &&
+      (!cmSystemTools::StringToULong(cstr, &max_jobs) || max_jobs == 0)) {
+    cmCPackLogger(cmCPackLog::LOG_WARNING, "CPackDocker: Invalid value for "
+                  "CPACK_DOCKER_PARALLEL_JOBS: " << cstr << std::endl);
+    max_jobs = 1;
+  }
+  bool verbose = max_jobs == 1 &&
+    this->GeneratorVerbose != cmSystemTools::OUTPUT_NONE;
+
+  std::vector<cmsysProcess*> procs(dockerJobs.size(), 0);
+  std::vector<size_t> steps(dockerJobs.size(), 0);
+  std::vector<bool> failed(dockerJobs.size(), false);
+  size_t next = 0;
+  size_t running = 0;
+  while (next < dockerJobs.size() || running > 0) {
+    while (running < max_jobs && next < dockerJobs.size()) {
+      cmCPackLogger(cmCPackLog::LOG_OUTPUT, "- Building docker image "
+                    << dockerJobs[next].Tag << std::endl);
+      procs[next] = this->startDockerCommand(dockerJobs[next], 0);
+      if (procs[next]) {
+        ++running;
+      } else {
+        failed[next] = true;
+        cmGeneratedFileStream ofs(dockerJobs[next].Log.c_str());
+        ofs << dockerJobs[next].Output;
+      }
+      ++next;
+    }
+    for (size_t i = 0; i < next; ++i) {
+      cmsysProcess* cp = procs[i];
+      if (!cp)
+        continue;
+      DockerJob& job = dockerJobs[i];
+      // Block on the only running build, otherwise poll each in turn.
+      double timeout = 0.1;
+      double* tp = running > 1 ? &timeout : 0;
+      char* data;
+      int length;
+      int pipe;
+      while ((pipe = cmsysProcess_WaitForData(cp, &data, &length, tp)) > 0 &&
+             pipe != cmsysProcess_Pipe_Timeout) {
+        job.Output.append(data, length);
+        if (verbose) {
+          cmSystemTools::Stdout(data, length);
+        }
+      }
+      if (pipe == cmsysProcess_Pipe_Timeout)
+        continue;
+
+      cmsysProcess_WaitForExit(cp, 0);
+      bool ok = cmsysProcess_GetState(cp) == cmsysProcess_State_Exited &&
+                cmsysProcess_GetExitValue(cp) == 0;
+      if (cmsysProcess_GetState(cp) == cmsysProcess_State_Error) {
+        job.Output += cmsysProcess_GetErrorString(cp);
+      }
+      job.Output += "\n";
+      cmsysProcess_Delete(cp);
+      procs[i] = 0;
+      // The writer is done once the build has read the whole context.
+      if (steps[i] == 0 && !this->waitBuildContext(job) && ok) {
+        job.Output += "Problem writing the docker build context\n";
+        ok = false;
+      }
+      if (ok && ++steps[i] < job.Commands.size()) {
+        procs[i] = this->startDockerCommand(job, steps[i]);
+        continue;
+      }
+      --running;
+      if (ok) {
+        cmGeneratedFileStream out(job.StampFile.c_str());
+        out << job.Stamp;
+        cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: built image "
+                      << job.Tag << std::endl);
+      } else {
+        failed[i] = true;
+        cmGeneratedFileStream ofs(job.Log.c_str());
+        ofs << job.Output;
+      }
+    }
+  }
+
+  // Report failures in packaging order, whatever order they finished in.
+  bool res = true;
+  for (size_t i = 0; i < dockerJobs.size(); ++i) {
+    if (failed[i]) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem running docker command "
+                    "for image " << dockerJobs[i].Tag << std::endl
+                    << "Please check " << dockerJobs[i].Log << " for errors"
+                    << std::endl);
+      res = false;
+    }
+  }
+  dockerJobs.clear();
+  return res;
+}
+
+int cmCPackDockerGenerator::createOCIImage()
+{
+  std::string imagename = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  imagename += "/";
+  imagename += this->GetOption("CPACK_OUTPUT_FILE_NAME");
+  std::string layout = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  layout += "/";
+  layout += this->getTagName();
+  layout += ".oci";
+
+  // Without a daemon nothing can be run inside the image, so it only
+  // contains the staged files on top of an empty base.
+  const char* ignored[] = {
+    "GEN_CPACK_DOCKER_PACKAGE_DEPENDS",
+    "GEN_CPACK_DOCKER_RUN_PREDEPENDS",
+    "GEN_CPACK_DOCKER_RUN_POSTDEPENDS",
+    "GEN_CPACK_DOCKER_ONBUILD",
+    "GEN_CPACK_DOCKER_BUILD_CONTAINER"
+  };
+  for (size_t i = 0; i < sizeof(ignored) / sizeof(ignored[0]); ++i) {
+    const char* cstr = this->GetOption(ignored[i]);
+    if (cstr && *cstr && !cmSystemTools::IsOff(cstr)) {
+      cmCPackLogger(cmCPackLog::LOG_WARNING, "CPackDocker: "
+                    << (ignored[i] + 4) << " is ignored for OCI images"
+                    << std::endl);
+    }
+  }
+
+  cmSystemTools::RemoveADirectory(layout);
+  if (!cmSystemTools::MakeDirectory((layout + "/blobs/sha256").c_str())) {
+    cmCPackLogger(cmCPackLog::LOG_ERROR, "CPackDocker: Cannot create directory "
+                  << layout << std::endl);
+    return 0;
+  }
+
+  if (!this->partitionLayers() || !this->prepareRuntimeLibraries())
+    return 0;
+  if (!runtimePackages.empty()) {
+    cmCPackLogger(cmCPackLog::LOG_WARNING, "CPackDocker: "
+                  "CPACK_DOCKER_RUNTIME_LIBRARIES PACKAGES is ignored for OCI "
+                  "images, use COPY instead" << std::endl);
+  }
+  std::vector<std::string> layer_digests;
+  std::vector<unsigned long> layer_sizes;
+  for (size_t i = 0; i < layerDirs.size(); ++i) {
+    std::string digest;
+    unsigned long size = 0;
+    if (!this->writeOCILayer(layout, layerDirs[i], digest, size))
+      return 0;
+    layer_digests.push_back(digest);
+    layer_sizes.push_back(size);
+  }
+  std::string config = this->getOCIConfig(layer_digests);
+  std::string config_digest;
+  if (!this->writeOCIBlob(layout, config, config_digest))
+    return 0;
+
+  Json::Value manifest(Json::objectValue);
+  manifest["schemaVersion"] = 2;
+  manifest["mediaType"] = "application/vnd.oci.image.manifest.v1+json";
+  manifest["config"]["mediaType"] = "application/vnd.oci.image.config.v1+json";
+  manifest["config"]["digest"] = config_digest;
+  manifest["config"]["size"] = static_cast<Json::UInt64>(config.size());
+  for (size_t i = 0; i < layer_digests.size(); ++i) {
+    Json::Value& layer = manifest["layers"].append(Json::objectValue);
+    layer["mediaType"] = "application/vnd.oci.image.layer.v1.tar";
+    layer["digest"] = layer_digests[i];
+    layer["size"] = static_cast<Json::UInt64>(layer_sizes[i]);
+  }
+  std::string manifest_str = Json::FastWriter().write(manifest);
+  std::string manifest_digest;
+  if (!this->writeOCIBlob(layout, manifest_str, manifest_digest))
     return 0;
+
+  std::string repo_tag = this->getRepoTag();
+  Json::Value index(Json::objectValue);
+  index["schemaVersion"] = 2;
+  Json::Value& entry = index["manifests"].append(Json::objectValue);
+  entry["mediaType"] = "application/vnd.oci.image.manifest.v1+json";
+  entry["digest"] = manifest_digest;
+  entry["size"] = static_cast<Json::UInt64>(manifest_str.size());
+  entry["annotations"]["org.opencontainers.image.ref.name"] =
+    repo_tag.substr(repo_tag.rfind(':') + 1);
+  entry["annotations"]["io.containerd.image.name"] = repo_tag;
+
+  // manifest.json lets `docker load` read the same archive.
+  Json::Value load(Json::arrayValue);
+  Json::Value& image = load.append(Json::objectValue);
+  image["Config"] = "blobs/sha256/" + config_digest.substr(7);
+  image["RepoTags"].append(repo_tag);
+  for (size_t i = 0; i < layer_digests.size(); ++i) {
+    image["Layers"].append("blobs/sha256/" + layer_digests[i].substr(7));
   }
-  cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: deleted container" << std::endl);
+
+  {
+    cmGeneratedFileStream out((layout + "/index.json").c_str());
+    out << Json::FastWriter().write(index);
+  }
+  {
+    cmGeneratedFileStream out((layout + "/manifest.json").c_str());
+    out << Json::FastWriter().write(load);
+  }
+  {
+    cmGeneratedFileStream out((layout + "/oci-layout").c_str());
+    out << "{\"imageLayoutVersion\":\"1.0.0\"}" << std::endl;
+  }
+
+  {
+    cmsys::ofstream fout(imagename.c_str(), std::ios::out | std::ios::binary);
+    cmArchiveWrite archive(fout, cmArchiveWrite::CompressNone, "paxr");
+    cmCPackDockerNormalizeArchive(archive);
+    if (archive) {
+      archive.Add(layout, layout.length() + 1);
+    }
+    if (!archive.Finish()) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem creating OCI image <"
+                    << imagename << ">. ERROR = " << archive.GetError()
+                    << std::endl);
+      return 0;
+    }
+    if (!fout) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem writing OCI image <"
+                    << imagename << ">" << std::endl);
+      return 0;
+    }
+  }
+  cmSystemTools::RemoveADirectory(layout);
+  cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: created OCI image "
+                << manifest_digest << std::endl);
   return 1;
 }
 
+bool cmCPackDockerGenerator::writeOCILayer(const std::string &layout,
+                                           const std::string &dir,
+                                           std::string &digest,
+                                           unsigned long &size)
+{
+  // The staged files land where the Dockerfile would COPY them.
+  std::string prefix;
+  const char* workdir = this->GetOption("GEN_CPACK_DOCKER_WORKDIR");
+  if (workdir && *workdir && dir != runtimeDir) {
+    prefix = workdir;
+    prefix.erase(0, prefix.find_first_not_of('/'));
+    if (!prefix.empty() && prefix[prefix.size()-1] != '/')
+      prefix += "/";
+  }
+  std::string tmp = layout + "/layer.tar";
+  {
+    cmsys::ofstream fout(tmp.c_str(), std::ios::out | std::ios::binary);
+    cmCPackDockerDigestBuf buf(fout);
+    std::ostream out(&buf);
+    {
+      cmArchiveWrite archive(out, cmArchiveWrite::CompressNone, "paxr");
+      cmCPackDockerNormalizeArchive(archive);
+      if (archive) {
+        archive.Add(dir, dir.length() + 1, prefix.c_str());
+      }
+      if (!archive.Finish()) {
+        cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem creating OCI layer <"
+                      << tmp << ">. ERROR = " << archive.GetError()
+                      << std::endl);
+        return false;
+      }
+    }
+    if (!fout) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem writing OCI layer <"
+                    << tmp << ">" << std::endl);
+      return false;
+    }
+    // An uncompressed layer has the same digest and diff_id.
+    digest = buf.GetDigest();
+    size = buf.GetSize();
+  }
+  std::string blob = layout + "/blobs/sha256/" + digest.substr(7);
+  return cmSystemTools::RenameFile(tmp.c_str(), blob.c_str());
+}
+
+bool cmCPackDockerGenerator::writeOCIBlob(const std::string &layout,
+                                          const std::string &content,
+                                          std::string &digest)
+{
+  digest = "sha256:";
+  digest += cmCryptoHash::New("SHA256")->HashString(content);
+  std::string blob = layout + "/blobs/sha256/" + digest.substr(7);
+  cmsys::ofstream fout(blob.c_str(), std::ios::out | std::ios::binary);
+  if (!fout) {
+    cmCPackLogger(cmCPackLog::LOG_ERROR, "Cannot open OCI blob <"
+                  << blob << "> for writing" << std::endl);
+    return false;
+  }
+  fout.write(content.c_str(), static_cast<std::streamsize>(content.size()));
+  fout.close();
+  if (!fout) {
+    cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem writing OCI blob <"
+                  << blob << ">" << std::endl);
+    return false;
+  }
+  return true;
+}
+
+std::string cmCPackDockerGenerator::getOCIConfig(
+  const std::vector<std::string> &diffIds)
+{
+  Json::Value root(Json::objectValue);
+  root["created"] = CPACK_DOCKER_OCI_CREATED;
+  root["architecture"] =
+    this->GetOption("GEN_CPACK_DOCKER_IMAGE_ARCHITECTURE");
+  root["os"] = "linux";
+  const char* maintainer = this->GetOption("GEN_CPACK_DOCKER_MAINTAINER");
+  if (maintainer && *maintainer) {
+    root["author"] = maintainer;
+  }
+
+  Json::Value& config = root["config"] = Json::objectValue;
+  std::vector<std::string> values;
+  const char* cstr = this->GetOption("GEN_CPACK_DOCKER_ENV");
+  if (cstr && *cstr) {
+    cmSystemTools::ExpandListArgument(std::string(cstr), values);
+    for (size_t i = 0; i < values.size(); ++i) {
+      config["Env"].append(values[i]);
+    }
+  }
+  if (!runtimeLibraryPath.empty()) {
+    config["Env"].append("LD_LIBRARY_PATH=" + runtimeLibraryPath);
+  }
+  const char* labels[][2] = {
+    { "name", "GEN_CPACK_DOCKER_CONTAINER_NAME" },
+    { "version", "GEN_CPACK_DOCKER_CONTAINER_VERSION" },
+    { "description", "GEN_CPACK_DOCKER_CONTAINER_DESCRIPTION" },
+    { "website", "GEN_CPACK_DOCKER_CONTAINER_HOMEPAGE" }
+  };
+  for (size_t i = 0; i < sizeof(labels) / sizeof(labels[0]); ++i) {
+    cstr = this->GetOption(labels[i][1]);
+    if (cstr && *cstr) {
+      config["Labels"][labels[i][0]] = cstr;
+    }
+  }
+  cstr = this->GetOption("GEN_CPACK_DOCKER_LABEL");
+  if (cstr && *cstr) {
+    values.clear();
+    cmSystemTools::ExpandListArgument(std::string(cstr), values);
+    for (size_t i = 0; i < values.size(); ++i) {
+      std::string::size_type eq = values[i].find('=');
+      if (eq == std::string::npos) {
+        config["Labels"][values[i]] = "";
+      } else {
+        config["Labels"][values[i].substr(0, eq)] = values[i].substr(eq + 1);
+      }
+    }
+  }
+  cstr = this->GetOption("GEN_CPACK_DOCKER_EXPOSE");
+  if (cstr && *cstr) {
+    values.clear();
+    cmSystemTools::ExpandListArgument(std::string(cstr), values);
+    for (size_t i = 0; i < values.size(); ++i) {
+      std::string port = values[i];
+      if (port.find('/') == std::string::npos)
+        port += "/tcp";
+      config["ExposedPorts"][port] = Json::objectValue;
+    }
+  }
+  cstr = this->GetOption("GEN_CPACK_DOCKER_VOLUME");
+  if (cstr && *cstr) {
+    values.clear();
+    cmSystemTools::ExpandListArgument(std::string(cstr), values);
+    for (size_t i = 0; i < values.size(); ++i) {
+      config["Volumes"][values[i]] = Json::objectValue;
+    }
+  }
+  cstr = this->GetOption("GEN_CPACK_DOCKER_ENTRYPOINT");
+  if (cstr && *cstr) {
+    values.clear();
+    cmSystemTools::ExpandListArgument(std::string(cstr), values);
+    for (size_t i = 0; i < values.size(); ++i) {
+      config["Entrypoint"].append(values[i]);
+    }
+  }
+  cstr = this->GetOption("GEN_CPACK_DOCKER_CMD");
+  if (cstr && *cstr) {
+    values.clear();
+    cmSystemTools::ExpandListArgument(std::string(cstr), values);
+    for (size_t i = 0; i < values.size(); ++i) {
+      config["Cmd"].append(values[i]);
+    }
+  }
+  cstr = this->GetOption("GEN_CPACK_DOCKER_WORKDIR");
+  if (cstr && *cstr) {
+    config["WorkingDir"] = cstr;
+  }
+  cstr = this->GetOption("GEN_CPACK_DOCKER_USER");
+  if (cstr && *cstr) {
+    config["User"] = cstr;
+  }
+
+  root["rootfs"]["type"] = "layers";
+  for (size_t i = 0; i < diffIds.size(); ++i) {
+    root["rootfs"]["diff_ids"].append(diffIds[i]);
+    Json::Value& history = root["history"].append(Json::objectValue);
+    history["created"] = CPACK_DOCKER_OCI_CREATED;
+    history["created_by"] = "CPack";
+  }
+  return Json::FastWriter().write(root);
+}
+
+std::string cmCPackDockerGenerator::getRepoTag()
+{
+  // docker policy enforces lower case for repository names
+  std::string name = cmsys::SystemTools::LowerCase(
+    this->GetOption("GEN_CPACK_DOCKER_CONTAINER_NAME"));
+  const char* version = this->GetOption("GEN_CPACK_DOCKER_CONTAINER_VERSION");
+  name += ":";
+  name += (version && *version) ? version : "latest";
+  return name;
+}
+
 std::string cmCPackDockerGenerator::getLabels()
 {
   // Add all labels in one command to minimize docker layers
@@ -449,17 +1285,365 @@ std::string cmCPackDockerGenerator::getCustomLabel(const std::string &input)
   }
 }
 
+bool cmCPackDockerGenerator::partitionLayers()
+{
+  std::string wdir = this->GetOption("GEN_WDIR");
+  layerDirs.clear();
+  const char* cstr = this->GetOption("CPACK_DOCKER_LAYERS");
+  if (!cstr || !*cstr) {
+    layerDirs.push_back(wdir);
+    return true;
+  }
+  std::vector<std::string> names;
+  cmSystemTools::ExpandListArgument(std::string(cstr), names);
+
+  // Files matching a layer's patterns, or living under a directory that
+  // does, are linked from GEN_WDIR into a directory of their own.
+  std::vector<cmsys::RegularExpression> regexes;
+  std::vector<size_t> regex_layer;
+  for (size_t i = 0; i < names.size(); ++i) {
+    std::string var = "CPACK_DOCKER_LAYER_" + cmSystemTools::UpperCase(names[i]);
+    const char* patterns = this->GetOption(var);
+    if (!patterns || !*patterns) {
+      cmCPackLogger(cmCPackLog::LOG_WARNING, "CPackDocker: " << var
+                    << " is not set, layer " << names[i] << " is empty"
+                    << std::endl);
+      continue;
+    }
+    std::vector<std::string> globs;
+    cmSystemTools::ExpandListArgument(std::string(patterns), globs);
+    for (size_t j = 0; j < globs.size(); ++j) {
+      std::string glob = globs[j];
+      glob.erase(0, glob.find_first_not_of('/'));
+      regexes.push_back(cmsys::RegularExpression(
+        cmsys::Glob::PatternToRegex(glob, true, true).c_str()));
+      regex_layer.push_back(i);
+    }
+  }
+
+  std::string root = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  root += "/";
+  root += this->getTagName();
+  root += ".layers";
+  cmSystemTools::RemoveADirectory(root);
+  // The files not claimed by a layer go to the last one.
+  std::vector<std::string> dirs(names.size() + 1);
+  for (size_t i = 0; i < names.size(); ++i) {
+    std::ostringstream dir;
+    dir << root << "/" << i << "-" << cmSystemTools::LowerCase(names[i]);
+    dirs[i] = dir.str();
+  }
+  std::ostringstream rest;
+  rest << root << "/" << names.size() << "-files";
+  dirs[names.size()] = rest.str();
+
+  cmsys::Glob gl;
+  gl.RecurseOn();
+  gl.RecurseThroughSymlinksOff();
+  gl.SetRecurseListDirs(true);
+  gl.FindFiles(wdir + "/*");
+  std::vector<std::string> const& staged = gl.GetFiles();
+  std::vector<bool> used(names.size() + 1, false);
+  cmSystemTools::MakeDirectory(dirs[names.size()].c_str());
+  used[names.size()] = true;
+  for (std::vector<std::string>::const_iterator fi = staged.begin();
+       fi != staged.end(); ++fi) {
+    std::string rel = fi->substr(wdir.length() + 1);
+    if (cmSystemTools::FileIsDirectory(*fi) &&
+        !cmSystemTools::FileIsSymlink(*fi)) {
+      // Directories stay in the last layer, as do empty ones.
+      cmSystemTools::MakeDirectory((dirs[names.size()] + "/" + rel).c_str());
+      continue;
+    }
+    size_t layer = names.size();
+    for (size_t r = 0; r < regexes.size() && layer == names.size(); ++r) {
+      for (std::string path = rel; !path.empty();
+           path = cmSystemTools::GetFilenamePath(path)) {
+        if (regexes[r].find(path)) {
+          layer = regex_layer[r];
+          break;
+        }
+      }
+    }
+    // Link the files rather than move them so that the staged tree stays
+    // as installed for the next run.
+    std::string dest = dirs[layer] + "/" + rel;
+    cmSystemTools::MakeDirectory(cmSystemTools::GetFilenamePath(dest).c_str());
+    bool linked;
+    if (cmSystemTools::FileIsSymlink(*fi)) {
+      std::string target;
+      linked = cmSystemTools::ReadSymlink(*fi, target) &&
+        cmSystemTools::CreateSymlink(target, dest);
+    } else {
+      linked = cmSystemTools::CreateLink(*fi, dest) ||
+        cmSystemTools::CopyAFile(*fi, dest);
+    }
+    if (!linked) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "CPackDocker: Cannot link "
+                    << *fi << " into layer " << dirs[layer] << std::endl);
+      return false;
+    }
+    used[layer] = true;
+  }
+  for (size_t i = 0; i < dirs.size(); ++i) {
+    if (used[i]) {
+      layerDirs.push_back(dirs[i]);
+    }
+  }
+  return true;
+}
+
+bool cmCPackDockerGenerator::prepareRuntimeLibraries()
+{
+  runtimeDir.clear();
+  runtimeLibraryPath.clear();
+  runtimePackages.clear();
+  const char* cstr = this->GetOption("CPACK_DOCKER_RUNTIME_LIBRARIES");
+  if (!cstr || !*cstr || cmSystemTools::IsOff(cstr))
+    return true;
+  std::string mode = cmSystemTools::UpperCase(cstr);
+  if (mode != "COPY" && mode != "PACKAGES") {
+    cmCPackLogger(cmCPackLog::LOG_ERROR, "CPackDocker: Unknown "
+                  "CPACK_DOCKER_RUNTIME_LIBRARIES value " << cstr
+                  << ", expected COPY or PACKAGES" << std::endl);
+    return false;
+  }
+#if defined(CMAKE_USE_ELF_PARSER)
+  std::vector<std::string> libs;
+  std::vector<std::string> systemDirs;
+  if (!this->resolveRuntimeLibraries(libs, systemDirs))
+    return false;
+  cmCPackLogger(cmCPackLog::LOG_VERBOSE, "CPackDocker: " << libs.size()
+                << " runtime libraries needed" << std::endl);
+  if (mode == "PACKAGES")
+    return this->getRuntimePackages(libs);
+  // Only the standard directories are searched by a loader without
+  // ld.so.cache, which a minimal image does not have.
+  for (size_t i = 0; i < systemDirs.size(); ++i) {
+    if (systemDirs[i] == "/lib" || systemDirs[i] == "/usr/lib" ||
+        systemDirs[i] == "/lib64" || systemDirs[i] == "/usr/lib64")
+      continue;
+    if (!runtimeLibraryPath.empty())
+      runtimeLibraryPath += ":";
+    runtimeLibraryPath += systemDirs[i];
+  }
+  return this->copyRuntimeLibraries(libs);
+#else
+  cmCPackLogger(cmCPackLog::LOG_WARNING, "CPackDocker: "
+                "CPACK_DOCKER_RUNTIME_LIBRARIES needs ELF support, which "
+                "this CPack lacks" << std::endl);
+  return true;
+#endif
+}
+
+bool cmCPackDockerGenerator::resolveRuntimeLibraries(
+  std::vector<std::string> &libs, std::vector<std::string> &systemDirs)
+{
+#if defined(CMAKE_USE_ELF_PARSER)
+  std::vector<std::string> defaults;
+  cmCPackDockerReadLdSoConf("/etc/ld.so.conf", defaults, 0);
+  const char* standard[] = { "/lib64", "/usr/lib64", "/lib", "/usr/lib" };
+  defaults.insert(defaults.end(), standard,
+                  standard + sizeof(standard) / sizeof(standard[0]));
+
+  // Libraries shipped by the package itself need not come from the host.
+  std::set<std::string> provided;
+  std::deque<std::string> pending;
+  for (size_t i = 0; i < layerDirs.size(); ++i) {
+    cmsys::Glob gl;
+    gl.RecurseOn();
+    gl.RecurseThroughSymlinksOff();
+    gl.FindFiles(layerDirs[i] + "/*");
+    std::vector<std::string> staged = gl.GetFiles();
+    std::sort(staged.begin(), staged.end());
+    for (std::vector<std::string>::const_iterator fi = staged.begin();
+         fi != staged.end(); ++fi) {
+      provided.insert(cmSystemTools::GetFilenameName(*fi));
+      if (cmSystemTools::FileIsSymlink(*fi))
+        continue;
+      cmELF elf(fi->c_str());
+      std::string soname;
+      if (elf.GetSOName(soname))
+        provided.insert(soname);
+      if (elf.GetFileType() == cmELF::FileTypeExecutable ||
+          elf.GetFileType() == cmELF::FileTypeSharedLibrary)
+        pending.push_back(*fi);
+    }
+  }
+
+  std::set<std::string> seen;
+  std::set<std::string> usedDirs;
+  while (!pending.empty()) {
+    std::string file = pending.front();
+    pending.pop_front();
+    cmELF elf(file.c_str());
+    std::string target = cmCPackDockerELFTarget(elf);
+    std::string interp;
+    if (elf.GetInterpreter(interp) && seen.insert(interp).second) {
+      if (cmSystemTools::FileExists(interp.c_str(), true)) {
+        libs.push_back(interp);
+      } else {
+        cmCPackLogger(cmCPackLog::LOG_WARNING, "CPackDocker: Cannot find "
+                      "interpreter " << interp << " of " << file << std::endl);
+      }
+    }
+    std::vector<std::string> needed;
+    if (!elf.GetNeeded(needed) || needed.empty())
+      continue;
+
+    // Search in the order of the dynamic loader: RPATH unless a RUNPATH
+    // is present, RUNPATH, then the system directories.
+    std::string origin = cmSystemTools::GetFilenamePath(file);
+    std::vector<std::string> dirs;
+    cmELF::StringEntry const* runpath = elf.GetRunPath();
+    if (!runpath)
+      cmCPackDockerExpandRPath(elf.GetRPath(), origin, dirs);
+    cmCPackDockerExpandRPath(runpath, origin, dirs);
+    size_t rpaths = dirs.size();
+    dirs.insert(dirs.end(), defaults.begin(), defaults.end());
+    for (size_t n = 0; n < needed.size(); ++n) {
+      if (provided.count(needed[n]))
+        continue;
+      std::string found;
+      size_t d = 0;
+      for (; d < dirs.size(); ++d) {
+        std::string path = dirs[d] + "/" + needed[n];
+        if (!cmSystemTools::FileExists(path.c_str(), true))
+          continue;
+        cmELF lib(path.c_str());
+        if (lib.GetFileType() == cmELF::FileTypeSharedLibrary &&
+            cmCPackDockerELFTarget(lib) == target) {
+          found = path;
+          break;
+        }
+      }
+      if (found.empty()) {
+        cmCPackLogger(cmCPackLog::LOG_WARNING, "CPackDocker: Cannot find "
+                      << needed[n] << " needed by " << file << std::endl);
+        continue;
+      }
+      if (d >= rpaths && usedDirs.insert(dirs[d]).second)
+        systemDirs.push_back(dirs[d]);
+      if (seen.insert(found).second) {
+        libs.push_back(found);
+        pending.push_back(found);
+      }
+    }
+  }
+  return true;
+#else
+  (void)libs;
+  (void)systemDirs;
+  return false;
+#endif
+}
+
+bool cmCPackDockerGenerator::copyRuntimeLibraries(
+  const std::vector<std::string> &libs)
+{
+  // The libraries keep their host paths and form the first layer, as
+  // they change less often than anything staged.
+  runtimeDir = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  runtimeDir += "/";
+  runtimeDir += this->getTagName();
+  runtimeDir += ".runtime";
+  cmSystemTools::RemoveADirectory(runtimeDir);
+  if (libs.empty()) {
+    runtimeDir.clear();
+    return true;
+  }
+  // A library reached through several names is copied once and linked.
+  std::map<std::string, std::string> copied;
+  for (size_t i = 0; i < libs.size(); ++i) {
+    std::string dest = runtimeDir + libs[i];
+    cmSystemTools::MakeDirectory(cmSystemTools::GetFilenamePath(dest).c_str());
+    std::string real = cmSystemTools::GetRealPath(libs[i]);
+    std::map<std::string, std::string>::const_iterator ci = copied.find(real);
+    bool ok;
+    if (ci != copied.end()) {
+      ok = cmSystemTools::CreateSymlink(ci->second, dest);
+    } else {
+      ok = cmSystemTools::CopyFileAlways(real, dest) &&
+        cmSystemTools::CopyFileTime(real.c_str(), dest.c_str());
+      copied[real] = libs[i];
+    }
+    if (!ok) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "CPackDocker: Cannot copy "
+                    "runtime library " << libs[i] << std::endl);
+      return false;
+    }
+    cmCPackLogger(cmCPackLog::LOG_DEBUG, "CPackDocker: runtime library "
+                  << libs[i] << std::endl);
+  }
+  layerDirs.insert(layerDirs.begin(), runtimeDir);
+  return true;
+}
+
+bool cmCPackDockerGenerator::getRuntimePackages(
+  const std::vector<std::string> &libs)
+{
+  // Ask the host package database which packages own the libraries.
+  std::vector<std::string> query;
+  if (!cmSystemTools::FindProgram("dpkg-query").empty()) {
+    query.push_back("dpkg-query");
+    query.push_back("--search");
+  } else if (!cmSystemTools::FindProgram("rpm").empty()) {
+    query.push_back("rpm");
+    query.push_back("--query");
+    query.push_back("--queryformat=%{NAME}\\n");
+    query.push_back("--file");
+  } else if (!cmSystemTools::FindProgram("pacman").empty()) {
+    query.push_back("pacman");
+    query.push_back("-Qqo");
+  } else {
+    cmCPackLogger(cmCPackLog::LOG_ERROR, "CPackDocker: Cannot find dpkg, "
+                  "rpm or pacman to map runtime libraries to packages"
+                  << std::endl);
+    return false;
+  }
+  std::set<std::string> packages;
+  for (size_t i = 0; i < libs.size(); ++i) {
+    // Symlinks made by ldconfig belong to no package, their targets do.
+    std::vector<std::string> paths;
+    paths.push_back(libs[i]);
+    paths.push_back(cmSystemTools::GetRealPath(libs[i]));
+    std::string package;
+    for (size_t p = 0; p < paths.size() && package.empty(); ++p) {
+      std::vector<std::string> cmd = query;
+      cmd.push_back(paths[p]);
+      std::string output;
+      int retval = -1;
+      if (!cmSystemTools::RunSingleCommand(cmd, &output, 0, &retval, 0,
+                                           cmSystemTools::OUTPUT_NONE) ||
+          retval != 0) {
+        continue;
+      }
+      // dpkg prints "package[:arch]: path", the others just the name.
+      package = output.substr(0, output.find_first_of(":,\n"));
+      package = cmSystemTools::TrimWhitespace(package);
+    }
+    if (package.empty()) {
+      cmCPackLogger(cmCPackLog::LOG_WARNING, "CPackDocker: Cannot find the "
+                    "package providing " << libs[i] << std::endl);
+    } else if (packages.insert(package).second) {
+      runtimePackages.push_back(package);
+    }
+  }
+  return true;
+}
+
 std::string cmCPackDockerGenerator::getFiles()
 {
   std::stringstream output;
-  std::string absolute_dir = this->GetOption("GEN_WDIR");
   std::string top_level_parent = this->GetOption("CPACK_PACKAGE_DIRECTORY");
-  std::string relative_dir = absolute_dir.substr(top_level_parent.length()+1, absolute_dir.length());
   const char* cstr = this->GetOption("GEN_CPACK_DOCKER_WORKDIR");
-  if(cstr && *cstr) {
-    output << "COPY [ \"" << relative_dir << "\" , \"" << cstr << "\" ]" << std::endl;
-  } else {
-    output << "COPY [ \"" << relative_dir << "\" , \"/\" ]" << std::endl;
+  for (size_t i = 0; i < layerDirs.size(); ++i) {
+    std::string relative_dir = layerDirs[i].substr(top_level_parent.length()+1);
+    if(cstr && *cstr && layerDirs[i] != runtimeDir) {
+      output << "COPY [ \"" << relative_dir << "\" , \"" << cstr << "\" ]" << std::endl;
+    } else {
+      output << "COPY [ \"" << relative_dir << "\" , \"/\" ]" << std::endl;
+    }
   }
   return output.str();
 }
@@ -522,9 +1706,11 @@ std::string cmCPackDockerGenerator::getEnv()
         output << " \\ \n    " << seglist[0] << "=\"" << seglist[1] << "\"";
     }
     output << std::endl;
-    return output.str();
   }
-  return std::string();
+  if (!runtimeLibraryPath.empty()) {
+    output << "ENV LD_LIBRARY_PATH=\"" << runtimeLibraryPath << "\"" << std::endl;
+  }
+  return output.str();
 }
 
 std::string cmCPackDockerGenerator::getUser()
@@ -665,9 +1851,20 @@ std::string cmCPackDockerGenerator::getPackageManagerInstall(const std::string &
 std::string cmCPackDockerGenerator::getDependencies(const std::string &packagemanager)
 {
   const char* depend_cstr = this->GetOption("GEN_CPACK_DOCKER_PACKAGE_DEPENDS");
+  std::vector<std::string> dependencies;
   if(depend_cstr && *depend_cstr) {
-    std::vector<std::string> dependencies;
     cmSystemTools::ExpandListArgument(std::string(depend_cstr), dependencies);
+  }
+  // Packages providing the runtime libraries, unless already listed.
+  std::set<std::string> listed;
+  for (size_t i = 0; i < dependencies.size(); ++i) {
+    listed.insert(dependencies[i].substr(0, dependencies[i].find('=')));
+  }
+  for (size_t i = 0; i < runtimePackages.size(); ++i) {
+    if (listed.insert(runtimePackages[i]).second)
+      dependencies.push_back(runtimePackages[i]);
+  }
+  if(!dependencies.empty()) {
     std::sort(dependencies.begin(), dependencies.end());
     std::stringstream output;
     output << "# Installing Dependencies\n";
@@ -16,6 +16,10 @@
 
 #include "cmCPackGenerator.h"
 
+#include <cmsys/Process.h>
+
+#include <sys/types.h> // pid_t
+
 /** \class cmCPackDockerGenerator
  * \brief A generator for Docker packages
  *
@@ -33,18 +37,9 @@ public:
 
   static bool CanGenerate()
     {
-#ifdef __APPLE__
-    // on MacOS enable CPackDocker if docker is found
-    std::vector<std::string> locations;
-    locations.push_back("/sw/bin");        // Fink
-    locations.push_back("/opt/local/bin"); // MacPorts
-    return cmSystemTools::FindProgram("docker",locations) != "" ? true : false;
-#else
-    std::vector<std::string> locations;
-    locations.push_back("/usr/bin");
-    locations.push_back("/usr/local/bin");
-    return cmSystemTools::FindProgram("docker",locations) != "" ? true : false;
-#endif
+    // docker itself is only needed to build the images from the
+    // dockerfiles, OCI images are written without it.
+    return true;
     }
 protected:
   virtual int InitializeInternal();
@@ -64,17 +59,57 @@ protected:
    */
   int PackageComponentsAllInOne();
   virtual int PackageFiles();
-  virtual const char* GetOutputExtension() { return ".dockerfile"; }
+  virtual const char* GetOutputExtension();
   virtual bool SupportsComponentInstallation() const;
   virtual std::string GetComponentInstallDirNameSuffix(
       const std::string& componentName);
 
 private:
+  bool isOCIImage() const;
   int createDocker();
-  int buildDockerContainer();
-  int deleteDockerContainer();
+  int createOCIImage();
+  bool writeOCILayer(const std::string &layout, const std::string &dir,
+                     std::string &digest, unsigned long &size);
+  bool writeOCIBlob(const std::string &layout, const std::string &content,
+                    std::string &digest);
+  std::string getOCIConfig(const std::vector<std::string> &diffIds);
+  std::string getRepoTag();
+  int buildDockerContainer(const std::string &stampfile,
+                           const std::string &stamp);
+  std::string getTagName();
+  std::string getFingerprint(const std::string &dockerfile,
+                             const std::string &stampfile,
+                             std::string &stamps);
+  bool isImageUpToDate(const std::string &stampfile,
+                       const std::string &fingerprint);
+
+  // The docker commands of one pack, run after all packs are generated.
+  struct DockerJob
+  {
+    std::string Tag;
+    std::string Dockerfile;
+    std::vector<std::string> LayerDirs;
+    // The process writing the build context to the stdin of the build.
+    pid_t ContextWriter;
+    std::string Log;
+    std::string StampFile;
+    std::string Stamp;
+    std::string Output;
+    std::vector<std::vector<std::string> > Commands;
+  };
+  bool writeBuildContext(DockerJob const& job, int fd);
+  bool streamBuildContext(DockerJob &job, cmsysProcess* cp);
+  bool waitBuildContext(DockerJob &job);
+  cmsysProcess* startDockerCommand(DockerJob &job, size_t step);
+  bool runDockerJobs();
   std::string getLabels();
   std::string getCustomLabel(const std::string &input);
+  bool partitionLayers();
+  bool prepareRuntimeLibraries();
+  bool resolveRuntimeLibraries(std::vector<std::string> &libs,
+                               std::vector<std::string> &systemDirs);
+  bool copyRuntimeLibraries(const std::vector<std::string> &libs);
+  bool getRuntimePackages(const std::vector<std::string> &libs);
   std::string getFiles();
   std::string getVolume();
   std::string getExpose();
@@ -92,6 +127,14 @@ private:
   std::string getOnbuild();
 
   std::vector<std::string> packageFiles;
+  // Directories copied into the image, one layer each, in order.
+  std::vector<std::string> layerDirs;
+  // Host libraries needed by the staged ELF files, see
+  // CPACK_DOCKER_RUNTIME_LIBRARIES.
+  std::string runtimeDir;
+  std::string runtimeLibraryPath;
+  std::vector<std::string> runtimePackages;
+  std::vector<DockerJob> dockerJobs;
 
 };
 
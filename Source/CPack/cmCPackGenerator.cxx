@@ -22,8 +22,10 @@
 #include "cmXMLSafe.h"
 
 #include <cmsys/SystemTools.hxx>
+#include <cmsys/Directory.hxx>
 #include <cmsys/Glob.hxx>
 #include <cmsys/FStream.hxx>
+#include <cmsys/Process.h>
 #include <algorithm>
 #include <list>
 
@@ -39,6 +41,7 @@ cmCPackGenerator::cmCPackGenerator()
   this->MakefileMap = 0;
   this->Logger = 0;
   this->componentPackageMethod = ONE_PACKAGE_PER_GROUP;
+  this->IncrementalInstall = false;
 }
 
 //----------------------------------------------------------------------
@@ -54,6 +57,25 @@ void cmCPackGeneratorProgress(const char *msg, float prog, void* ptr)
   self->DisplayVerboseOutput(msg, prog);
 }
 
+//----------------------------------------------------------------------
+static std::vector<std::string>
+cmCPackGeneratorListFiles(const std::string& dir)
+{
+  cmsys::Glob gl;
+  gl.RecurseOn();
+  gl.SetThreads(0);
+  gl.FindFiles(dir + "/*");
+  std::vector<std::string> files = gl.GetFiles();
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+//----------------------------------------------------------------------
+static std::string cmCPackGeneratorBracket(const std::string& value)
+{
+  return "[==[" + value + "]==]";
+}
+
 //----------------------------------------------------------------------
 void cmCPackGenerator::DisplayVerboseOutput(const char* msg,
   float progress)
@@ -190,7 +212,16 @@ int cmCPackGenerator::PrepareNames()
 int cmCPackGenerator::InstallProject()
 {
   cmCPackLogger(cmCPackLog::LOG_OUTPUT, "Install projects" << std::endl);
-  this->CleanTemporaryDirectory();
+  this->InstalledFiles.clear();
+  this->ScriptFiles.clear();
+  if (!this->IncrementalInstall)
+    {
+    this->CleanTemporaryDirectory();
+    }
+  else if (!this->RemoveScriptFiles())
+    {
+    return 0;
+    }
 
   std::string bareTempInstallDirectory
     = this->GetOption("CPACK_TEMPORARY_INSTALL_DIRECTORY");
@@ -265,6 +296,12 @@ int cmCPackGenerator::InstallProject()
     cmSystemTools::PutEnv("DESTDIR=");
     }
 
+  if ( this->IncrementalInstall &&
+       (!this->PruneTemporaryDirectory() || !this->WriteScriptFiles()) )
+    {
+    return 0;
+    }
+
   return res;
 }
 
@@ -545,6 +582,16 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
   const char* cmakeGenerator
     = this->GetOption("CPACK_CMAKE_GENERATOR");
   std::string absoluteDestFiles;
+  unsigned long jobs = 1;
+  const char* jobsStr = this->GetOption("CPACK_INSTALL_PARALLEL_JOBS");
+  if (jobsStr && *jobsStr &&
+      (!cmSystemTools::StringToULong(jobsStr, &jobs) || jobs == 0))
+    {
+    cmCPackLogger(cmCPackLog::LOG_WARNING,
+                  "Invalid value for CPACK_INSTALL_PARALLEL_JOBS: "
+                  << jobsStr << std::endl);
+    jobs = 1;
+    }
   if ( cmakeProjects && *cmakeProjects )
     {
     if ( !cmakeGenerator )
@@ -696,20 +743,34 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
         "- Install project: " << installProjectName << std::endl);
 
       // Run the installation for each component
-      std::vector<std::string>::iterator componentIt;
-      for (componentIt = componentsVector.begin();
-           componentIt != componentsVector.end();
-           ++componentIt)
+      std::vector<ComponentInstallation> installations(
+        componentsVector.size());
+      for (size_t i = 0; i < componentsVector.size(); ++i)
         {
-        std::string tempInstallDirectory = baseTempInstallDirectory;
-        installComponent = *componentIt;
-        if (componentInstall)
+        installations[i].Component = componentsVector[i];
+        if (!this->PrepareComponentInstallation(installations[i],
+                                                baseTempInstallDirectory,
+                                                componentInstall, setDestDir,
+                                                buildConfig))
           {
-          cmCPackLogger(cmCPackLog::LOG_OUTPUT,
-                        "-   Install component: " << installComponent
-                        << std::endl);
+          return 0;
           }
+        }
+      bool parallel = jobs > 1 && installations.size() > 1;
+      if (parallel &&
+          !this->RunComponentInstallations(installations, installFile,
+                                           componentInstall, setDestDir,
+                                           jobs))
+        {
+        return 0;
+        }
 
+      std::vector<ComponentInstallation>::iterator installIt;
+      for (installIt = installations.begin();
+           installIt != installations.end();
+           ++installIt)
+        {
+        installComponent = installIt->Component;
         cmake cm;
         cm.SetHomeDirectory("");
         cm.SetHomeOutputDirectory("");
@@ -718,263 +779,529 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
         cmGlobalGenerator gg(&cm);
         cmsys::auto_ptr<cmLocalGenerator> lg(gg.MakeLocalGenerator());
         cmMakefile *mf = lg->GetMakefile();
-        std::string realInstallDirectory = tempInstallDirectory;
-        if ( !installSubDirectory.empty() && installSubDirectory != "/" )
-          {
-          realInstallDirectory += installSubDirectory;
-          }
-        if (componentInstall)
-          {
-          tempInstallDirectory += "/";
-          // Some CPack generators would rather chose
-          // the local installation directory suffix.
-          // Some (e.g. RPM) use
-          //  one install directory for each component **GROUP**
-          // instead of the default
-          //  one install directory for each component.
-          tempInstallDirectory +=
-            GetComponentInstallDirNameSuffix(installComponent);
-          if (this->IsOn("CPACK_COMPONENT_INCLUDE_TOPLEVEL_DIRECTORY"))
-            {
-            tempInstallDirectory += "/";
-            tempInstallDirectory += this->GetOption("CPACK_PACKAGE_FILE_NAME");
-            }
-          }
-
-        if (!setDestDir)
+        int res;
+        if (parallel)
           {
-          tempInstallDirectory += this->GetPackagingInstallPrefix();
+          // The child process left its results in a script
+          res = mf->ReadListFile(installIt->ResultFile.c_str());
+          cmSystemTools::RemoveFile(installIt->Script);
+          cmSystemTools::RemoveFile(installIt->ResultFile);
           }
-
-        if ( setDestDir )
+        else
           {
-          // For DESTDIR based packaging, use the *project*
-          // CMAKE_INSTALL_PREFIX underneath the tempInstallDirectory. The
-          // value of the project's CMAKE_INSTALL_PREFIX is sent in here as
-          // the value of the CPACK_INSTALL_PREFIX variable.
-          //
-          // If DESTDIR has been 'internally set ON' this means that
-          // the underlying CPack specific generator did ask for that
-          // In this case we may override CPACK_INSTALL_PREFIX with
-          // CPACK_PACKAGING_INSTALL_PREFIX
-          // I know this is tricky and awkward but it's the price for
-          // CPACK_SET_DESTDIR backward compatibility.
-          if (cmSystemTools::IsInternallyOn(
-                this->GetOption("CPACK_SET_DESTDIR")))
+          if (componentInstall)
             {
-            this->SetOption("CPACK_INSTALL_PREFIX",
-                            this->GetOption("CPACK_PACKAGING_INSTALL_PREFIX"));
+            cmCPackLogger(cmCPackLog::LOG_OUTPUT,
+                          "-   Install component: " << installComponent
+                          << std::endl);
             }
-          std::string dir;
-          if (this->GetOption("CPACK_INSTALL_PREFIX"))
+          std::vector<std::pair<std::string, std::string> >::const_iterator
+            defIt;
+          for (defIt = installIt->Definitions.begin();
+               defIt != installIt->Definitions.end();
+               ++defIt)
             {
-            dir += this->GetOption("CPACK_INSTALL_PREFIX");
+            mf->AddDefinition(defIt->first, defIt->second.c_str());
             }
-          mf->AddDefinition("CMAKE_INSTALL_PREFIX", dir.c_str());
-
-          cmCPackLogger(
-            cmCPackLog::LOG_DEBUG,
-            "- Using DESTDIR + CPACK_INSTALL_PREFIX... (mf->AddDefinition)"
-            << std::endl);
-          cmCPackLogger(cmCPackLog::LOG_DEBUG,
-                        "- Setting CMAKE_INSTALL_PREFIX to '" << dir << "'"
-                        << std::endl);
-
-          // Make sure that DESTDIR + CPACK_INSTALL_PREFIX directory
-          // exists:
-          //
-          if (cmSystemTools::StringStartsWith(dir.c_str(), "/"))
+          if (setDestDir)
             {
-            dir = tempInstallDirectory + dir;
+            /*
+             *  We must re-set DESTDIR for each component
+             *  We must not add the CPACK_INSTALL_PREFIX part because
+             *  it will be added using the override of CMAKE_INSTALL_PREFIX
+             *  The main reason for this awkward trick is that
+             *  are using DESTDIR for 2 different reasons:
+             *     - Because it was asked by the CPack Generator or the user
+             *       using CPACK_SET_DESTDIR
+             *     - Because it was already used for component install
+             *       in order to put things in subdirs...
+             */
+            cmSystemTools::PutEnv(
+              std::string("DESTDIR=") + installIt->Directory);
             }
-          else
+          // Remember the list of files before installation
+          // of the current component (if we are in component install)
+          if (componentInstall || this->IncrementalInstall)
             {
-            dir = tempInstallDirectory + "/" + dir;
+            installIt->FilesBefore =
+              cmCPackGeneratorListFiles(installIt->Directory);
             }
-          /*
-           *  We must re-set DESTDIR for each component
-           *  We must not add the CPACK_INSTALL_PREFIX part because
-           *  it will be added using the override of CMAKE_INSTALL_PREFIX
-           *  The main reason for this awkward trick is that
-           *  are using DESTDIR for 2 different reasons:
-           *     - Because it was asked by the CPack Generator or the user
-           *       using CPACK_SET_DESTDIR
-           *     - Because it was already used for component install
-           *       in order to put things in subdirs...
-           */
-          cmSystemTools::PutEnv(
-              std::string("DESTDIR=")+tempInstallDirectory
-                               );
-          cmCPackLogger(cmCPackLog::LOG_DEBUG,
-                        "- Creating directory: '" << dir << "'" << std::endl);
-
-          if ( !cmsys::SystemTools::MakeDirectory(dir.c_str()))
+          // do installation
+          res = mf->ReadListFile(installFile.c_str());
+          // Now rebuild the list of files after installation
+          // of the current component (if we are in component install)
+          if (componentInstall || this->IncrementalInstall)
             {
-            cmCPackLogger(cmCPackLog::LOG_ERROR,
-                          "Problem creating temporary directory: "
-                          << dir << std::endl);
-            return 0;
+            installIt->FilesAfter =
+              cmCPackGeneratorListFiles(installIt->Directory);
             }
           }
-        else
+        this->ReadComponentInstallation(*installIt, mf, setDestDir);
+        if ( cmSystemTools::GetErrorOccuredFlag() || !res )
           {
-          mf->AddDefinition("CMAKE_INSTALL_PREFIX",
-                            tempInstallDirectory.c_str());
+          return 0;
+          }
+        }
 
-          if ( !cmsys::SystemTools::MakeDirectory(
-                 tempInstallDirectory.c_str()))
-            {
-            cmCPackLogger(cmCPackLog::LOG_ERROR,
-                          "Problem creating temporary directory: "
-                          << tempInstallDirectory << std::endl);
-            return 0;
-            }
+      // The files listed by the install manifests of the components
+      // sharing a directory, and the other files they created.
+      std::map<std::string, std::set<std::string> > manifests;
+      std::map<std::string, std::set<std::string> > scriptFiles;
+      for (installIt = installations.begin();
+           installIt != installations.end();
+           ++installIt)
+        {
+        manifests[installIt->Directory].insert(installIt->Installed.begin(),
+                                               installIt->Installed.end());
+        }
+      for (installIt = installations.begin();
+           installIt != installations.end();
+           ++installIt)
+        {
+        this->FinishComponentInstallation(*installIt,
+                                          manifests[installIt->Directory],
+                                          scriptFiles[installIt->Directory],
+                                          componentInstall,
+                                          absoluteDestFiles);
+        }
+      }
+    }
+  this->SetOption("CPACK_ABSOLUTE_DESTINATION_FILES",
+                  absoluteDestFiles.c_str());
+  return 1;
+}
 
-          cmCPackLogger(cmCPackLog::LOG_DEBUG,
-                        "- Using non-DESTDIR install... (mf->AddDefinition)"
-                        << std::endl);
-          cmCPackLogger(cmCPackLog::LOG_DEBUG,
-                        "- Setting CMAKE_INSTALL_PREFIX to '"
-                        << tempInstallDirectory
-                        << "'" << std::endl);
-          }
+//----------------------------------------------------------------------
+int cmCPackGenerator::PrepareComponentInstallation(
+  ComponentInstallation& installation,
+  const std::string& baseTempInstallDirectory,
+  bool componentInstall, bool setDestDir, const std::string& buildConfig)
+{
+  std::string tempInstallDirectory = baseTempInstallDirectory;
+  const std::string& installComponent = installation.Component;
+  if (componentInstall)
+    {
+    tempInstallDirectory += "/";
+    // Some CPack generators would rather chose
+    // the local installation directory suffix.
+    // Some (e.g. RPM) use
+    //  one install directory for each component **GROUP**
+    // instead of the default
+    //  one install directory for each component.
+    tempInstallDirectory +=
+      GetComponentInstallDirNameSuffix(installComponent);
+    if (this->IsOn("CPACK_COMPONENT_INCLUDE_TOPLEVEL_DIRECTORY"))
+      {
+      tempInstallDirectory += "/";
+      tempInstallDirectory += this->GetOption("CPACK_PACKAGE_FILE_NAME");
+      }
+    }
 
-        if (!buildConfig.empty())
-          {
-          mf->AddDefinition("BUILD_TYPE", buildConfig.c_str());
-          }
-        std::string installComponentLowerCase
-          = cmSystemTools::LowerCase(installComponent);
-        if ( installComponentLowerCase != "all" )
-          {
-          mf->AddDefinition("CMAKE_INSTALL_COMPONENT",
-                            installComponent.c_str());
-          }
+  if ( setDestDir )
+    {
+    // For DESTDIR based packaging, use the *project*
+    // CMAKE_INSTALL_PREFIX underneath the tempInstallDirectory. The
+    // value of the project's CMAKE_INSTALL_PREFIX is sent in here as
+    // the value of the CPACK_INSTALL_PREFIX variable.
+    //
+    // If DESTDIR has been 'internally set ON' this means that
+    // the underlying CPack specific generator did ask for that
+    // In this case we may override CPACK_INSTALL_PREFIX with
+    // CPACK_PACKAGING_INSTALL_PREFIX
+    // I know this is tricky and awkward but it's the price for
+    // CPACK_SET_DESTDIR backward compatibility.
+    if (cmSystemTools::IsInternallyOn(
+          this->GetOption("CPACK_SET_DESTDIR")))
+      {
+      this->SetOption("CPACK_INSTALL_PREFIX",
+                      this->GetOption("CPACK_PACKAGING_INSTALL_PREFIX"));
+      }
+    std::string dir;
+    if (this->GetOption("CPACK_INSTALL_PREFIX"))
+      {
+      dir += this->GetOption("CPACK_INSTALL_PREFIX");
+      }
+    installation.Definitions.push_back(
+      std::make_pair(std::string("CMAKE_INSTALL_PREFIX"), dir));
 
-        // strip on TRUE, ON, 1, one or several file names, but not on
-        // FALSE, OFF, 0 and an empty string
-        if (!cmSystemTools::IsOff(this->GetOption("CPACK_STRIP_FILES")))
-          {
-          mf->AddDefinition("CMAKE_INSTALL_DO_STRIP", "1");
-          }
-        // Remember the list of files before installation
-        // of the current component (if we are in component install)
-        const char* InstallPrefix = tempInstallDirectory.c_str();
-        std::vector<std::string> filesBefore;
-        std::string findExpr(InstallPrefix);
-        if (componentInstall)
-          {
-          cmsys::Glob glB;
-          findExpr += "/*";
-          glB.RecurseOn();
-          glB.FindFiles(findExpr);
-          filesBefore = glB.GetFiles();
-          std::sort(filesBefore.begin(),filesBefore.end());
-          }
+    cmCPackLogger(
+      cmCPackLog::LOG_DEBUG,
+      "- Using DESTDIR + CPACK_INSTALL_PREFIX... (mf->AddDefinition)"
+      << std::endl);
+    cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                  "- Setting CMAKE_INSTALL_PREFIX to '" << dir << "'"
+                  << std::endl);
 
-        // If CPack was asked to warn on ABSOLUTE INSTALL DESTINATION
-        // then forward request to cmake_install.cmake script
-        if (this->IsOn("CPACK_WARN_ON_ABSOLUTE_INSTALL_DESTINATION"))
-          {
-            mf->AddDefinition("CMAKE_WARN_ON_ABSOLUTE_INSTALL_DESTINATION",
-                              "1");
-          }
-        // If current CPack generator does support
-        // ABSOLUTE INSTALL DESTINATION or CPack has been asked for
-        // then ask cmake_install.cmake script to error out
-        // as soon as it occurs (before installing file)
-        if (!SupportsAbsoluteDestination() ||
-            this->IsOn("CPACK_ERROR_ON_ABSOLUTE_INSTALL_DESTINATION"))
-          {
-            mf->AddDefinition("CMAKE_ERROR_ON_ABSOLUTE_INSTALL_DESTINATION",
-                              "1");
-          }
-        // do installation
-        int res = mf->ReadListFile(installFile.c_str());
-        // forward definition of CMAKE_ABSOLUTE_DESTINATION_FILES
-        // to CPack (may be used by generators like CPack RPM or DEB)
-        // in order to transparently handle ABSOLUTE PATH
-        if (mf->GetDefinition("CMAKE_ABSOLUTE_DESTINATION_FILES"))
-          {
-            mf->AddDefinition("CPACK_ABSOLUTE_DESTINATION_FILES",
-                mf->GetDefinition("CMAKE_ABSOLUTE_DESTINATION_FILES"));
-          }
+    // Make sure that DESTDIR + CPACK_INSTALL_PREFIX directory
+    // exists:
+    //
+    if (cmSystemTools::StringStartsWith(dir.c_str(), "/"))
+      {
+      dir = tempInstallDirectory + dir;
+      }
+    else
+      {
+      dir = tempInstallDirectory + "/" + dir;
+      }
+    cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                  "- Creating directory: '" << dir << "'" << std::endl);
+
+    if ( !cmsys::SystemTools::MakeDirectory(dir.c_str()))
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Problem creating temporary directory: "
+                    << dir << std::endl);
+      return 0;
+      }
+    }
+  else
+    {
+    tempInstallDirectory += this->GetPackagingInstallPrefix();
+    installation.Definitions.push_back(
+      std::make_pair(std::string("CMAKE_INSTALL_PREFIX"),
+                     tempInstallDirectory));
+
+    if ( !cmsys::SystemTools::MakeDirectory(
+           tempInstallDirectory.c_str()))
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Problem creating temporary directory: "
+                    << tempInstallDirectory << std::endl);
+      return 0;
+      }
+
+    cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                  "- Using non-DESTDIR install... (mf->AddDefinition)"
+                  << std::endl);
+    cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                  "- Setting CMAKE_INSTALL_PREFIX to '"
+                  << tempInstallDirectory
+                  << "'" << std::endl);
+    }
+  installation.Directory = tempInstallDirectory;
+
+  if (!buildConfig.empty())
+    {
+    installation.Definitions.push_back(
+      std::make_pair(std::string("BUILD_TYPE"), buildConfig));
+    }
+  if ( cmSystemTools::LowerCase(installComponent) != "all" )
+    {
+    installation.Definitions.push_back(
+      std::make_pair(std::string("CMAKE_INSTALL_COMPONENT"),
+                     installComponent));
+    }
+
+  // strip on TRUE, ON, 1, one or several file names, but not on
+  // FALSE, OFF, 0 and an empty string
+  if (!cmSystemTools::IsOff(this->GetOption("CPACK_STRIP_FILES")))
+    {
+    installation.Definitions.push_back(
+      std::make_pair(std::string("CMAKE_INSTALL_DO_STRIP"),
+                     std::string("1")));
+    }
+  // If CPack was asked to warn on ABSOLUTE INSTALL DESTINATION
+  // then forward request to cmake_install.cmake script
+  if (this->IsOn("CPACK_WARN_ON_ABSOLUTE_INSTALL_DESTINATION"))
+    {
+    installation.Definitions.push_back(std::make_pair(
+      std::string("CMAKE_WARN_ON_ABSOLUTE_INSTALL_DESTINATION"),
+      std::string("1")));
+    }
+  // If current CPack generator does support
+  // ABSOLUTE INSTALL DESTINATION or CPack has been asked for
+  // then ask cmake_install.cmake script to error out
+  // as soon as it occurs (before installing file)
+  if (!SupportsAbsoluteDestination() ||
+      this->IsOn("CPACK_ERROR_ON_ABSOLUTE_INSTALL_DESTINATION"))
+    {
+    installation.Definitions.push_back(std::make_pair(
+      std::string("CMAKE_ERROR_ON_ABSOLUTE_INSTALL_DESTINATION"),
+      std::string("1")));
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------
+int cmCPackGenerator::RunComponentInstallations(
+  std::vector<ComponentInstallation>& installations,
+  const std::string& installFile, bool componentInstall, bool setDestDir,
+  unsigned long jobs)
+{
+  // Components sharing an installation directory (e.g. a component
+  // group) are installed at the same time too, their install manifests
+  // tell their files apart.  The directory is listed before the first
+  // of them starts and after the last of them finishes.
+  bool listFiles = componentInstall || this->IncrementalInstall;
+  std::map<std::string, size_t> pending;
+  std::map<std::string, std::vector<std::string> > filesBefore;
+  for (size_t i = 0; i < installations.size(); ++i)
+    {
+    ++pending[installations[i].Directory];
+    }
+
+  std::string scriptDir = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  std::vector<cmsysProcess*> procs;
+  std::vector<size_t> running;
+  size_t next = 0;
+  bool failed = false;
+  while (!procs.empty() || (!failed && next < installations.size()))
+    {
+    while (!failed && procs.size() < jobs && next < installations.size())
+      {
+      ComponentInstallation& installation = installations[next];
+      if (componentInstall)
+        {
+        cmCPackLogger(cmCPackLog::LOG_OUTPUT,
+                      "-   Install component: " << installation.Component
+                      << std::endl);
+        }
+      std::ostringstream name;
+      name << scriptDir << "/CPackInstall" << next;
+      installation.Script = name.str() + ".cmake";
+      installation.ResultFile = name.str() + "Result.cmake";
+      {
+      cmGeneratedFileStream out(installation.Script.c_str());
+      out << "# Install script generated by CPack for component "
+          << installation.Component << std::endl;
+      if (setDestDir)
+        {
+        out << "set(ENV{DESTDIR} "
+            << cmCPackGeneratorBracket(installation.Directory) << ")"
+            << std::endl;
+        }
+      std::vector<std::pair<std::string, std::string> >::const_iterator
+        defIt;
+      for (defIt = installation.Definitions.begin();
+           defIt != installation.Definitions.end();
+           ++defIt)
+        {
+        out << "set(" << defIt->first << " "
+            << cmCPackGeneratorBracket(defIt->second) << ")" << std::endl;
+        }
+      std::string result = cmCPackGeneratorBracket(installation.ResultFile);
+      out << "include(" << cmCPackGeneratorBracket(installFile) << ")"
+          << std::endl
+          << "file(WRITE " << result << " \"set(CMAKE_INSTALL_MANIFEST_FILES"
+          << " [==[${CMAKE_INSTALL_MANIFEST_FILES}]==])\\n\")" << std::endl
+          << "if(DEFINED CMAKE_ABSOLUTE_DESTINATION_FILES)" << std::endl
+          << "  file(APPEND " << result
+          << " \"set(CMAKE_ABSOLUTE_DESTINATION_FILES"
+          << " [==[${CMAKE_ABSOLUTE_DESTINATION_FILES}]==])\\n\")"
+          << std::endl
+          << "endif()" << std::endl;
+      }
+      if (listFiles && !filesBefore.count(installation.Directory))
+        {
+        filesBefore[installation.Directory] =
+          cmCPackGeneratorListFiles(installation.Directory);
+        }
+      const char* argv[] = {
+        cmSystemTools::GetCMakeCommand().c_str(), "-P",
+        installation.Script.c_str(), 0
+      };
+      cmsysProcess* cp = cmsysProcess_New();
+      cmsysProcess_SetCommand(cp, argv);
+      cmsysProcess_SetOption(cp, cmsysProcess_Option_HideWindow, 1);
+      cmsysProcess_Execute(cp);
+      procs.push_back(cp);
+      running.push_back(next++);
+      }
 
-        // Now rebuild the list of files after installation
-        // of the current component (if we are in component install)
-        if (componentInstall)
+    // Read the output the installations have so far without blocking,
+    // then block until any of them has more or exits.
+    size_t done = procs.size();
+    for (size_t r = 0; r < procs.size() && done == procs.size(); ++r)
+      {
+      double poll = 0;
+      char* data;
+      int length;
+      int pipe;
+      while ((pipe = cmsysProcess_WaitForData(procs[r], &data, &length,
+                                              &poll)) > 0 &&
+             pipe != cmsysProcess_Pipe_Timeout)
+        {
+        installations[running[r]].Output.append(data, length);
+        }
+      if (pipe != cmsysProcess_Pipe_Timeout)
+        {
+        done = r;
+        }
+      }
+    if (done == procs.size())
+      {
+      cmsysProcess_WaitForAny(&*procs.begin(), static_cast<int>(procs.size()),
+                              0);
+      continue;
+      }
+
+    cmsysProcess* cp = procs[done];
+    ComponentInstallation& installation = installations[running[done]];
+    procs.erase(procs.begin() + done);
+    running.erase(running.begin() + done);
+    cmsysProcess_WaitForExit(cp, 0);
+    bool ok = cmsysProcess_GetState(cp) == cmsysProcess_State_Exited
+      && cmsysProcess_GetExitValue(cp) == 0;
+    if (cmsysProcess_GetState(cp) == cmsysProcess_State_Error)
+      {
+      installation.Output += cmsysProcess_GetErrorString(cp);
+      }
+    cmsysProcess_Delete(cp);
+    if (ok)
+      {
+      cmCPackLogger(cmCPackLog::LOG_VERBOSE, installation.Output
+                    << std::endl);
+      }
+    else
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Problem installing component: "
+                    << installation.Component << std::endl
+                    << installation.Output << std::endl);
+      failed = true;
+      }
+    if (listFiles && --pending[installation.Directory] == 0)
+      {
+      std::vector<std::string> filesAfter =
+        cmCPackGeneratorListFiles(installation.Directory);
+      std::vector<ComponentInstallation>::iterator it;
+      for (it = installations.begin(); it != installations.end(); ++it)
+        {
+        if (it->Directory == installation.Directory)
           {
-          cmsys::Glob glA;
-          glA.RecurseOn();
-          glA.FindFiles(findExpr);
-          std::vector<std::string> filesAfter = glA.GetFiles();
-          std::sort(filesAfter.begin(),filesAfter.end());
-          std::vector<std::string>::iterator diff;
-          std::vector<std::string> result(filesAfter.size());
-          diff = std::set_difference (
-                  filesAfter.begin(),filesAfter.end(),
-                  filesBefore.begin(),filesBefore.end(),
-                  result.begin());
-
-          std::vector<std::string>::iterator fit;
-          std::string localFileName;
-          // Populate the File field of each component
-          for (fit=result.begin();fit!=diff;++fit)
-            {
-            localFileName =
-                cmSystemTools::RelativePath(InstallPrefix, fit->c_str());
-            localFileName =
-                localFileName.substr(localFileName.find_first_not_of('/'),
-                                     std::string::npos);
-            Components[installComponent].Files.push_back(localFileName);
-            cmCPackLogger(cmCPackLog::LOG_DEBUG, "Adding file <"
-                                <<localFileName<<"> to component <"
-                                <<installComponent<<">"<<std::endl);
-            }
+          it->FilesBefore = filesBefore[installation.Directory];
+          it->FilesAfter = filesAfter;
           }
+        }
+      }
+    }
+  if (failed)
+    {
+    std::vector<ComponentInstallation>::const_iterator it;
+    for (it = installations.begin(); it != installations.end(); ++it)
+      {
+      if (!it->Script.empty())
+        {
+        cmSystemTools::RemoveFile(it->Script);
+        cmSystemTools::RemoveFile(it->ResultFile);
+        }
+      }
+    return 0;
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------
+void cmCPackGenerator::ReadComponentInstallation(
+  ComponentInstallation& installation, cmMakefile* mf, bool setDestDir)
+{
+  std::vector<std::string> manifest;
+  cmSystemTools::ExpandListArgument(
+    mf->GetSafeDefinition("CMAKE_INSTALL_MANIFEST_FILES"), manifest);
+  for (std::vector<std::string>::const_iterator mit = manifest.begin();
+       mit != manifest.end(); ++mit)
+    {
+    std::string path = setDestDir? installation.Directory + *mit : *mit;
+    installation.Installed.insert(cmSystemTools::CollapseFullPath(path));
+    }
+
+  // forward definition of CMAKE_ABSOLUTE_DESTINATION_FILES
+  // to CPack (may be used by generators like CPack RPM or DEB)
+  // in order to transparently handle ABSOLUTE PATH
+  const char* absolute = mf->GetDefinition("CMAKE_ABSOLUTE_DESTINATION_FILES");
+  installation.AbsoluteDestination = absolute != 0;
+  installation.AbsoluteDestinationFiles = absolute? absolute : "";
+}
 
-        if (NULL !=mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES")) {
-          if (!absoluteDestFiles.empty()) {
-            absoluteDestFiles +=";";
+//----------------------------------------------------------------------
+void cmCPackGenerator::FinishComponentInstallation(
+  ComponentInstallation& installation,
+  std::set<std::string> const& manifests, std::set<std::string>& scriptFiles,
+  bool componentInstall, std::string& absoluteDestFiles)
+{
+  const std::string& installComponent = installation.Component;
+  if (componentInstall || this->IncrementalInstall)
+    {
+    // The files listed by the install manifest belong to the component,
+    // also when they were there before because they were up to date.
+    // The new files no manifest lists were created by install scripts
+    // and belong to the first component of the directory that has them.
+    const char* InstallPrefix = installation.Directory.c_str();
+    std::vector<std::string> const& filesBefore = installation.FilesBefore;
+    std::vector<std::string> const& filesAfter = installation.FilesAfter;
+    std::string localFileName;
+    for (std::vector<std::string>::const_iterator fit = filesAfter.begin();
+         fit != filesAfter.end(); ++fit)
+      {
+      std::string path = cmSystemTools::CollapseFullPath(*fit);
+      if (!installation.Installed.count(path))
+        {
+        if (manifests.count(path) ||
+            std::binary_search(filesBefore.begin(), filesBefore.end(),
+                               *fit) ||
+            !scriptFiles.insert(path).second)
+          {
+          continue;
           }
-          absoluteDestFiles +=
-            mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES");
-          cmCPackLogger(cmCPackLog::LOG_DEBUG,
-                                    "Got some ABSOLUTE DESTINATION FILES: "
-                                    << absoluteDestFiles << std::endl);
-          // define component specific var
-          if (componentInstall)
-            {
-            std::string absoluteDestFileComponent =
-                std::string("CPACK_ABSOLUTE_DESTINATION_FILES")
-                + "_" + GetComponentInstallDirNameSuffix(installComponent);
-            if (NULL != this->GetOption(absoluteDestFileComponent))
-              {
-                std::string absoluteDestFilesListComponent =
-                    this->GetOption(absoluteDestFileComponent);
-                absoluteDestFilesListComponent +=";";
-                absoluteDestFilesListComponent +=
-                    mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES");
-                this->SetOption(absoluteDestFileComponent,
-                    absoluteDestFilesListComponent.c_str());
-              }
-            else
-              {
-              this->SetOption(absoluteDestFileComponent,
-                  mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES"));
-              }
-            }
-        }
-        if ( cmSystemTools::GetErrorOccuredFlag() || !res )
+        if (this->IncrementalInstall)
           {
-          return 0;
+          // They are removed before the next install so that they are
+          // new again.
+          this->ScriptFiles.insert(path);
           }
         }
+      if (this->IncrementalInstall)
+        {
+        this->InstalledFiles.insert(path);
+        }
+      if (!componentInstall)
+        {
+        continue;
+        }
+      // Populate the File field of each component
+      localFileName =
+          cmSystemTools::RelativePath(InstallPrefix, fit->c_str());
+      localFileName =
+          localFileName.substr(localFileName.find_first_not_of('/'),
+                               std::string::npos);
+      Components[installComponent].Files.push_back(localFileName);
+      cmCPackLogger(cmCPackLog::LOG_DEBUG, "Adding file <"
+                          <<localFileName<<"> to component <"
+                          <<installComponent<<">"<<std::endl);
       }
     }
-  this->SetOption("CPACK_ABSOLUTE_DESTINATION_FILES",
-                  absoluteDestFiles.c_str());
-  return 1;
+
+  if (installation.AbsoluteDestination) {
+    if (!absoluteDestFiles.empty()) {
+      absoluteDestFiles +=";";
+    }
+    absoluteDestFiles += installation.AbsoluteDestinationFiles;
+    cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                              "Got some ABSOLUTE DESTINATION FILES: "
+                              << absoluteDestFiles << std::endl);
+    // define component specific var
+    if (componentInstall)
+      {
+      std::string absoluteDestFileComponent =
+          std::string("CPACK_ABSOLUTE_DESTINATION_FILES")
+          + "_" + GetComponentInstallDirNameSuffix(installComponent);
+      if (NULL != this->GetOption(absoluteDestFileComponent))
+        {
+          std::string absoluteDestFilesListComponent =
+              this->GetOption(absoluteDestFileComponent);
+          absoluteDestFilesListComponent +=";";
+          absoluteDestFilesListComponent +=
+              installation.AbsoluteDestinationFiles;
+          this->SetOption(absoluteDestFileComponent,
+              absoluteDestFilesListComponent.c_str());
+        }
+      else
+        {
+        this->SetOption(absoluteDestFileComponent,
+            installation.AbsoluteDestinationFiles.c_str());
+        }
+      }
+  }
 }
 
 //----------------------------------------------------------------------
@@ -1032,7 +1359,14 @@ int cmCPackGenerator::DoPackage()
     return 0;
     }
 
-  if ( cmSystemTools::IsOn(
+  // An incremental install updates the temporary install directory of
+  // the previous run.  It relies on the install manifest, which only the
+  // install of CMake projects provides.
+  this->IncrementalInstall = this->IsOn("CPACK_INCREMENTAL_INSTALL") &&
+    !this->IsSet("CPACK_INSTALL_COMMANDS") &&
+    !this->IsSet("CPACK_INSTALL_SCRIPT") &&
+    !this->IsSet("CPACK_INSTALLED_DIRECTORIES");
+  if ( !this->IncrementalInstall && cmSystemTools::IsOn(
       this->GetOption("CPACK_REMOVE_TOPLEVEL_DIRECTORY")) )
     {
     const char* toplevelDirectory
@@ -1073,6 +1407,7 @@ int cmCPackGenerator::DoPackage()
   findExpr += "/*";
   gl.RecurseOn();
   gl.SetRecurseThroughSymlinks(false);
+  gl.SetThreads(0);
   if ( !gl.FindFiles(findExpr) )
     {
     cmCPackLogger(cmCPackLog::LOG_ERROR,
@@ -1328,6 +1663,96 @@ int cmCPackGenerator::CleanTemporaryDirectory()
   return 1;
 }
 
+//----------------------------------------------------------------------
+int cmCPackGenerator::PruneTemporaryDirectory()
+{
+  std::string tempInstallDirectory
+    = this->GetOption("CPACK_TEMPORARY_INSTALL_DIRECTORY");
+  cmsys::Glob gl;
+  gl.RecurseOn();
+  gl.RecurseThroughSymlinksOff();
+  gl.FindFiles(tempInstallDirectory + "/*");
+  std::vector<std::string> const& found = gl.GetFiles();
+  std::set<std::string> dirs;
+  for (std::vector<std::string>::const_iterator fit = found.begin();
+       fit != found.end(); ++fit)
+    {
+    if (this->InstalledFiles.count(cmSystemTools::CollapseFullPath(*fit)))
+      {
+      continue;
+      }
+    cmCPackLogger(cmCPackLog::LOG_VERBOSE,
+                  "- Remove stale file: " << *fit << std::endl);
+    if (!cmSystemTools::RemoveFile(*fit))
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Problem removing stale file: " << *fit << std::endl);
+      return 0;
+      }
+    dirs.insert(cmSystemTools::GetFilenamePath(*fit));
+    }
+
+  // Remove the directories left empty, deepest first.
+  for (std::set<std::string>::reverse_iterator dit = dirs.rbegin();
+       dit != dirs.rend(); ++dit)
+    {
+    for (std::string dir = *dit;
+         dir.size() > tempInstallDirectory.size();
+         dir = cmSystemTools::GetFilenamePath(dir))
+      {
+      cmsys::Directory d;
+      if (!d.Load(dir) || d.GetNumberOfFiles() > 2 ||
+          !cmSystemTools::RemoveADirectory(dir))
+        {
+        break;
+        }
+      }
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------
+std::string cmCPackGenerator::GetScriptFilesList()
+{
+  std::string list = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  list += "/CPackScriptFiles.txt";
+  return list;
+}
+
+//----------------------------------------------------------------------
+int cmCPackGenerator::RemoveScriptFiles()
+{
+  // The install scripts write these files again if they still do so.
+  cmsys::ifstream fin(this->GetScriptFilesList().c_str());
+  std::string line;
+  while (fin && cmSystemTools::GetLineFromStream(fin, line))
+    {
+    if (line.empty() || !cmSystemTools::FileExists(line.c_str(), true))
+      {
+      continue;
+      }
+    if (!cmSystemTools::RemoveFile(line))
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Problem removing file: " << line << std::endl);
+      return 0;
+      }
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------
+int cmCPackGenerator::WriteScriptFiles()
+{
+  cmGeneratedFileStream fout(this->GetScriptFilesList().c_str());
+  for (std::set<std::string>::const_iterator sit = this->ScriptFiles.begin();
+       sit != this->ScriptFiles.end(); ++sit)
+    {
+    fout << *sit << std::endl;
+    }
+  return fout? 1 : 0;
+}
+
 //----------------------------------------------------------------------
 cmInstalledFile const* cmCPackGenerator::GetInstalledFile(
   std::string const& name) const
@@ -16,6 +16,7 @@
 #include "cmObject.h"
 #include "cmSystemTools.h"
 #include <map>
+#include <set>
 #include <vector>
 
 #include "cmCPackComponentGroup.h" // cmCPackComponent and friends
@@ -130,6 +131,20 @@ protected:
 
   int CleanTemporaryDirectory();
 
+  /**
+   * Remove the files of a previous incremental install that were not
+   * installed again.
+   */
+  int PruneTemporaryDirectory();
+
+  /**
+   * The files created by the install scripts of an incremental install
+   * are listed in a file and removed before the next one.
+   */
+  std::string GetScriptFilesList();
+  int RemoveScriptFiles();
+  int WriteScriptFiles();
+
   cmInstalledFile const* GetInstalledFile(std::string const& name) const;
 
   virtual const char* GetOutputExtension() { return ".cpack"; }
@@ -202,6 +217,49 @@ protected:
   virtual int InstallProjectViaInstallCMakeProjects(
     bool setDestDir, const std::string& tempInstallDirectory);
 
+  /**
+   * The state of installing one component of a CMake project.
+   */
+  struct ComponentInstallation
+  {
+    std::string Component;
+    std::string Directory;
+    std::vector<std::pair<std::string, std::string> > Definitions;
+    std::vector<std::string> FilesBefore;
+    std::vector<std::string> FilesAfter;
+    std::set<std::string> Installed;
+    bool AbsoluteDestination;
+    std::string AbsoluteDestinationFiles;
+    std::string Script;
+    std::string ResultFile;
+    std::string Output;
+  };
+  int PrepareComponentInstallation(ComponentInstallation& installation,
+                                   const std::string& baseTempInstallDirectory,
+                                   bool componentInstall, bool setDestDir,
+                                   const std::string& buildConfig);
+  /**
+   * Run the installations of a CMake project in up to jobs child
+   * processes, see CPACK_INSTALL_PARALLEL_JOBS.
+   */
+  int RunComponentInstallations(
+    std::vector<ComponentInstallation>& installations,
+    const std::string& installFile, bool componentInstall, bool setDestDir,
+    unsigned long jobs);
+  void ReadComponentInstallation(ComponentInstallation& installation,
+                                 cmMakefile* mf, bool setDestDir);
+  /**
+   * Assign the files of an installation to its component.  The
+   * manifests are the files listed by the install manifests of all
+   * installations into the same directory, the script files those of
+   * their other new files that were already assigned.
+   */
+  void FinishComponentInstallation(ComponentInstallation& installation,
+                                   std::set<std::string> const& manifests,
+                                   std::set<std::string>& scriptFiles,
+                                   bool componentInstall,
+                                   std::string& absoluteDestFiles);
+
   /**
    * The various level of support of
    * CPACK_SET_DESTDIR used by the generator.
@@ -322,6 +380,23 @@ protected:
    */
   ComponentPackageMethod componentPackageMethod;
 
+  /**
+   * Whether the temporary install directory of the previous run is
+   * updated instead of being recreated, see CPACK_INCREMENTAL_INSTALL.
+   */
+  bool IncrementalInstall;
+
+  /**
+   * The files installed by the current incremental install.
+   */
+  std::set<std::string> InstalledFiles;
+
+  /**
+   * The files of the current incremental install that install scripts
+   * created without listing them in the install manifest.
+   */
+  std::set<std::string> ScriptFiles;
+
   cmCPackLog* Logger;
 private:
   cmMakefile* MakefileMap;
@@ -31,6 +31,9 @@ public:
   cmCPackSTGZGenerator();
   virtual ~cmCPackSTGZGenerator();
 
+  // The header and the permissions are specific to the script
+  virtual bool SupportsSharedArchives() const { return false; }
+
 protected:
   int PackageFiles();
   virtual int InitializeInternal();
@@ -16,6 +16,7 @@
 #include "cmDocumentation.h"
 #include "cmCPackGeneratorFactory.h"
 #include "cmCPackGenerator.h"
+#include "cmCPackArchiveGenerator.h"
 #include "cmake.h"
 #include "cmGlobalGenerator.h"
 #include "cmLocalGenerator.h"
@@ -351,11 +352,16 @@ int main (int argc, char const* const* argv)
       std::vector<std::string> generatorsVector;
       cmSystemTools::ExpandListArgument(genList,
         generatorsVector);
+      std::set<std::string> sharedGenerators;
       std::vector<std::string>::iterator it;
       for ( it = generatorsVector.begin();
         it != generatorsVector.end();
         ++it )
         {
+        if ( sharedGenerators.count(*it) )
+          {
+          continue;
+          }
         const char* gen = it->c_str();
         cmMakefile::ScopePushPop raii(globalMF);
         cmMakefile* mf = globalMF;
@@ -397,6 +403,36 @@ int main (int argc, char const* const* argv)
               "Cannot initialize the generator " << gen << std::endl);
             parsed = 0;
             }
+          // The archive generators listed after this one write their
+          // archives along with it from the same installation, unless
+          // the project config file may set them up differently.
+          cmCPackArchiveGenerator* archiveGenerator =
+            cmCPackArchiveGenerator::SafeDownCast(cpackGenerator);
+          if ( parsed && archiveGenerator &&
+            archiveGenerator->SupportsSharedArchives() &&
+            !mf->GetDefinition("CPACK_PROJECT_CONFIG_FILE") )
+            {
+            std::vector<std::string>::iterator sit;
+            for ( sit = it + 1; sit != generatorsVector.end(); ++sit )
+              {
+              if ( *sit == *it || sharedGenerators.count(*sit) )
+                {
+                continue;
+                }
+              cmCPackArchiveGenerator* sharedGenerator =
+                cmCPackArchiveGenerator::SafeDownCast(
+                  generators.NewGenerator(*sit));
+              if ( sharedGenerator &&
+                sharedGenerator->SupportsSharedArchives() )
+                {
+                cmCPack_Log(&log, cmCPackLog::LOG_VERBOSE,
+                  "Generator " << *sit << " shares the installation of "
+                  << gen << std::endl);
+                archiveGenerator->AddSharedGenerator(sharedGenerator);
+                sharedGenerators.insert(*sit);
+                }
+              }
+            }
 
           if ( !mf->GetDefinition("CPACK_INSTALL_COMMANDS") &&
             !mf->GetDefinition("CPACK_INSTALLED_DIRECTORIES") &&
@@ -44,8 +44,18 @@ cmCTestMultiProcessHandler::cmCTestMultiProcessHandler()
 {
   this->ParallelLevel = 1;
   this->TestLoad = 0;
+  this->TestMemory = 0;
+  this->MemoryBackoffUntil = 0;
+  this->MemoryBackoff = 0;
+  this->ShardIndex = 0;
+  this->ShardCount = 0;
+  this->StopOnFailure = false;
+  this->KillOnFailure = false;
+  this->StoppedOnFailure = false;
+  this->KilledCount = 0;
   this->Completed = 0;
   this->RunningCount = 0;
+  this->RunningMemory = 0;
   this->StopTimePassed = false;
   this->HasCycles = false;
   this->SerialTestRunning = false;
@@ -70,9 +80,16 @@ cmCTestMultiProcessHandler::SetTests(TestMap& tests,
     this->TestRunningMap[i->first] = false;
     this->TestFinishMap[i->first] = false;
     }
-  if(!this->CTest->GetShowOnly())
+  if(!this->CTest->GetShowOnly() || this->ShardCount > 1)
     {
     this->ReadCostData();
+    }
+  if(this->ShardCount > 1)
+    {
+    this->SelectShardTests();
+    }
+  if(!this->CTest->GetShowOnly())
+    {
     this->HasCycles = !this->CheckCycles();
     if(this->HasCycles)
       {
@@ -93,6 +110,23 @@ void cmCTestMultiProcessHandler::SetTestLoad(unsigned long load)
   this->TestLoad = load;
 }
 
+void cmCTestMultiProcessHandler::SetTestMemory(unsigned long memory)
+{
+  this->TestMemory = memory;
+}
+
+void cmCTestMultiProcessHandler::SetShard(size_t index, size_t count)
+{
+  this->ShardIndex = index;
+  this->ShardCount = count;
+}
+
+void cmCTestMultiProcessHandler::SetStopOnFailure(bool stop, bool kill)
+{
+  this->StopOnFailure = stop;
+  this->KillOnFailure = stop && kill;
+}
+
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::RunTests()
 {
@@ -109,6 +143,10 @@ void cmCTestMultiProcessHandler::RunTests()
       {
       return;
       }
+    if(this->StoppedOnFailure)
+      {
+      break;
+      }
     this->CheckOutput();
     this->StartNextTests();
     }
@@ -116,7 +154,19 @@ void cmCTestMultiProcessHandler::RunTests()
   while(this->CheckOutput())
     {
     }
-  this->MarkFinished();
+  size_t unfinished = this->Tests.size() + this->KilledCount;
+  if(this->StoppedOnFailure && unfinished > 0)
+    {
+    // Keep the checkpoint so that "ctest -F" resumes with the tests
+    // that did not get to run.
+    cmCTestLog(this->CTest, HANDLER_OUTPUT, "Skipped " << unfinished
+      << " remaining tests after a failure; rerun with -F to resume."
+      << std::endl);
+    }
+  else
+    {
+    this->MarkFinished();
+    }
   this->UpdateCostData();
 }
 
@@ -129,6 +179,7 @@ void cmCTestMultiProcessHandler::StartTestProcess(int test)
   // now remove the test itself
   this->EraseTest(test);
   this->RunningCount += GetProcessorsUsed(test);
+  this->ReserveMemory(test);
 
   cmCTestRunTest* testRun = new cmCTestRunTest(this->TestHandler);
   if(this->CTest->GetRepeatUntilFail())
@@ -169,8 +220,9 @@ void cmCTestMultiProcessHandler::StartTestProcess(int test)
     this->TestFinishMap[test] = true;
     this->TestRunningMap[test] = false;
     this->RunningCount -= GetProcessorsUsed(test);
+    this->ReleaseMemory(test);
     testRun->EndTest(this->Completed, this->Total, false);
-    this->Failed->push_back(this->Properties[test]->Name);
+    this->TestFailed(test);
     delete testRun;
     }
   cmSystemTools::ChangeDirectory(current_dir);
@@ -200,6 +252,27 @@ void cmCTestMultiProcessHandler::UnlockResources(int index)
     }
 }
 
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::ReserveMemory(int index)
+{
+  unsigned long memory = this->GetMemoryRequired(index);
+  this->ReservedMemory[index] = memory;
+  this->RunningMemory += memory;
+}
+
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::ReleaseMemory(int index)
+{
+  // The estimate may have been updated by the finished run, so release
+  // exactly what was reserved when the test started.
+  std::map<int, unsigned long>::iterator i = this->ReservedMemory.find(index);
+  if(i != this->ReservedMemory.end())
+    {
+    this->RunningMemory -= i->second;
+    this->ReservedMemory.erase(i);
+    }
+}
+
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::EraseTest(int test)
 {
@@ -222,6 +295,93 @@ inline size_t cmCTestMultiProcessHandler::GetProcessorsUsed(int test)
   return processors;
 }
 
+//---------------------------------------------------------
+unsigned long cmCTestMultiProcessHandler::GetMemoryRequired(int test)
+{
+  cmCTestTestHandler::cmCTestTestProperties* p = this->Properties[test];
+  return std::max(p->PeakMemory, p->ObservedPeakMemory);
+}
+
+//---------------------------------------------------------
+// Read the memory available for new processes in megabytes.
+static bool cmCTestReadAvailableMemory(unsigned long& available)
+{
+  if (const char* fake_value =
+      cmSystemTools::GetEnv("__CTEST_FAKE_AVAILABLE_MEMORY_FOR_TESTING"))
+    {
+    return cmSystemTools::StringToULong(fake_value, &available);
+    }
+  cmsys::ifstream fin("/proc/meminfo");
+  std::string line;
+  while(fin && cmSystemTools::GetLineFromStream(fin, line))
+    {
+    unsigned long kb = 0;
+    if(sscanf(line.c_str(), "MemAvailable: %lu kB", &kb) == 1)
+      {
+      available = kb / 1024;
+      return true;
+      }
+    }
+  return false;
+}
+
+//---------------------------------------------------------
+// Read the share of the last 10 seconds in which some tasks were
+// stalled waiting for memory, in percent.
+static bool cmCTestReadMemoryPressure(double& pressure)
+{
+  if (const char* fake_value =
+      cmSystemTools::GetEnv("__CTEST_FAKE_MEMORY_PRESSURE_FOR_TESTING"))
+    {
+    pressure = atof(fake_value);
+    return true;
+    }
+  cmsys::ifstream fin("/proc/pressure/memory");
+  std::string line;
+  while(fin && cmSystemTools::GetLineFromStream(fin, line))
+    {
+    if(sscanf(line.c_str(), "some avg10=%lf", &pressure) == 1)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//---------------------------------------------------------
+bool cmCTestMultiProcessHandler::CheckMemoryPressure()
+{
+  double now = cmSystemTools::GetTime();
+  if(now < this->MemoryBackoffUntil)
+    {
+    if(this->RunningCount > 0)
+      {
+      return false;
+      }
+    // Nothing is running to wait on, so sleep out the back-off here
+    // rather than spin in the scheduler loop.
+    cmSystemTools::Delay(static_cast<unsigned int>(
+      (this->MemoryBackoffUntil - now) * 1000) + 1);
+    now = cmSystemTools::GetTime();
+    }
+  double pressure = 0;
+  if(this->RunningCount > 0 && cmCTestReadMemoryPressure(pressure) &&
+     pressure > 10)
+    {
+    // Back off for twice as long each time the pressure persists.
+    this->MemoryBackoff = this->MemoryBackoff > 0 ?
+      std::min(this->MemoryBackoff * 2, 30.0) : 1;
+    this->MemoryBackoffUntil = now + this->MemoryBackoff;
+    cmCTestLog(this->CTest, DEBUG, "Memory pressure is " << pressure
+               << "%, not starting tests for " << this->MemoryBackoff
+               << " seconds" << std::endl);
+    return false;
+    }
+  this->MemoryBackoff = 0;
+  return true;
+}
+
+//---------------------------------------------------------
 std::string cmCTestMultiProcessHandler::GetName(int test)
 {
   return this->Properties[test]->Name;
@@ -273,6 +433,11 @@ void cmCTestMultiProcessHandler::StartNextTests()
     return;
     }
 
+  if (this->StoppedOnFailure)
+    {
+    return;
+    }
+
   bool allTestsFailedTestLoadCheck = false;
   bool usedFakeLoadForTesting = false;
   size_t minProcessorsRequired = this->ParallelLevel;
@@ -313,6 +478,24 @@ void cmCTestMultiProcessHandler::StartNextTests()
       }
     }
 
+  unsigned long spareMemory = 0;
+  if (this->TestMemory > 0)
+    {
+    if (!this->CheckMemoryPressure())
+      {
+      return;
+      }
+    spareMemory = (this->TestMemory > this->RunningMemory ?
+                   this->TestMemory - this->RunningMemory : 0);
+    // Tests already running may not have reached their peak yet, so
+    // the host's free memory only ever lowers the budget.
+    unsigned long available = 0;
+    if (cmCTestReadAvailableMemory(available) && available < spareMemory)
+      {
+      spareMemory = available;
+      }
+    }
+
   TestList copy = this->SortedTests;
   for(TestList::iterator test = copy.begin(); test != copy.end(); ++test)
     {
@@ -346,20 +529,37 @@ void cmCTestMultiProcessHandler::StartNextTests()
         }
       }
 
+    // A test that exceeds the memory budget on its own may still run
+    // when nothing else is running.
+    unsigned long memory = this->GetMemoryRequired(*test);
+    bool testMemoryOk = true;
+    if (this->TestMemory > 0 && this->RunningCount > 0 &&
+        memory > spareMemory)
+      {
+      cmCTestLog(this->CTest, DEBUG,
+                 "Not starting " << GetName(*test) <<
+                 ", it requires " << memory <<
+                 " MB & spare memory is: " << spareMemory << " MB"
+                 << std::endl);
+      testMemoryOk = false;
+      }
+
     if (processors <= minProcessorsRequired)
       {
       minProcessorsRequired = processors;
       testWithMinProcessors = GetName(*test);
       }
 
-    if(testLoadOk && processors <= numToStart && this->StartTest(*test))
+    if(testLoadOk && testMemoryOk && processors <= numToStart &&
+       this->StartTest(*test))
       {
-      if(this->StopTimePassed)
+      if(this->StopTimePassed || this->StoppedOnFailure)
         {
         return;
         }
 
       numToStart -= processors;
+      spareMemory -= std::min(memory, spareMemory);
       }
     else if(numToStart == 0)
       {
@@ -436,9 +636,14 @@ bool cmCTestMultiProcessHandler::CheckOutput()
       {
       this->Passed->push_back(p->GetTestProperties()->Name);
       }
-    else
+    else if(p->IsKilled())
       {
       this->Failed->push_back(p->GetTestProperties()->Name);
+      this->KilledCount++;
+      }
+    else
+      {
+      this->TestFailed(test);
       }
     for(TestMap::iterator j = this->Tests.begin();
         j != this->Tests.end(); ++j)
@@ -448,9 +653,14 @@ bool cmCTestMultiProcessHandler::CheckOutput()
     this->TestFinishMap[test] = true;
     this->TestRunningMap[test] = false;
     this->RunningTests.erase(p);
-    this->WriteCheckpoint(test);
+    // A killed test did not finish and must run again on resume
+    if(!p->IsKilled())
+      {
+      this->WriteCheckpoint(test);
+      }
     this->UnlockResources(test);
     this->RunningCount -= GetProcessorsUsed(test);
+    this->ReleaseMemory(test);
     if (this->Properties[test]->RunSerial)
       {
       this->SerialTestRunning = false;
@@ -458,9 +668,33 @@ bool cmCTestMultiProcessHandler::CheckOutput()
 
     delete p;
     }
+  if(this->StoppedOnFailure && this->KillOnFailure)
+    {
+    for(std::set<cmCTestRunTest*>::const_iterator i =
+          this->RunningTests.begin(); i != this->RunningTests.end(); ++i)
+      {
+      if(!(*i)->IsKilled())
+        {
+        (*i)->Kill();
+        }
+      }
+    }
   return true;
 }
 
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::TestFailed(int test)
+{
+  this->Failed->push_back(this->Properties[test]->Name);
+  if(this->StopOnFailure && !this->StoppedOnFailure)
+    {
+    this->StoppedOnFailure = true;
+    cmCTestLog(this->CTest, HANDLER_OUTPUT, "Test "
+      << this->Properties[test]->Name << " failed, not starting any"
+      " more tests." << std::endl);
+    }
+}
+
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::UpdateCostData()
 {
@@ -482,24 +716,22 @@ void cmCTestMultiProcessHandler::UpdateCostData()
       if(line == "---") break;
       std::vector<cmsys::String> parts =
         cmSystemTools::SplitString(line, ' ');
-      //Format: <name> <previous_runs> <avg_cost>
+      //Format: <name> <previous_runs> <avg_cost> [<peak_memory_mb>
+      //        [<recent_cost>,<recent_cost>,...]]
       if(parts.size() < 3) break;
 
       std::string name = parts[0];
-      int prev = atoi(parts[1].c_str());
-      float cost = static_cast<float>(atof(parts[2].c_str()));
 
       int index = this->SearchByName(name);
       if(index == -1)
         {
         // This test is not in memory. We just rewrite the entry
-        fout << name << " " << prev << " " << cost << "\n";
+        fout << line << "\n";
         }
       else
         {
         // Update with our new average cost
-        fout << name << " " << this->Properties[index]->PreviousRuns << " "
-          << this->Properties[index]->Cost << "\n";
+        this->WriteCostData(fout, *this->Properties[index]);
         temp.erase(index);
         }
       }
@@ -510,8 +742,7 @@ void cmCTestMultiProcessHandler::UpdateCostData()
   // Add all tests not previously listed in the file
   for(PropertiesMap::iterator i = temp.begin(); i != temp.end(); ++i)
     {
-    fout << i->second->Name << " " << i->second->PreviousRuns << " "
-      << i->second->Cost << "\n";
+    this->WriteCostData(fout, *i->second);
     }
 
   // Write list of failed tests
@@ -525,6 +756,26 @@ void cmCTestMultiProcessHandler::UpdateCostData()
   cmSystemTools::RenameFile(tmpout.c_str(), fname.c_str());
 }
 
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::WriteCostData(std::ostream& fout,
+  cmCTestTestHandler::cmCTestTestProperties const& p)
+{
+  fout << p.Name << " " << p.PreviousRuns << " " << p.Cost << " "
+    << p.ObservedPeakMemory;
+  const char* sep = " ";
+  for(std::vector<float>::const_iterator i = p.RecentCosts.begin();
+      i != p.RecentCosts.end(); ++i)
+    {
+    fout << sep << *i;
+    sep = ",";
+    }
+  if(p.AdaptiveTimeouts > 0 && !p.RecentCosts.empty())
+    {
+    fout << " " << p.AdaptiveTimeouts;
+    }
+  fout << "\n";
+}
+
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::ReadCostData()
 {
@@ -556,7 +807,29 @@ void cmCTestMultiProcessHandler::ReadCostData()
       int index = this->SearchByName(name);
       if(index == -1) continue;
 
+      this->HistoricalCost[index] = cost;
       this->Properties[index]->PreviousRuns = prev;
+      if(parts.size() > 3)
+        {
+        this->Properties[index]->ObservedPeakMemory =
+          strtoul(parts[3].c_str(), 0, 10);
+        }
+      if(parts.size() > 4)
+        {
+        std::vector<cmsys::String> recent =
+          cmSystemTools::SplitString(parts[4], ',');
+        std::vector<float>& costs = this->Properties[index]->RecentCosts;
+        costs.clear();
+        for(std::vector<cmsys::String>::const_iterator i = recent.begin();
+            i != recent.end(); ++i)
+          {
+          costs.push_back(static_cast<float>(atof(i->c_str())));
+          }
+        }
+      if(parts.size() > 5)
+        {
+        this->Properties[index]->AdaptiveTimeouts = atoi(parts[5].c_str());
+        }
       // When not running in parallel mode, don't use cost data
       if(this->ParallelLevel > 1 &&
          this->Properties[index] &&
@@ -686,6 +959,189 @@ void cmCTestMultiProcessHandler::CreateParallelTestCostList()
     }
 }
 
+//---------------------------------------------------------
+static int FindShardGroup(std::map<int, int>& parent, int test)
+{
+  int root = test;
+  while(parent[root] != root)
+    {
+    root = parent[root];
+    }
+  // Compress the path so later lookups are cheap.
+  while(parent[test] != root)
+    {
+    int next = parent[test];
+    parent[test] = root;
+    test = next;
+    }
+  return root;
+}
+
+//---------------------------------------------------------
+float cmCTestMultiProcessHandler::GetShardCost(int test, float defaultCost)
+{
+  std::map<int, float>::const_iterator h = this->HistoricalCost.find(test);
+  if(h != this->HistoricalCost.end())
+    {
+    return h->second;
+    }
+  // A random schedule overwrites the COST property, so it cannot be
+  // used here without making the shards differ between machines.
+  if(this->CTest->GetScheduleType() != "Random" &&
+     this->Properties[test]->Cost > 0)
+    {
+    return this->Properties[test]->Cost;
+    }
+  return defaultCost;
+}
+
+//---------------------------------------------------------
+struct cmCTestShardGroup
+{
+  std::vector<int> Tests;
+  std::string Key;
+  double Cost;
+};
+
+struct cmCTestShardGroupMoreCostly
+{
+  bool operator()(cmCTestShardGroup const* l,
+                  cmCTestShardGroup const* r) const
+    {
+    if(l->Cost != r->Cost)
+      {
+      return l->Cost > r->Cost;
+      }
+    return l->Key < r->Key;
+    }
+};
+
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::SelectShardTests()
+{
+  // Tests connected by DEPENDS or by a shared RESOURCE_LOCK must end
+  // up on the same shard, so partition them into groups first.
+  std::map<int, int> parent;
+  for(TestMap::iterator i = this->Tests.begin(); i != this->Tests.end(); ++i)
+    {
+    parent[i->first] = i->first;
+    }
+  std::map<std::string, int> resourceOwner;
+  for(TestMap::iterator i = this->Tests.begin(); i != this->Tests.end(); ++i)
+    {
+    int root = FindShardGroup(parent, i->first);
+    for(TestSet::iterator d = i->second.begin(); d != i->second.end(); ++d)
+      {
+      int other = FindShardGroup(parent, *d);
+      parent[std::max(root, other)] = std::min(root, other);
+      root = std::min(root, other);
+      }
+    std::set<std::string> const& locks =
+      this->Properties[i->first]->LockedResources;
+    for(std::set<std::string>::const_iterator r = locks.begin();
+        r != locks.end(); ++r)
+      {
+      std::map<std::string, int>::iterator owner = resourceOwner.find(*r);
+      if(owner == resourceOwner.end())
+        {
+        resourceOwner[*r] = i->first;
+        continue;
+        }
+      int other = FindShardGroup(parent, owner->second);
+      parent[std::max(root, other)] = std::min(root, other);
+      root = std::min(root, other);
+      }
+    }
+
+  // Tests without history are assumed to take an average amount of time.
+  float defaultCost = 1;
+  if(!this->HistoricalCost.empty())
+    {
+    double sum = 0;
+    for(std::map<int, float>::const_iterator h =
+          this->HistoricalCost.begin(); h != this->HistoricalCost.end(); ++h)
+      {
+      sum += h->second;
+      }
+    defaultCost = static_cast<float>(sum / this->HistoricalCost.size());
+    }
+
+  std::map<int, cmCTestShardGroup> groups;
+  for(TestMap::iterator i = this->Tests.begin(); i != this->Tests.end(); ++i)
+    {
+    cmCTestShardGroup& g = groups[FindShardGroup(parent, i->first)];
+    std::string const& name = this->Properties[i->first]->Name;
+    if(g.Tests.empty() || name < g.Key)
+      {
+      g.Key = name;
+      }
+    if(g.Tests.empty())
+      {
+      g.Cost = 0;
+      }
+    g.Tests.push_back(i->first);
+    g.Cost += this->GetShardCost(i->first, defaultCost);
+    }
+
+  // Longest processing time first: hand out the most expensive groups
+  // first, each to the shard with the least estimated cost so far.
+  // Ties are broken by name and shard number so that every machine
+  // computes the same assignment.
+  std::vector<cmCTestShardGroup*> sortedGroups;
+  for(std::map<int, cmCTestShardGroup>::iterator g = groups.begin();
+      g != groups.end(); ++g)
+    {
+    sortedGroups.push_back(&g->second);
+    }
+  std::sort(sortedGroups.begin(), sortedGroups.end(),
+            cmCTestShardGroupMoreCostly());
+
+  std::vector<double> shardCost(this->ShardCount, 0);
+  TestSet selected;
+  double totalCost = 0;
+  for(std::vector<cmCTestShardGroup*>::iterator g = sortedGroups.begin();
+      g != sortedGroups.end(); ++g)
+    {
+    size_t shard = 0;
+    for(size_t s = 1; s < this->ShardCount; ++s)
+      {
+      if(shardCost[s] < shardCost[shard])
+        {
+        shard = s;
+        }
+      }
+    shardCost[shard] += (*g)->Cost;
+    totalCost += (*g)->Cost;
+    if(shard == this->ShardIndex)
+      {
+      selected.insert((*g)->Tests.begin(), (*g)->Tests.end());
+      }
+    }
+
+  TestList removed;
+  for(TestMap::iterator i = this->Tests.begin(); i != this->Tests.end(); ++i)
+    {
+    if(selected.find(i->first) == selected.end())
+      {
+      removed.push_back(i->first);
+      }
+    }
+  for(TestList::iterator i = removed.begin(); i != removed.end(); ++i)
+    {
+    this->Tests.erase(*i);
+    this->Properties.erase(*i);
+    this->TestRunningMap.erase(*i);
+    this->TestFinishMap.erase(*i);
+    }
+  this->Total = this->Tests.size();
+
+  cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+    "Shard " << this->ShardIndex << " of " << this->ShardCount << ": "
+    << this->Total << " tests, estimated cost "
+    << shardCost[this->ShardIndex] << " of " << totalCost << std::endl,
+    this->Quiet);
+}
+
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::GetAllTestDependencies(
     int test, TestList& dependencies)
@@ -38,6 +38,13 @@ public:
   // Set the max number of tests that can be run at the same time.
   void SetParallelLevel(size_t);
   void SetTestLoad(unsigned long load);
+  // Set the memory budget in megabytes for tests running at once.
+  void SetTestMemory(unsigned long memory);
+  // Run only the tests assigned to shard "index" out of "count" shards.
+  void SetShard(size_t index, size_t count);
+  // Stop starting tests after the first failure, and optionally kill
+  // the tests that are still running.
+  void SetStopOnFailure(bool stop, bool kill);
   virtual void RunTests();
   void PrintTestList();
   void PrintLabels();
@@ -71,6 +78,8 @@ protected:
 
   void UpdateCostData();
   void ReadCostData();
+  void WriteCostData(std::ostream& fout,
+                     cmCTestTestHandler::cmCTestTestProperties const& p);
   // Return index of a test based on its name
   int SearchByName(std::string name);
 
@@ -81,6 +90,13 @@ protected:
 
   void CreateParallelTestCostList();
 
+  // Drop all tests that do not belong to the selected shard
+  void SelectShardTests();
+  float GetShardCost(int test, float defaultCost);
+
+  // Record a failed test and stop scheduling if requested
+  void TestFailed(int test);
+
   // Removes the checkpoint file
   void MarkFinished();
   void EraseTest(int index);
@@ -94,10 +110,15 @@ protected:
   bool CheckCycles();
   int FindMaxIndex();
   inline size_t GetProcessorsUsed(int index);
+  unsigned long GetMemoryRequired(int index);
+  // Return false if new tests should not start due to memory pressure
+  bool CheckMemoryPressure();
   std::string GetName(int index);
 
   void LockResources(int index);
   void UnlockResources(int index);
+  void ReserveMemory(int index);
+  void ReleaseMemory(int index);
   // map from test number to set of depend tests
   TestMap Tests;
   TestList SortedTests;
@@ -106,6 +127,9 @@ protected:
   //Number of tests that are complete
   size_t Completed;
   size_t RunningCount;
+  // Expected memory in megabytes of the tests currently running
+  unsigned long RunningMemory;
+  std::map<int, unsigned long> ReservedMemory;
   bool StopTimePassed;
   //list of test properties (indices concurrent to the test map)
   PropertiesMap Properties;
@@ -119,6 +143,20 @@ protected:
   std::vector<cmCTestTestHandler::cmCTestTestResult>* TestResults;
   size_t ParallelLevel; // max number of process that can be run at once
   unsigned long TestLoad;
+  unsigned long TestMemory;
+  // Do not start tests before this time while memory is under pressure
+  double MemoryBackoffUntil;
+  double MemoryBackoff;
+  size_t ShardIndex;
+  size_t ShardCount;
+  bool StopOnFailure;
+  bool KillOnFailure;
+  // Set once a test failed with StopOnFailure enabled
+  bool StoppedOnFailure;
+  // Number of tests killed after a failure
+  size_t KilledCount;
+  // average cost of each test as read from the cost data file
+  std::map<int, float> HistoricalCost;
   std::set<cmCTestRunTest*> RunningTests;  // current running tests
   cmCTestTestHandler * TestHandler;
   cmCTest* CTest;
@@ -18,6 +18,15 @@
 
 #include <cm_zlib.h>
 #include <cmsys/Base64.h>
+#include <math.h>
+
+// Number of recent run times kept for each test in the cost data
+static const size_t cmCTestRecentCostCount = 20;
+// Number of recent run times needed before using an adaptive timeout
+static const size_t cmCTestRecentCostMinimum = 3;
+// Number of consecutive adaptive timeouts after which a test is run
+// once with its normal timeout
+static const int cmCTestAdaptiveTimeoutLimit = 3;
 
 cmCTestRunTest::cmCTestRunTest(cmCTestTestHandler* handler)
 {
@@ -29,6 +38,9 @@ cmCTestRunTest::cmCTestRunTest(cmCTestTestHandler* handler)
   this->TestResult.Status = cmCTestTestHandler::NOT_RUN;
   this->TestResult.TestCount = 0;
   this->TestResult.Properties = 0;
+  this->TestResult.HasResourceUsage = false;
+  memset(&this->TestResult.ResourceUsage, 0,
+         sizeof(this->TestResult.ResourceUsage));
   this->ProcessOutput = "";
   this->CompressedOutput = "";
   this->CompressionRatio = 2;
@@ -36,6 +48,8 @@ cmCTestRunTest::cmCTestRunTest(cmCTestTestHandler* handler)
   this->NumberOfRunsLeft = 1; // default to 1 run of the test
   this->RunUntilFail = false; // default to run the test once
   this->RunAgain = false;   // default to not having to run again
+  this->Killed = false;
+  this->AdaptiveTimeout = 0;
 }
 
 cmCTestRunTest::~cmCTestRunTest()
@@ -227,6 +241,16 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
       outputTestErrorsToConsole = this->CTest->OutputTestOutputOnTestFailure;
       }
     }
+  else if ( res == cmsysProcess_State_Expired && this->AdaptiveTimeout > 0 )
+    {
+    cmCTestLog(this->CTest, HANDLER_OUTPUT, "***Timeout (adaptive) ");
+    this->TestResult.Status = cmCTestTestHandler::TIMEOUT;
+    std::ostringstream msg;
+    msg << "Adaptive timeout of " << this->AdaptiveTimeout
+        << " sec exceeded.";
+    reason = msg.str();
+    outputTestErrorsToConsole = this->CTest->OutputTestOutputOnTestFailure;
+    }
   else if ( res == cmsysProcess_State_Expired )
     {
     cmCTestLog(this->CTest, HANDLER_OUTPUT, "***Timeout ");
@@ -260,6 +284,11 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
         this->TestResult.Status = cmCTestTestHandler::OTHER_FAULT;
       }
     }
+  else if ( res == cmsysProcess_State_Killed )
+    {
+    cmCTestLog(this->CTest, HANDLER_OUTPUT, "***Killed  ");
+    this->TestResult.Status = cmCTestTestHandler::NOT_RUN;
+    }
   else //cmsysProcess_State_Error
     {
     cmCTestLog(this->CTest, HANDLER_OUTPUT, "***Not Run ");
@@ -354,10 +383,13 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
       : this->ProcessOutput;
     this->TestResult.CompressOutput = compress;
     this->TestResult.ReturnValue = this->TestProcess->GetExitValue();
-    this->TestResult.CompletionStatus = "Completed";
+    this->TestResult.CompletionStatus = this->Killed ? "Killed" : "Completed";
     this->TestResult.ExecutionTime = this->TestProcess->GetTotalTime();
+    this->TestResult.HasResourceUsage = this->TestProcess->HasResourceUsage();
+    this->TestResult.ResourceUsage = this->TestProcess->GetResourceUsage();
     this->MemCheckPostProcess();
     this->ComputeWeightedCost();
+    this->ComputePeakMemory();
     }
   // If the test does not need to rerun push the current TestResult onto the
   // TestHandler vector
@@ -403,6 +435,13 @@ bool cmCTestRunTest::NeedsToRerun()
     }
   return false;
 }
+//----------------------------------------------------------------------
+void cmCTestRunTest::Kill()
+{
+  this->Killed = true;
+  this->TestProcess->Kill();
+}
+
 //----------------------------------------------------------------------
 void cmCTestRunTest::ComputeWeightedCost()
 {
@@ -410,11 +449,110 @@ void cmCTestRunTest::ComputeWeightedCost()
   double avgcost = static_cast<double>(this->TestProperties->Cost);
   double current = this->TestResult.ExecutionTime;
 
-  if(this->TestResult.Status == cmCTestTestHandler::COMPLETED)
+  // A run killed by the adaptive timeout is only counted: its time is
+  // the timeout itself and would drag the percentile of a hanging test
+  // towards the timeout.  The count lets a test that really became
+  // slower run with its normal timeout again, see
+  // ResolveAdaptiveTimeout.
+  if(this->TestResult.Status == cmCTestTestHandler::TIMEOUT &&
+     this->AdaptiveTimeout > 0)
+    {
+    this->TestProperties->AdaptiveTimeouts++;
+    return;
+    }
+  this->TestProperties->AdaptiveTimeouts = 0;
+
+  if(this->TestResult.Status != cmCTestTestHandler::COMPLETED)
+    {
+    return;
+    }
+  this->TestProperties->Cost =
+    static_cast<float>(((prev * avgcost) + current) / (prev + 1.0));
+  this->TestProperties->PreviousRuns++;
+
+  // Record the run time.
+  std::vector<float>& recent = this->TestProperties->RecentCosts;
+  recent.push_back(static_cast<float>(current));
+  if(recent.size() > cmCTestRecentCostCount)
+    {
+    recent.erase(recent.begin(), recent.end() - cmCTestRecentCostCount);
+    }
+}
+
+//----------------------------------------------------------------------
+double cmCTestRunTest::ResolveAdaptiveTimeout(double timeout)
+{
+  double factor = this->TestHandler->AdaptiveTimeout;
+  std::vector<float> recent = this->TestProperties->RecentCosts;
+  if(factor <= 0 || recent.size() < cmCTestRecentCostMinimum ||
+     (this->TestProperties->ExplicitTimeout &&
+      this->TestProperties->Timeout == 0))
+    {
+    return timeout;
+    }
+
+  // After too many adaptive timeouts in a row give the test its normal
+  // timeout once so that a test which became slower records its new
+  // run time instead of timing out forever.
+  if(this->TestProperties->AdaptiveTimeouts >= cmCTestAdaptiveTimeoutLimit)
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT, this->Index
+      << ": " << "Stopped by the adaptive timeout in the last "
+      << this->TestProperties->AdaptiveTimeouts
+      << " runs, using the normal timeout\n", this->TestHandler->GetQuiet());
+    return timeout;
+    }
+
+  // Use the nearest-rank 99th percentile of the recent run times.
+  std::sort(recent.begin(), recent.end());
+  size_t rank = static_cast<size_t>(ceil(0.99 * recent.size()));
+  double p99 = recent[rank - 1];
+  double mean = 0;
+  for(std::vector<float>::const_iterator i = recent.begin();
+      i != recent.end(); ++i)
+    {
+    mean += *i;
+    }
+  mean /= static_cast<double>(recent.size());
+
+  double adaptive = factor * p99;
+  if(adaptive < this->TestHandler->AdaptiveTimeoutFloor)
+    {
+    adaptive = this->TestHandler->AdaptiveTimeoutFloor;
+    }
+  // The configured timeout remains the ceiling.
+  double ceiling = timeout > 0 ? timeout : this->CTest->GetTimeOut();
+  cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT, this->Index << ": "
+    << "Recent run times: mean " << mean << " sec, 99th percentile "
+    << p99 << " sec\n", this->TestHandler->GetQuiet());
+  if(ceiling > 0 && adaptive >= ceiling)
+    {
+    return timeout;
+    }
+  this->AdaptiveTimeout = adaptive;
+  return adaptive;
+}
+
+//----------------------------------------------------------------------
+void cmCTestRunTest::ComputePeakMemory()
+{
+  long kb = this->TestProcess->GetResourceUsage().MaxResidentSetSize;
+  if(kb <= 0)
+    {
+    return;
+    }
+  unsigned long current = static_cast<unsigned long>((kb + 1023) / 1024);
+  unsigned long& observed = this->TestProperties->ObservedPeakMemory;
+
+  // Follow increases immediately but let the estimate decay slowly so
+  // that a single lean run does not cause overcommitting next time.
+  if(current >= observed)
+    {
+    observed = current;
+    }
+  else
     {
-    this->TestProperties->Cost =
-      static_cast<float>(((prev * avgcost) + current) / (prev + 1.0));
-    this->TestProperties->PreviousRuns++;
+    observed = (observed + current + 1) / 2;
     }
 }
 
@@ -450,6 +588,7 @@ bool cmCTestRunTest::StartTest(size_t total)
   this->TestResult.Properties = this->TestProperties;
   this->TestResult.ExecutionTime = 0;
   this->TestResult.CompressOutput = false;
+  this->TestResult.HasResourceUsage = false;
   this->TestResult.ReturnValue = -1;
   this->TestResult.CompletionStatus = "Failed to start";
   this->TestResult.Status = cmCTestTestHandler::BAD_COMMAND;
@@ -527,6 +666,8 @@ bool cmCTestRunTest::StartTest(size_t total)
     {
     return false;
     }
+  this->AdaptiveTimeout = 0;
+  timeout = this->ResolveAdaptiveTimeout(timeout);
   return this->ForkProcess(timeout, this->TestProperties->ExplicitTimeout,
                            &this->TestProperties->Environment);
 }
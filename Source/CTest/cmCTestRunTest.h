@@ -61,13 +61,21 @@ public:
 
   void ComputeWeightedCost();
 
+  void ComputePeakMemory();
+
   bool StartAgain();
+
+  // Kill the running test, it will be reported as not run
+  void Kill();
+  bool IsKilled() { return this->Killed; }
 private:
   bool NeedsToRerun();
   void DartProcessing();
   void ExeNotFound(std::string exe);
   // Figures out a final timeout which is min(STOP_TIME, NOW+TIMEOUT)
   double ResolveTimeout();
+  // Shorten the timeout based on the recent run times of the test
+  double ResolveAdaptiveTimeout(double timeout);
   bool ForkProcess(double testTimeOut, bool explicitTimeout,
                    std::vector<std::string>* environment);
   void WriteLogOutputTop(size_t completed, size_t total);
@@ -100,6 +108,9 @@ private:
   bool RunUntilFail;
   int NumberOfRunsLeft;
   bool RunAgain;
+  bool Killed;
+  // Timeout derived from recent run times, 0 if not in effect
+  double AdaptiveTimeout;
   size_t TotalNumberOfTests;
 };
 
@@ -29,6 +29,8 @@
 #include "cmSystemTools.h"
 #include "cmXMLWriter.h"
 #include "cm_utf8.h"
+#include "cm_jsoncpp_value.h"
+#include "cm_jsoncpp_writer.h"
 
 #include <stdlib.h>
 #include <math.h>
@@ -390,6 +392,14 @@ cmCTestTestHandler::cmCTestTestHandler()
 
   this->MemCheck = false;
 
+  this->ShardIndex = 0;
+  this->ShardCount = 0;
+  this->ResourceReport = 0;
+  this->StopOnFailure = false;
+  this->KillOnFailure = false;
+  this->AdaptiveTimeout = 0;
+  this->AdaptiveTimeoutFloor = 10;
+
   this->LogFile = 0;
 
   // regex to detect <DartMeasurement>...</DartMeasurement>
@@ -521,6 +531,65 @@ int cmCTestTestHandler::ProcessHandler()
     }
   this->SetRerunFailed(cmSystemTools::IsOn(this->GetOption("RerunFailed")));
 
+  this->ShardIndex = 0;
+  this->ShardCount = 0;
+  const char* shardIndex = this->GetOption("ShardIndex");
+  const char* shardCount = this->GetOption("ShardCount");
+  if ( shardIndex || shardCount )
+    {
+    unsigned long index = 0;
+    unsigned long count = 0;
+    if(!shardIndex || !shardCount ||
+       !cmSystemTools::StringToULong(shardIndex, &index) ||
+       !cmSystemTools::StringToULong(shardCount, &count) ||
+       count == 0 || index >= count)
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+        "Invalid shard specification: --shard-index must be given with "
+        "--shard-count and be in the range [0, count)." << std::endl);
+      return -1;
+      }
+    this->ShardIndex = static_cast<size_t>(index);
+    this->ShardCount = static_cast<size_t>(count);
+    }
+
+  this->ResourceReport = 0;
+  if(const char* report = this->GetOption("ResourceReport"))
+    {
+    cmSystemTools::StringToULong(report, &this->ResourceReport);
+    }
+
+  val = this->GetOption("StopOnFailure");
+  this->StopOnFailure = val && *val;
+  this->KillOnFailure = val && strcmp(val, "kill") == 0;
+
+  this->AdaptiveTimeout = 0;
+  this->AdaptiveTimeoutFloor = 10;
+  val = this->GetOption("AdaptiveTimeout");
+  if ( val )
+    {
+    char* end;
+    this->AdaptiveTimeout = strtod(val, &end);
+    if(*end || this->AdaptiveTimeout <= 0)
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+        "Invalid value for '--adaptive-timeout': " << val << std::endl);
+      return -1;
+      }
+    }
+  val = this->GetOption("AdaptiveTimeoutFloor");
+  if ( val )
+    {
+    char* end;
+    this->AdaptiveTimeoutFloor = strtod(val, &end);
+    if(*end || this->AdaptiveTimeoutFloor < 0)
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+        "Invalid value for '--adaptive-timeout-floor': " << val << std::endl);
+      return -1;
+      }
+    }
+
   this->TestResults.clear();
 
   cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
@@ -550,6 +619,11 @@ int cmCTestTestHandler::ProcessHandler()
 
   total = int(passed.size()) + int(failed.size());
 
+  if ( !this->TestResults.empty() )
+    {
+    this->WriteResourceUsage();
+    }
+
   if (total == 0)
     {
     if ( !this->CTest->GetShowOnly() && !this->CTest->ShouldPrintLabels() )
@@ -587,6 +661,10 @@ int cmCTestTestHandler::ProcessHandler()
       {
       this->PrintLabelSummary();
       }
+    if(this->ResourceReport > 0)
+      {
+      this->PrintResourceReport();
+      }
     char realBuf[1024];
     sprintf(realBuf, "%6.2f sec", (double)(clock_finish - clock_start));
     cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
@@ -739,6 +817,116 @@ void cmCTestTestHandler::PrintLabelSummary()
 
 }
 
+//----------------------------------------------------------------------
+// Order test results by the CPU time they consumed, most expensive first.
+struct cmCTestTestResultMoreCPU
+{
+  bool operator()(cmCTestTestHandler::cmCTestTestResult const* lhs,
+                  cmCTestTestHandler::cmCTestTestResult const* rhs) const
+    {
+    double l = lhs->ResourceUsage.UserTime + lhs->ResourceUsage.SystemTime;
+    double r = rhs->ResourceUsage.UserTime + rhs->ResourceUsage.SystemTime;
+    if(l != r)
+      {
+      return l > r;
+      }
+    if(lhs->ResourceUsage.MaxResidentSetSize !=
+       rhs->ResourceUsage.MaxResidentSetSize)
+      {
+      return lhs->ResourceUsage.MaxResidentSetSize >
+        rhs->ResourceUsage.MaxResidentSetSize;
+      }
+    return lhs->Name < rhs->Name;
+    }
+};
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::PrintResourceReport()
+{
+  std::vector<cmCTestTestResult const*> results;
+  for(TestResultsVector::const_iterator ri = this->TestResults.begin();
+      ri != this->TestResults.end(); ++ri)
+    {
+    if(ri->HasResourceUsage)
+      {
+      results.push_back(&*ri);
+      }
+    }
+  if(results.empty())
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
+      "\nNo resource usage was recorded for the tests.\n", this->Quiet);
+    return;
+    }
+  std::sort(results.begin(), results.end(), cmCTestTestResultMoreCPU());
+  if(results.size() > this->ResourceReport)
+    {
+    results.resize(this->ResourceReport);
+    }
+
+  cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
+    "\nResource Usage Summary (top " << results.size() << " by CPU time):\n"
+    "  User(s)  System(s)  Peak(MB)  Vol. CS  Invol. CS   I/O(MB)  Test\n",
+    this->Quiet);
+  for(std::vector<cmCTestTestResult const*>::const_iterator i =
+        results.begin(); i != results.end(); ++i)
+    {
+    cmsysProcess_ResourceUsage const& ru = (*i)->ResourceUsage;
+    double io = 512.0 *
+      static_cast<double>(ru.BlockInputOperations + ru.BlockOutputOperations);
+    char buf[1024];
+    sprintf(buf, "%9.2f %10.2f %9.1f %8ld %10ld %9.1f  ",
+            ru.UserTime, ru.SystemTime,
+            static_cast<double>(ru.MaxResidentSetSize) / 1024.0,
+            ru.VoluntaryContextSwitches, ru.InvoluntaryContextSwitches,
+            io / (1024.0 * 1024.0));
+    cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
+      buf << (*i)->Name << "\n", this->Quiet);
+    if(this->LogFile)
+      {
+      *this->LogFile << buf << (*i)->Name << "\n";
+      }
+    }
+}
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::WriteResourceUsage()
+{
+  Json::Value root(Json::objectValue);
+  Json::Value& tests = root["tests"] = Json::arrayValue;
+  for(TestResultsVector::const_iterator ri = this->TestResults.begin();
+      ri != this->TestResults.end(); ++ri)
+    {
+    Json::Value& test = tests.append(Json::objectValue);
+    test["name"] = ri->Name;
+    test["status"] = this->GetTestStatus(ri->Status);
+    test["executionTime"] = ri->ExecutionTime;
+    if(!ri->HasResourceUsage)
+      {
+      continue;
+      }
+    cmsysProcess_ResourceUsage const& ru = ri->ResourceUsage;
+    test["userTime"] = ru.UserTime;
+    test["systemTime"] = ru.SystemTime;
+    test["peakMemoryKB"] =
+      static_cast<Json::Value::LargestInt>(ru.MaxResidentSetSize);
+    test["voluntaryContextSwitches"] =
+      static_cast<Json::Value::LargestInt>(ru.VoluntaryContextSwitches);
+    test["involuntaryContextSwitches"] =
+      static_cast<Json::Value::LargestInt>(ru.InvoluntaryContextSwitches);
+    // The system counts block operations in units of 512 bytes.
+    test["bytesRead"] =
+      static_cast<Json::Value::LargestInt>(ru.BlockInputOperations) * 512;
+    test["bytesWritten"] =
+      static_cast<Json::Value::LargestInt>(ru.BlockOutputOperations) * 512;
+    }
+
+  std::string fname = this->CTest->GetBinaryDir()
+    + "/Testing/Temporary/CTestResourceUsage.json";
+  cmGeneratedFileStream fout(fname.c_str());
+  fout << root;
+}
+
 //----------------------------------------------------------------------
 void cmCTestTestHandler::CheckLabelFilterInclude(cmCTestTestProperties& it)
 {
@@ -1075,6 +1263,8 @@ void cmCTestTestHandler::ProcessDirectory(std::vector<std::string> &passed,
   parallel->SetParallelLevel(this->CTest->GetParallelLevel());
   parallel->SetTestHandler(this);
   parallel->SetQuiet(this->Quiet);
+  parallel->SetShard(this->ShardIndex, this->ShardCount);
+  parallel->SetStopOnFailure(this->StopOnFailure, this->KillOnFailure);
   if(this->TestLoad > 0)
     {
     parallel->SetTestLoad(this->TestLoad);
@@ -1083,6 +1273,7 @@ void cmCTestTestHandler::ProcessDirectory(std::vector<std::string> &passed,
     {
     parallel->SetTestLoad(this->CTest->GetTestLoad());
     }
+  parallel->SetTestMemory(this->CTest->GetTestMemory());
 
   *this->LogFile << "Start testing: "
     << this->CTest->CurrentTime() << std::endl
@@ -1211,6 +1402,10 @@ void cmCTestTestHandler::GenerateDartOutput(cmXMLWriter& xml)
       xml.Attribute("name", "Execution Time");
       xml.Element("Value", result->ExecutionTime);
       xml.EndElement(); // NamedMeasurement
+      if(result->HasResourceUsage)
+        {
+        this->GenerateResourceUsage(xml, result->ResourceUsage);
+        }
       if(!result->Reason.empty())
         {
         const char* reasonType = "Pass Reason";
@@ -1271,6 +1466,44 @@ void cmCTestTestHandler::GenerateDartOutput(cmXMLWriter& xml)
   this->CTest->EndXML(xml);
 }
 
+//----------------------------------------------------------------------------
+void cmCTestTestHandler::GenerateResourceUsage(cmXMLWriter& xml,
+  cmsysProcess_ResourceUsage const& ru)
+{
+  xml.StartElement("NamedMeasurement");
+  xml.Attribute("type", "numeric/double");
+  xml.Attribute("name", "CPU User Time");
+  xml.Element("Value", ru.UserTime);
+  xml.EndElement(); // NamedMeasurement
+  xml.StartElement("NamedMeasurement");
+  xml.Attribute("type", "numeric/double");
+  xml.Attribute("name", "CPU System Time");
+  xml.Element("Value", ru.SystemTime);
+  xml.EndElement(); // NamedMeasurement
+
+  // The system counts block operations in units of 512 bytes.
+  struct { const char* Name; double Value; } counts[] =
+    {
+      {"Peak Memory (KB)", static_cast<double>(ru.MaxResidentSetSize)},
+      {"Voluntary Context Switches",
+       static_cast<double>(ru.VoluntaryContextSwitches)},
+      {"Involuntary Context Switches",
+       static_cast<double>(ru.InvoluntaryContextSwitches)},
+      {"Bytes Read", 512.0 * static_cast<double>(ru.BlockInputOperations)},
+      {"Bytes Written", 512.0 * static_cast<double>(ru.BlockOutputOperations)}
+    };
+  for(size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+    {
+    char buf[64];
+    sprintf(buf, "%.0f", counts[i].Value);
+    xml.StartElement("NamedMeasurement");
+    xml.Attribute("type", "numeric/integer");
+    xml.Attribute("name", counts[i].Name);
+    xml.Element("Value", buf);
+    xml.EndElement(); // NamedMeasurement
+    }
+}
+
 //----------------------------------------------------------------------------
 void cmCTestTestHandler::WriteTestResultHeader(cmXMLWriter& xml,
                                                cmCTestTestResult* result)
@@ -2204,6 +2437,14 @@ bool cmCTestTestHandler::SetTestsProperties(
               rtit->Processors = 1;
               }
             }
+          if ( key == "PEAK_MEMORY" )
+            {
+            unsigned long memory = 0;
+            if(cmSystemTools::StringToULong(val.c_str(), &memory))
+              {
+              rtit->PeakMemory = memory;
+              }
+            }
           if ( key == "SKIP_RETURN_CODE" )
             {
             rtit->SkipReturnCode = atoi(val.c_str());
@@ -2330,8 +2571,11 @@ bool cmCTestTestHandler::AddTest(const std::vector<std::string>& args)
   test.ExplicitTimeout = false;
   test.Cost = 0;
   test.Processors = 1;
+  test.PeakMemory = 0;
+  test.ObservedPeakMemory = 0;
   test.SkipReturnCode = -1;
   test.PreviousRuns = 0;
+  test.AdaptiveTimeouts = 0;
   if (this->UseIncludeRegExpFlag &&
     !this->IncludeTestsRegularExpression.find(testname.c_str()))
     {
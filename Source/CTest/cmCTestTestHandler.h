@@ -16,6 +16,7 @@
 
 #include "cmCTestGenericHandler.h"
 #include <cmsys/RegularExpression.hxx>
+#include <cmsys/Process.h>
 
 class cmMakefile;
 class cmXMLWriter;
@@ -104,12 +105,19 @@ public:
     bool WillFail;
     float Cost;
     int PreviousRuns;
+    // Run times of the most recent runs, oldest first
+    std::vector<float> RecentCosts;
+    // Number of consecutive runs stopped by the adaptive timeout
+    int AdaptiveTimeouts;
     bool RunSerial;
     double Timeout;
     bool ExplicitTimeout;
     int Index;
     //Requested number of process slots
     int Processors;
+    //Expected peak memory in megabytes, declared and observed
+    unsigned long PeakMemory;
+    unsigned long ObservedPeakMemory;
     // return code of test which will mark test as "not run"
     int SkipReturnCode;
     std::vector<std::string> Environment;
@@ -132,6 +140,9 @@ public:
     std::string DartString;
     int         TestCount;
     cmCTestTestProperties* Properties;
+    // Resources consumed by the test process, if the platform reports them
+    bool        HasResourceUsage;
+    cmsysProcess_ResourceUsage ResourceUsage;
   };
 
   struct cmCTestTestResultLess
@@ -207,7 +218,14 @@ private:
    */
   virtual void GenerateDartOutput(cmXMLWriter& xml);
 
+  // Write the resource usage of a test as named measurements
+  void GenerateResourceUsage(cmXMLWriter& xml,
+                             cmsysProcess_ResourceUsage const& ru);
   void PrintLabelSummary();
+  // Print the tests that consumed the most resources
+  void PrintResourceReport();
+  // Write the per-test resource usage to a JSON summary file
+  void WriteResourceUsage();
   /**
    * Run the tests for a directory and any subdirectories
    */
@@ -286,6 +304,23 @@ private:
   std::ostream* LogFile;
 
   bool RerunFailed;
+
+  // Run only the tests of shard ShardIndex out of ShardCount
+  size_t ShardIndex;
+  size_t ShardCount;
+
+  // Number of top consumers to list in the resource report, 0 for none
+  unsigned long ResourceReport;
+
+  // Stop starting tests after the first failure, optionally killing
+  // the tests that are still running
+  bool StopOnFailure;
+  bool KillOnFailure;
+
+  // Limit tests to AdaptiveTimeout times the 99th percentile of their
+  // recent run times, but never below AdaptiveTimeoutFloor seconds
+  double AdaptiveTimeout;
+  double AdaptiveTimeoutFloor;
 };
 
 #endif
@@ -21,6 +21,8 @@ cmProcess::cmProcess()
   this->ExitValue = 0;
   this->Id = 0;
   this->StartTime = 0;
+  this->HaveResourceUsage = false;
+  memset(&this->ResourceUsage, 0, sizeof(this->ResourceUsage));
 }
 
 cmProcess::~cmProcess()
@@ -163,6 +165,8 @@ int cmProcess::GetNextOutputLine(std::string& line, double timeout)
 
   // Record exit information.
   this->ExitValue = cmsysProcess_GetExitValue(this->Process);
+  this->HaveResourceUsage =
+    cmsysProcess_GetResourceUsage(this->Process, &this->ResourceUsage) != 0;
   this->TotalTime = cmSystemTools::GetTime() - this->StartTime;
   // Because of a processor clock scew the runtime may become slightly
   // negative. If someone changed the system clock while the process was
@@ -263,6 +267,11 @@ int cmProcess::ReportStatus()
 }
 
 
+void cmProcess::Kill()
+{
+  cmsysProcess_Kill(this->Process);
+}
+
 int cmProcess::GetExitException()
 {
   return cmsysProcess_GetExitException(this->Process);
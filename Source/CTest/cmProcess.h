@@ -43,7 +43,13 @@ public:
   void SetId(int id) { this->Id = id;}
   int GetExitValue() { return this->ExitValue;}
   double GetTotalTime() { return this->TotalTime;}
+  // Resources used by the process, valid once it has exited
+  bool HasResourceUsage() { return this->HaveResourceUsage; }
+  cmsysProcess_ResourceUsage const& GetResourceUsage()
+    { return this->ResourceUsage; }
   int GetExitException();
+  // Kill the process if it is still running
+  void Kill();
   /**
    * Read one line of output but block for no more than timeout.
    * Returns:
@@ -56,6 +62,8 @@ private:
   double Timeout;
   double StartTime;
   double TotalTime;
+  bool HaveResourceUsage;
+  cmsysProcess_ResourceUsage ResourceUsage;
   cmsysProcess* Process;
   class Buffer: public std::vector<char>
   {
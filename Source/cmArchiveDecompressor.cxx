@@ -0,0 +1,527 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2015 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmArchiveDecompressor.h"
+
+#include <cm_libarchive.h>
+
+#if defined(CMAKE_USE_PTHREADS)
+# include "cm_zlib.h"
+# include "cm_lzma.h"
+# include <pthread.h>
+# include <errno.h>
+# include <fcntl.h>
+# include <stdlib.h>
+# include <string.h>
+# include <sys/stat.h>
+# include <unistd.h>
+
+// Parts larger than this are not decompressed in memory.
+#define CM_ARCHIVE_DECOMPRESSOR_MAX_PART (256 << 20)
+
+//----------------------------------------------------------------------------
+// A part of the file that decompresses on its own.
+struct cmArchiveDecompressorPart
+{
+  off_t Offset;
+  size_t Size;
+  size_t OutputSize;
+  // The xz integrity check and unpadded block size, unused for gzip.
+  int Check;
+  lzma_vli UnpaddedSize;
+  std::string Output;
+  std::string Error;
+  bool Done;
+  bool Failed;
+};
+
+//----------------------------------------------------------------------------
+class cmArchiveDecompressorInternals
+{
+public:
+  cmArchiveDecompressorInternals(int fd);
+  ~cmArchiveDecompressorInternals();
+
+  bool ReadAt(off_t offset, void* buffer, size_t n) const;
+  bool FindGZipMembers(off_t fileSize);
+  bool FindXZBlocks(off_t fileSize);
+  bool Start(unsigned int threads);
+
+  // libarchive callbacks
+  static __LA_SSIZE_T Read(struct archive* a, void* cd, const void** buffer);
+  static int Close(struct archive*, void*) { return ARCHIVE_OK; }
+
+  bool IsGZip;
+  std::vector<cmArchiveDecompressorPart> Parts;
+
+private:
+  static void* Run(void* self);
+  void Work();
+  bool Decompress(cmArchiveDecompressorPart& part) const;
+  bool DecompressGZip(std::string const& in,
+                      cmArchiveDecompressorPart& part) const;
+  bool DecompressXZ(std::string const& in,
+                    cmArchiveDecompressorPart& part) const;
+
+  int File;
+  size_t NextWork;  // The next part to decompress.
+  size_t NextRead;  // The next part to hand to libarchive.
+  size_t MaxAhead;
+  bool Stop;
+  std::vector<pthread_t> Threads;
+  pthread_mutex_t Mutex;
+  pthread_cond_t WorkCond;
+  pthread_cond_t DoneCond;
+};
+
+//----------------------------------------------------------------------------
+cmArchiveDecompressorInternals::cmArchiveDecompressorInternals(int fd):
+  IsGZip(false), File(fd), NextWork(0), NextRead(0), MaxAhead(0), Stop(false)
+{
+  pthread_mutex_init(&this->Mutex, 0);
+  pthread_cond_init(&this->WorkCond, 0);
+  pthread_cond_init(&this->DoneCond, 0);
+}
+
+//----------------------------------------------------------------------------
+cmArchiveDecompressorInternals::~cmArchiveDecompressorInternals()
+{
+  pthread_mutex_lock(&this->Mutex);
+  this->Stop = true;
+  pthread_cond_broadcast(&this->WorkCond);
+  pthread_mutex_unlock(&this->Mutex);
+  for(std::vector<pthread_t>::const_iterator ti = this->Threads.begin();
+      ti != this->Threads.end(); ++ti)
+    {
+    pthread_join(*ti, 0);
+    }
+  pthread_cond_destroy(&this->DoneCond);
+  pthread_cond_destroy(&this->WorkCond);
+  pthread_mutex_destroy(&this->Mutex);
+  close(this->File);
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDecompressorInternals::ReadAt(off_t offset, void* buffer,
+                                            size_t n) const
+{
+  char* p = static_cast<char*>(buffer);
+  while(n > 0)
+    {
+    ssize_t r = pread(this->File, p, n, offset);
+    if(r < 0 && errno == EINTR)
+      {
+      continue;
+      }
+    if(r <= 0)
+      {
+      return false;
+      }
+    p += r;
+    n -= static_cast<size_t>(r);
+    offset += r;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDecompressorInternals::FindGZipMembers(off_t fileSize)
+{
+  // Each member written by cmArchiveWrite starts with an extra field
+  // whose first subfield, "CM", holds the size of the member.  Walk
+  // from member to member and give up at one without it.
+  this->IsGZip = true;
+  off_t pos = 0;
+  while(pos < fileSize)
+    {
+    unsigned char h[20];
+    if(fileSize - pos < 28 || !this->ReadAt(pos, h, sizeof(h)))
+      {
+      return false;
+      }
+    if(h[0] != 0x1f || h[1] != 0x8b || h[2] != 8 || !(h[3] & 4) ||
+       (h[10] | (h[11] << 8)) < 8 ||
+       h[12] != 'C' || h[13] != 'M' || h[14] != 4 || h[15] != 0)
+      {
+      return false;
+      }
+    size_t size = static_cast<size_t>(h[16]) | (h[17] << 8) |
+      (h[18] << 16) | (static_cast<size_t>(h[19]) << 24);
+    if(size < 28 || static_cast<off_t>(size) > fileSize - pos)
+      {
+      return false;
+      }
+    // The trailer ends with the size of the data modulo 2^32.
+    unsigned char t[4];
+    if(!this->ReadAt(pos + static_cast<off_t>(size) - 4, t, sizeof(t)))
+      {
+      return false;
+      }
+    cmArchiveDecompressorPart part;
+    part.Offset = pos;
+    part.Size = size;
+    part.OutputSize = static_cast<size_t>(t[0]) | (t[1] << 8) |
+      (t[2] << 16) | (static_cast<size_t>(t[3]) << 24);
+    part.Check = 0;
+    part.UnpaddedSize = 0;
+    part.Done = false;
+    part.Failed = false;
+    if(part.OutputSize > CM_ARCHIVE_DECOMPRESSOR_MAX_PART)
+      {
+      return false;
+      }
+    this->Parts.push_back(part);
+    pos += static_cast<off_t>(size);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDecompressorInternals::FindXZBlocks(off_t fileSize)
+{
+  // Decode the index of each stream from the end of the file, as
+  // "xz --list" does, to find where every block starts.
+  lzma_index* combined = 0;
+  off_t pos = fileSize;
+  bool okay = true;
+  while(okay && pos > 0)
+    {
+    uint8_t buf[LZMA_STREAM_HEADER_SIZE];
+
+    // Skip the stream padding.
+    lzma_vli padding = 0;
+    for(;;)
+      {
+      if(pos < 2 * LZMA_STREAM_HEADER_SIZE || !this->ReadAt(pos - 4, buf, 4))
+        {
+        okay = false;
+        break;
+        }
+      if(buf[0] || buf[1] || buf[2] || buf[3])
+        {
+        break;
+        }
+      pos -= 4;
+      padding += 4;
+      }
+
+    // Read the footer and index of the stream.
+    lzma_stream_flags footer;
+    if(!okay ||
+       !this->ReadAt(pos - LZMA_STREAM_HEADER_SIZE, buf, sizeof(buf)) ||
+       lzma_stream_footer_decode(&footer, buf) != LZMA_OK ||
+       static_cast<lzma_vli>(pos) <
+       2 * LZMA_STREAM_HEADER_SIZE + footer.backward_size)
+      {
+      okay = false;
+      break;
+      }
+    std::string indexData(static_cast<size_t>(footer.backward_size), '\0');
+    off_t indexPos = pos - LZMA_STREAM_HEADER_SIZE -
+      static_cast<off_t>(footer.backward_size);
+    lzma_index* index = 0;
+    uint64_t memlimit = UINT64_MAX;
+    size_t inPos = 0;
+    if(!this->ReadAt(indexPos, &indexData[0], indexData.size()) ||
+       lzma_index_buffer_decode(&index, &memlimit, 0,
+                                reinterpret_cast<uint8_t*>(&indexData[0]),
+                                &inPos, indexData.size()) != LZMA_OK)
+      {
+      okay = false;
+      break;
+      }
+
+    // Check the header at the start of the stream.
+    lzma_vli streamSize = lzma_index_stream_size(index);
+    lzma_stream_flags header;
+    if(static_cast<lzma_vli>(pos) < streamSize ||
+       !this->ReadAt(pos - static_cast<off_t>(streamSize), buf, sizeof(buf)) ||
+       lzma_stream_header_decode(&header, buf) != LZMA_OK ||
+       lzma_stream_flags_compare(&header, &footer) != LZMA_OK ||
+       lzma_index_stream_flags(index, &footer) != LZMA_OK ||
+       lzma_index_stream_padding(index, padding) != LZMA_OK ||
+       (combined && lzma_index_cat(index, combined, 0) != LZMA_OK))
+      {
+      lzma_index_end(index, 0);
+      okay = false;
+      break;
+      }
+    combined = index;
+    pos -= static_cast<off_t>(streamSize);
+    }
+
+  if(okay && combined)
+    {
+    lzma_index_iter iter;
+    lzma_index_iter_init(&iter, combined);
+    while(okay && !lzma_index_iter_next(&iter, LZMA_INDEX_ITER_BLOCK))
+      {
+      cmArchiveDecompressorPart part;
+      part.Offset = static_cast<off_t>(iter.block.compressed_file_offset);
+      part.Size = static_cast<size_t>(iter.block.total_size);
+      part.OutputSize = static_cast<size_t>(iter.block.uncompressed_size);
+      part.Check = iter.stream.flags->check;
+      part.UnpaddedSize = iter.block.unpadded_size;
+      part.Done = false;
+      part.Failed = false;
+      okay = iter.block.uncompressed_size <= CM_ARCHIVE_DECOMPRESSOR_MAX_PART;
+      this->Parts.push_back(part);
+      }
+    }
+  if(combined)
+    {
+    lzma_index_end(combined, 0);
+    }
+  return okay;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDecompressorInternals::Start(unsigned int threads)
+{
+  // Bound the memory held by the parts decompressed ahead of the reader.
+  this->MaxAhead = 2 * threads;
+  for(unsigned int i = 0; i < threads; ++i)
+    {
+    pthread_t thread;
+    if(pthread_create(&thread, 0, &cmArchiveDecompressorInternals::Run,
+                      this) == 0)
+      {
+      this->Threads.push_back(thread);
+      }
+    }
+  return !this->Threads.empty();
+}
+
+//----------------------------------------------------------------------------
+void* cmArchiveDecompressorInternals::Run(void* self)
+{
+  static_cast<cmArchiveDecompressorInternals*>(self)->Work();
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void cmArchiveDecompressorInternals::Work()
+{
+  pthread_mutex_lock(&this->Mutex);
+  for(;;)
+    {
+    while(!this->Stop && this->NextWork < this->Parts.size() &&
+          this->NextWork >= this->NextRead + this->MaxAhead)
+      {
+      pthread_cond_wait(&this->WorkCond, &this->Mutex);
+      }
+    if(this->Stop || this->NextWork >= this->Parts.size())
+      {
+      break;
+      }
+    cmArchiveDecompressorPart& part = this->Parts[this->NextWork++];
+    pthread_mutex_unlock(&this->Mutex);
+    bool okay = this->Decompress(part);
+    pthread_mutex_lock(&this->Mutex);
+    part.Failed = !okay;
+    part.Done = true;
+    pthread_cond_broadcast(&this->DoneCond);
+    }
+  pthread_mutex_unlock(&this->Mutex);
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDecompressorInternals::Decompress(
+  cmArchiveDecompressorPart& part) const
+{
+  std::string in(part.Size, '\0');
+  if(!this->ReadAt(part.Offset, &in[0], in.size()))
+    {
+    part.Error = "Cannot read the compressed data";
+    return false;
+    }
+  // Leave room for one more byte so that even an empty part has a
+  // valid output buffer.
+  part.Output.resize(part.OutputSize + 1);
+  bool okay = this->IsGZip? this->DecompressGZip(in, part) :
+    this->DecompressXZ(in, part);
+  part.Output.resize(okay? part.OutputSize : 0);
+  return okay;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDecompressorInternals::DecompressGZip(
+  std::string const& in, cmArchiveDecompressorPart& part) const
+{
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  // Add 16 to the window bits to read a gzip header and trailer.
+  if(inflateInit2(&strm, 15 + 16) != Z_OK)
+    {
+    part.Error = "Cannot initialize the gzip decompression";
+    return false;
+    }
+  strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  strm.avail_in = static_cast<uInt>(in.size());
+  strm.next_out = reinterpret_cast<Bytef*>(&part.Output[0]);
+  strm.avail_out = static_cast<uInt>(part.Output.size());
+  int res = inflate(&strm, Z_FINISH);
+  bool okay = res == Z_STREAM_END && strm.avail_in == 0 &&
+    strm.total_out == part.OutputSize;
+  inflateEnd(&strm);
+  if(!okay)
+    {
+    part.Error = "Corrupt gzip member";
+    }
+  return okay;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDecompressorInternals::DecompressXZ(
+  std::string const& in, cmArchiveDecompressorPart& part) const
+{
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(in.data());
+  lzma_filter filters[LZMA_FILTERS_MAX + 1];
+  lzma_block block;
+  memset(&block, 0, sizeof(block));
+  block.version = 0;
+  block.check = static_cast<lzma_check>(part.Check);
+  block.filters = filters;
+  block.header_size = lzma_block_header_size_decode(data[0]);
+  if(block.header_size > in.size() ||
+     lzma_block_header_decode(&block, 0, data) != LZMA_OK)
+    {
+    part.Error = "Corrupt xz block header";
+    return false;
+    }
+  size_t inPos = block.header_size;
+  size_t outPos = 0;
+  lzma_ret res = lzma_block_compressed_size(&block, part.UnpaddedSize);
+  if(res == LZMA_OK)
+    {
+    res = lzma_block_buffer_decode(
+      &block, 0, data, &inPos, in.size(),
+      reinterpret_cast<uint8_t*>(&part.Output[0]), &outPos,
+      part.Output.size());
+    }
+  for(lzma_filter* f = filters; f->id != LZMA_VLI_UNKNOWN; ++f)
+    {
+    free(f->options);
+    }
+  if(res != LZMA_OK || outPos != part.OutputSize)
+    {
+    part.Error = "Corrupt xz block";
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+__LA_SSIZE_T cmArchiveDecompressorInternals::Read(struct archive* a,
+                                                  void* cd,
+                                                  const void** buffer)
+{
+  cmArchiveDecompressorInternals* self =
+    static_cast<cmArchiveDecompressorInternals*>(cd);
+  for(;;)
+    {
+    // Release the part libarchive is done with.
+    if(self->NextRead > 0)
+      {
+      std::string().swap(self->Parts[self->NextRead - 1].Output);
+      }
+    if(self->NextRead == self->Parts.size())
+      {
+      return 0;
+      }
+    cmArchiveDecompressorPart& part = self->Parts[self->NextRead];
+    pthread_mutex_lock(&self->Mutex);
+    while(!part.Done)
+      {
+      pthread_cond_wait(&self->DoneCond, &self->Mutex);
+      }
+    ++self->NextRead;
+    pthread_cond_broadcast(&self->WorkCond);
+    pthread_mutex_unlock(&self->Mutex);
+    if(part.Failed)
+      {
+      archive_set_error(a, EIO, "%s at offset %lld",
+                        part.Error.c_str(),
+                        static_cast<long long>(part.Offset));
+      return ARCHIVE_FATAL;
+      }
+    // An empty part would look like the end of the data.
+    if(!part.Output.empty())
+      {
+      *buffer = part.Output.data();
+      return static_cast<__LA_SSIZE_T>(part.Output.size());
+      }
+    }
+}
+#else
+class cmArchiveDecompressorInternals {};
+#endif
+
+//----------------------------------------------------------------------------
+cmArchiveDecompressor::cmArchiveDecompressor(unsigned int threads):
+  Internal(0), Threads(threads)
+{
+}
+
+//----------------------------------------------------------------------------
+cmArchiveDecompressor::~cmArchiveDecompressor()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDecompressor::Open(struct archive* a, const char* file)
+{
+#if defined(CMAKE_USE_PTHREADS)
+  if(this->Threads < 2 || this->Internal)
+    {
+    return false;
+    }
+  int fd = open(file, O_RDONLY);
+  if(fd < 0)
+    {
+    return false;
+    }
+  struct stat st;
+  cmArchiveDecompressorInternals* internal =
+    new cmArchiveDecompressorInternals(fd);
+  unsigned char magic[6];
+  bool split = false;
+  if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+     internal->ReadAt(0, magic, sizeof(magic)))
+    {
+    if(magic[0] == 0x1f && magic[1] == 0x8b)
+      {
+      split = internal->FindGZipMembers(st.st_size);
+      }
+    else if(memcmp(magic, "\xFD" "7zXZ", 6) == 0)
+      {
+      split = internal->FindXZBlocks(st.st_size);
+      }
+    }
+  // A single part is read as fast by libarchive itself.
+  if(!split || internal->Parts.size() < 2 || !internal->Start(this->Threads))
+    {
+    delete internal;
+    return false;
+    }
+  this->Internal = internal;
+  // A failure to open is reported by the archive when it is read.
+  archive_read_open(a, internal, 0,
+                    &cmArchiveDecompressorInternals::Read,
+                    &cmArchiveDecompressorInternals::Close);
+  return true;
+#else
+  (void)a;
+  (void)file;
+  return false;
+#endif
+}
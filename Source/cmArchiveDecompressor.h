@@ -0,0 +1,52 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2015 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#ifndef cmArchiveDecompressor_h
+#define cmArchiveDecompressor_h
+
+#include "cmStandardIncludes.h"
+
+struct archive;
+class cmArchiveDecompressorInternals;
+
+/** \class cmArchiveDecompressor
+ * \brief Decompress an archive file on several threads for libarchive.
+ *
+ * Compressed files made of independent parts can be decompressed in
+ * parallel: gzip files whose members record their own size, as written
+ * by cmArchiveWrite, and xz files with several blocks or streams.  The
+ * parts are decompressed by a pool of threads and handed to libarchive
+ * in order.
+ */
+class cmArchiveDecompressor
+{
+public:
+  cmArchiveDecompressor(unsigned int threads);
+  ~cmArchiveDecompressor();
+
+  /**
+   * Open the given file for reading by the archive if it can be split
+   * into parts.  Returns false, leaving the archive alone, if the file
+   * cannot be decompressed in parallel.  The decompressor must live as
+   * long as the archive is read.
+   */
+  bool Open(struct archive* a, const char* file);
+
+private:
+  cmArchiveDecompressor(cmArchiveDecompressor const&);
+  void operator=(cmArchiveDecompressor const&);
+
+  // Internal implementation details.
+  cmArchiveDecompressorInternals* Internal;
+  unsigned int Threads;
+};
+
+#endif
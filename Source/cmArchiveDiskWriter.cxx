@@ -0,0 +1,389 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2015 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmArchiveDiskWriter.h"
+
+#include "cmSystemTools.h"
+#include <cm_libarchive.h>
+
+#if defined(CMAKE_USE_PTHREADS)
+# include <deque>
+# include <set>
+# include <pthread.h>
+# include <errno.h>
+# include <fcntl.h>
+# include <string.h>
+# include <sys/stat.h>
+# include <sys/time.h>
+# include <unistd.h>
+
+// Larger files are extracted by libarchive as they are read.
+#define CM_ARCHIVE_DISK_WRITER_MAX_FILE (4 << 20)
+// The data of the queued files held in memory at most.
+#define CM_ARCHIVE_DISK_WRITER_MAX_PENDING (64 << 20)
+
+//----------------------------------------------------------------------------
+struct cmArchiveDiskWriterFile
+{
+  std::string Path;
+  std::string Data;
+  mode_t Mode;
+  struct timeval Times[2];
+};
+
+//----------------------------------------------------------------------------
+class cmArchiveDiskWriterInternals
+{
+public:
+  cmArchiveDiskWriterInternals(unsigned int threads);
+  ~cmArchiveDiskWriterInternals();
+  bool Okay() const { return !this->Threads.empty(); }
+  void Queue(cmArchiveDiskWriterFile* file);
+  bool Wait(std::string& error);
+  bool Failed();
+
+  // The files queued since the last wait, and the directories created.
+  std::set<std::string> Paths;
+  std::set<std::string> Directories;
+
+private:
+  static void* Run(void* self);
+  void Work();
+  static bool Write(cmArchiveDiskWriterFile const& file, std::string& error);
+  static size_t Cost(cmArchiveDiskWriterFile const& file)
+    {
+    // Count some memory for each file so that empty ones are bounded too.
+    return file.Data.size() + 1024;
+    }
+
+  std::deque<cmArchiveDiskWriterFile*> Jobs;
+  size_t Pending;
+  size_t Active;
+  bool Stop;
+  std::string Error;
+  std::vector<pthread_t> Threads;
+  pthread_mutex_t Mutex;
+  pthread_cond_t WorkCond;
+  pthread_cond_t DoneCond;
+};
+
+//----------------------------------------------------------------------------
+cmArchiveDiskWriterInternals::cmArchiveDiskWriterInternals(
+  unsigned int threads): Pending(0), Active(0), Stop(false)
+{
+  pthread_mutex_init(&this->Mutex, 0);
+  pthread_cond_init(&this->WorkCond, 0);
+  pthread_cond_init(&this->DoneCond, 0);
+  for(unsigned int i = 0; i < threads; ++i)
+    {
+    pthread_t thread;
+    if(pthread_create(&thread, 0, &cmArchiveDiskWriterInternals::Run,
+                      this) == 0)
+      {
+      this->Threads.push_back(thread);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+cmArchiveDiskWriterInternals::~cmArchiveDiskWriterInternals()
+{
+  // The threads write the queued files before they stop.
+  pthread_mutex_lock(&this->Mutex);
+  this->Stop = true;
+  pthread_cond_broadcast(&this->WorkCond);
+  pthread_mutex_unlock(&this->Mutex);
+  for(std::vector<pthread_t>::const_iterator ti = this->Threads.begin();
+      ti != this->Threads.end(); ++ti)
+    {
+    pthread_join(*ti, 0);
+    }
+  pthread_cond_destroy(&this->DoneCond);
+  pthread_cond_destroy(&this->WorkCond);
+  pthread_mutex_destroy(&this->Mutex);
+}
+
+//----------------------------------------------------------------------------
+void cmArchiveDiskWriterInternals::Queue(cmArchiveDiskWriterFile* file)
+{
+  // The file belongs to the threads once it is queued.
+  this->Paths.insert(file->Path);
+  pthread_mutex_lock(&this->Mutex);
+  while(this->Pending > CM_ARCHIVE_DISK_WRITER_MAX_PENDING)
+    {
+    pthread_cond_wait(&this->DoneCond, &this->Mutex);
+    }
+  this->Pending += Cost(*file);
+  this->Jobs.push_back(file);
+  pthread_cond_signal(&this->WorkCond);
+  pthread_mutex_unlock(&this->Mutex);
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDiskWriterInternals::Wait(std::string& error)
+{
+  pthread_mutex_lock(&this->Mutex);
+  while(!this->Jobs.empty() || this->Active > 0)
+    {
+    pthread_cond_wait(&this->DoneCond, &this->Mutex);
+    }
+  error = this->Error;
+  pthread_mutex_unlock(&this->Mutex);
+  this->Paths.clear();
+  return error.empty();
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDiskWriterInternals::Failed()
+{
+  pthread_mutex_lock(&this->Mutex);
+  bool failed = !this->Error.empty();
+  pthread_mutex_unlock(&this->Mutex);
+  return failed;
+}
+
+//----------------------------------------------------------------------------
+void* cmArchiveDiskWriterInternals::Run(void* self)
+{
+  static_cast<cmArchiveDiskWriterInternals*>(self)->Work();
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void cmArchiveDiskWriterInternals::Work()
+{
+  pthread_mutex_lock(&this->Mutex);
+  for(;;)
+    {
+    while(this->Jobs.empty() && !this->Stop)
+      {
+      pthread_cond_wait(&this->WorkCond, &this->Mutex);
+      }
+    if(this->Jobs.empty())
+      {
+      break;
+      }
+    cmArchiveDiskWriterFile* file = this->Jobs.front();
+    this->Jobs.pop_front();
+    ++this->Active;
+    // Once a file failed the extraction stops, so drop the others.
+    bool skip = !this->Error.empty();
+    pthread_mutex_unlock(&this->Mutex);
+    std::string error;
+    if(!skip)
+      {
+      Write(*file, error);
+      }
+    pthread_mutex_lock(&this->Mutex);
+    --this->Active;
+    this->Pending -= Cost(*file);
+    if(this->Error.empty())
+      {
+      this->Error = error;
+      }
+    delete file;
+    pthread_cond_broadcast(&this->DoneCond);
+    }
+  pthread_mutex_unlock(&this->Mutex);
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDiskWriterInternals::Write(cmArchiveDiskWriterFile const& file,
+                                         std::string& error)
+{
+  // Replace an existing file rather than write through a link, and an
+  // empty directory as libarchive does.
+  if(unlink(file.Path.c_str()) != 0 && errno != ENOENT)
+    {
+    rmdir(file.Path.c_str());
+    }
+  int fd = open(file.Path.c_str(), O_WRONLY | O_CREAT | O_EXCL, file.Mode);
+  if(fd < 0)
+    {
+    error = "Cannot create \"" + file.Path + "\": " + strerror(errno);
+    return false;
+    }
+#if defined(__linux__)
+  // Reserve the blocks at once to keep the file contiguous.
+  if(!file.Data.empty())
+    {
+    posix_fallocate(fd, 0, static_cast<off_t>(file.Data.size()));
+    }
+#endif
+  const char* p = file.Data.data();
+  size_t n = file.Data.size();
+  while(n > 0)
+    {
+    ssize_t r = write(fd, p, n);
+    if(r < 0 && errno == EINTR)
+      {
+      continue;
+      }
+    if(r <= 0)
+      {
+      error = "Cannot write \"" + file.Path + "\": " + strerror(errno);
+      close(fd);
+      return false;
+      }
+    p += r;
+    n -= static_cast<size_t>(r);
+    }
+  if(close(fd) != 0 || utimes(file.Path.c_str(), file.Times) != 0)
+    {
+    error = "Cannot write \"" + file.Path + "\": " + strerror(errno);
+    return false;
+    }
+  return true;
+}
+#else
+class cmArchiveDiskWriterInternals {};
+#endif
+
+//----------------------------------------------------------------------------
+cmArchiveDiskWriter::cmArchiveDiskWriter(unsigned int threads): Internal(0)
+{
+#if defined(CMAKE_USE_PTHREADS)
+  if(threads > 1)
+    {
+    this->Internal = new cmArchiveDiskWriterInternals(threads);
+    if(!this->Internal->Okay())
+      {
+      delete this->Internal;
+      this->Internal = 0;
+      }
+    }
+#else
+  (void)threads;
+#endif
+}
+
+//----------------------------------------------------------------------------
+cmArchiveDiskWriter::~cmArchiveDiskWriter()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDiskWriter::Add(struct archive* a, struct archive_entry* entry)
+{
+#if defined(CMAKE_USE_PTHREADS)
+  if(!this->Internal)
+    {
+    return false;
+    }
+  cmArchiveDiskWriterInternals& internal = *this->Internal;
+  std::string path = archive_entry_pathname(entry);
+  bool pending = internal.Paths.find(path) != internal.Paths.end();
+  if(archive_entry_filetype(entry) != AE_IFREG ||
+     archive_entry_hardlink(entry) || !archive_entry_size_is_set(entry) ||
+     archive_entry_size(entry) > CM_ARCHIVE_DISK_WRITER_MAX_FILE ||
+     path.empty() || path[path.size() - 1] == '/')
+    {
+    // A link may point to a queued file, and another entry of the same
+    // path replaces it.
+    if(pending || (archive_entry_hardlink(entry) && !internal.Paths.empty()))
+      {
+      this->Wait();
+      }
+    return false;
+    }
+  if(pending)
+    {
+    this->Wait();
+    }
+
+  // Create the directory of the file as libarchive would.
+  std::string dir = cmSystemTools::GetFilenamePath(path);
+  if(!dir.empty() && internal.Directories.insert(dir).second)
+    {
+    cmSystemTools::MakeDirectory(dir.c_str());
+    }
+
+  cmArchiveDiskWriterFile* file = new cmArchiveDiskWriterFile;
+  file->Path = path;
+  file->Data.resize(static_cast<size_t>(archive_entry_size(entry)));
+  file->Mode = archive_entry_perm(entry) & 0777;
+  for(;;)
+    {
+    const void* buffer;
+    size_t size;
+    __LA_INT64_T offset;
+    int r = archive_read_data_block(a, &buffer, &size, &offset);
+    if(r == ARCHIVE_EOF)
+      {
+      break;
+      }
+    if(r != ARCHIVE_OK)
+      {
+      if(this->Error.empty())
+        {
+        const char* e = archive_error_string(a);
+        this->Error = "Problem reading \"" + path + "\": " +
+          (e? e : "unknown error");
+        }
+      delete file;
+      return true;
+      }
+    // Sparse files come in blocks at their offsets.
+    size_t end = static_cast<size_t>(offset) + size;
+    if(end > file->Data.size())
+      {
+      file->Data.resize(end);
+      }
+    memcpy(&file->Data[static_cast<size_t>(offset)], buffer, size);
+    }
+
+  // Restore the times as ARCHIVE_EXTRACT_TIME does.
+  gettimeofday(&file->Times[0], 0);
+  file->Times[1] = file->Times[0];
+  if(archive_entry_atime_is_set(entry))
+    {
+    file->Times[0].tv_sec = archive_entry_atime(entry);
+    file->Times[0].tv_usec = archive_entry_atime_nsec(entry) / 1000;
+    }
+  if(archive_entry_mtime_is_set(entry))
+    {
+    file->Times[1].tv_sec = archive_entry_mtime(entry);
+    file->Times[1].tv_usec = archive_entry_mtime_nsec(entry) / 1000;
+    }
+  internal.Queue(file);
+  return true;
+#else
+  (void)a;
+  (void)entry;
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDiskWriter::Failed()
+{
+#if defined(CMAKE_USE_PTHREADS)
+  if(this->Internal && this->Internal->Failed())
+    {
+    return true;
+    }
+#endif
+  return !this->Error.empty();
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveDiskWriter::Wait()
+{
+#if defined(CMAKE_USE_PTHREADS)
+  std::string error;
+  if(this->Internal && !this->Internal->Wait(error) && this->Error.empty())
+    {
+    this->Error = error;
+    }
+#endif
+  return this->Error.empty();
+}
@@ -0,0 +1,63 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2015 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#ifndef cmArchiveDiskWriter_h
+#define cmArchiveDiskWriter_h
+
+#include "cmStandardIncludes.h"
+
+struct archive;
+struct archive_entry;
+class cmArchiveDiskWriterInternals;
+
+/** \class cmArchiveDiskWriter
+ * \brief Write the regular files extracted from an archive on threads.
+ *
+ * The data of small regular files are read from the archive and the
+ * files are written by a pool of threads, preallocated where the file
+ * system supports it.  Other entries are left to libarchive.  Files
+ * already queued are finished first when an entry may depend on them.
+ */
+class cmArchiveDiskWriter
+{
+public:
+  cmArchiveDiskWriter(unsigned int threads);
+  ~cmArchiveDiskWriter();
+
+  /**
+   * Queue the file of the entry the archive is at.  Returns false if
+   * the entry is not a small regular file and must be extracted by the
+   * caller.
+   */
+  bool Add(struct archive* a, struct archive_entry* entry);
+
+  /**
+   * Returns true once a file failed, without waiting for the others.
+   * The caller should stop extracting, like on an error of libarchive.
+   */
+  bool Failed();
+
+  /** Wait for the queued files.  Returns false if one failed.  */
+  bool Wait();
+
+  /** The error of the first file that failed.  */
+  std::string const& GetError() const { return this->Error; }
+
+private:
+  cmArchiveDiskWriter(cmArchiveDiskWriter const&);
+  void operator=(cmArchiveDiskWriter const&);
+
+  // Internal implementation details.
+  cmArchiveDiskWriterInternals* Internal;
+  std::string Error;
+};
+
+#endif
@@ -18,6 +18,16 @@
 #include <cm_libarchive.h>
 #include "cm_get_date.h"
 
+#include <algorithm>
+
+#if defined(CMAKE_USE_PTHREADS)
+# include "cm_zlib.h"
+# include "cm_bzlib.h"
+# include "cm_lzma.h"
+# include <deque>
+# include <pthread.h>
+#endif
+
 //----------------------------------------------------------------------------
 static std::string cm_archive_error_string(struct archive* a)
 {
@@ -57,6 +67,316 @@ public:
   operator struct archive_entry*() { return this->Object; }
 };
 
+#if defined(CMAKE_USE_PTHREADS)
+//----------------------------------------------------------------------------
+// Compress the archive data in blocks on several threads and write the
+// compressed blocks in order.  Each block is a complete gzip member,
+// bzip2 stream or xz stream, so the output can be read by stock tools.
+class cmArchiveWrite::ParallelCompressor
+{
+public:
+  ParallelCompressor(std::ostream& os, Compress c, unsigned int threads);
+  ~ParallelCompressor();
+  static bool Supports(Compress c)
+    {
+    return c == CompressGZip || c == CompressBZip2 || c == CompressXZ;
+    }
+  bool Started() const { return !this->Threads.empty(); }
+  bool Write(const char* data, size_t n);
+  bool Finish();
+private:
+  struct Job
+  {
+    std::string Input;
+    std::string Output;
+    bool Done;
+    bool Failed;
+  };
+  static void* Run(void* self);
+  void Work();
+  bool Submit(size_t size);
+  bool WriteOldest();
+  bool CompressJob(Job& job) const;
+
+  std::ostream& Stream;
+  Compress Type;
+  size_t BlockSize;
+  size_t MaxPending;
+  std::string Buffer;
+  bool Submitted;
+  bool Okay;
+  bool Stop;
+  std::vector<pthread_t> Threads;
+  std::deque<Job*> Queue;   // Jobs not yet started.
+  std::deque<Job*> Pending; // Jobs not yet written, in order.
+  pthread_mutex_t Mutex;
+  pthread_cond_t WorkCond;
+  pthread_cond_t DoneCond;
+};
+
+//----------------------------------------------------------------------------
+cmArchiveWrite::ParallelCompressor::ParallelCompressor(
+  std::ostream& os, Compress c, unsigned int threads):
+    Stream(os), Type(c), Submitted(false), Okay(true), Stop(false)
+{
+  switch (c)
+    {
+    case CompressBZip2:
+      // The block size of "bzip2 -9", so the blocks compress as well as
+      // in a single stream.
+      this->BlockSize = 900000;
+      break;
+    case CompressXZ:
+      // Three times the dictionary size of the default preset, like the
+      // multi-threaded encoder of xz.
+      this->BlockSize = 24 << 20;
+      break;
+    default:
+      this->BlockSize = 1 << 20;
+      break;
+    }
+  this->MaxPending = 2 * threads;
+  pthread_mutex_init(&this->Mutex, 0);
+  pthread_cond_init(&this->WorkCond, 0);
+  pthread_cond_init(&this->DoneCond, 0);
+  for(unsigned int i = 0; i < threads; ++i)
+    {
+    pthread_t thread;
+    if(pthread_create(&thread, 0, &ParallelCompressor::Run, this) == 0)
+      {
+      this->Threads.push_back(thread);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+cmArchiveWrite::ParallelCompressor::~ParallelCompressor()
+{
+  // Discard the blocks that Finish did not write.
+  this->Okay = false;
+  while(!this->Pending.empty())
+    {
+    this->WriteOldest();
+    }
+  pthread_mutex_lock(&this->Mutex);
+  this->Stop = true;
+  pthread_cond_broadcast(&this->WorkCond);
+  pthread_mutex_unlock(&this->Mutex);
+  for(std::vector<pthread_t>::const_iterator ti = this->Threads.begin();
+      ti != this->Threads.end(); ++ti)
+    {
+    pthread_join(*ti, 0);
+    }
+  pthread_cond_destroy(&this->DoneCond);
+  pthread_cond_destroy(&this->WorkCond);
+  pthread_mutex_destroy(&this->Mutex);
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::ParallelCompressor::Write(const char* data, size_t n)
+{
+  if(!this->Okay)
+    {
+    return false;
+    }
+  this->Buffer.append(data, n);
+  while(this->Buffer.size() >= this->BlockSize)
+    {
+    if(!this->Submit(this->BlockSize))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::ParallelCompressor::Finish()
+{
+  // Compress the rest, and write at least one block so that even an
+  // empty archive is a valid compressed file.
+  if(this->Okay && (!this->Buffer.empty() || !this->Submitted))
+    {
+    this->Submit(this->Buffer.size());
+    }
+  while(!this->Pending.empty())
+    {
+    this->WriteOldest();
+    }
+  return this->Okay;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::ParallelCompressor::Submit(size_t size)
+{
+  Job* job = new Job;
+  job->Input.assign(this->Buffer, 0, size);
+  job->Done = false;
+  job->Failed = false;
+  this->Buffer.erase(0, size);
+  this->Submitted = true;
+
+  pthread_mutex_lock(&this->Mutex);
+  this->Queue.push_back(job);
+  this->Pending.push_back(job);
+  pthread_cond_signal(&this->WorkCond);
+  pthread_mutex_unlock(&this->Mutex);
+
+  // Bound the memory held by the blocks in flight.
+  while(this->Pending.size() > this->MaxPending)
+    {
+    if(!this->WriteOldest())
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::ParallelCompressor::WriteOldest()
+{
+  pthread_mutex_lock(&this->Mutex);
+  Job* job = this->Pending.front();
+  while(!job->Done)
+    {
+    pthread_cond_wait(&this->DoneCond, &this->Mutex);
+    }
+  this->Pending.pop_front();
+  pthread_mutex_unlock(&this->Mutex);
+
+  if(this->Okay)
+    {
+    this->Okay = !job->Failed &&
+      this->Stream.write(job->Output.data(),
+                         static_cast<std::streamsize>(job->Output.size()));
+    }
+  delete job;
+  return this->Okay;
+}
+
+//----------------------------------------------------------------------------
+void* cmArchiveWrite::ParallelCompressor::Run(void* self)
+{
+  static_cast<ParallelCompressor*>(self)->Work();
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void cmArchiveWrite::ParallelCompressor::Work()
+{
+  pthread_mutex_lock(&this->Mutex);
+  for(;;)
+    {
+    while(this->Queue.empty() && !this->Stop)
+      {
+      pthread_cond_wait(&this->WorkCond, &this->Mutex);
+      }
+    if(this->Queue.empty())
+      {
+      break;
+      }
+    Job* job = this->Queue.front();
+    this->Queue.pop_front();
+    pthread_mutex_unlock(&this->Mutex);
+    bool ok = this->CompressJob(*job);
+    pthread_mutex_lock(&this->Mutex);
+    job->Failed = !ok;
+    job->Done = true;
+    pthread_cond_broadcast(&this->DoneCond);
+    }
+  pthread_mutex_unlock(&this->Mutex);
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::ParallelCompressor::CompressJob(Job& job) const
+{
+  // Use the same compression levels as the libarchive filters.
+  std::string const& in = job.Input;
+  std::string& out = job.Output;
+  switch (this->Type)
+    {
+    case CompressGZip:
+      {
+      z_stream strm;
+      memset(&strm, 0, sizeof(strm));
+      // Add 16 to the window bits for a gzip header and trailer.
+      if(deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                      Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+        return false;
+        }
+      // Record the size of the member in a "CM" extra subfield so that
+      // cmArchiveDecompressor can find the members without inflating.
+      unsigned char extra[8] = { 'C', 'M', 4, 0, 0, 0, 0, 0 };
+      gz_header head;
+      memset(&head, 0, sizeof(head));
+      head.os = 255;
+      head.extra = extra;
+      head.extra_len = sizeof(extra);
+      if(deflateSetHeader(&strm, &head) != Z_OK)
+        {
+        deflateEnd(&strm);
+        return false;
+        }
+      out.resize(deflateBound(&strm, static_cast<uLong>(in.size())) + 64);
+      strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+      strm.avail_in = static_cast<uInt>(in.size());
+      strm.next_out = reinterpret_cast<Bytef*>(&out[0]);
+      strm.avail_out = static_cast<uInt>(out.size());
+      int res = deflate(&strm, Z_FINISH);
+      out.resize(strm.total_out);
+      deflateEnd(&strm);
+      if(res != Z_STREAM_END || out.size() < 20)
+        {
+        return false;
+        }
+      // The subfield data follow the 10 byte header and the lengths.
+      size_t size = out.size();
+      for(int i = 0; i < 4; ++i)
+        {
+        out[16 + i] = static_cast<char>((size >> (8 * i)) & 0xff);
+        }
+      return true;
+      }
+    case CompressBZip2:
+      {
+      unsigned int size =
+        static_cast<unsigned int>(in.size() + in.size() / 100 + 600);
+      out.resize(size);
+      if(BZ2_bzBuffToBuffCompress(&out[0], &size,
+                                  const_cast<char*>(in.data()),
+                                  static_cast<unsigned int>(in.size()),
+                                  9, 0, 0) != BZ_OK)
+        {
+        return false;
+        }
+      out.resize(size);
+      return true;
+      }
+    case CompressXZ:
+      {
+      size_t pos = 0;
+      out.resize(lzma_stream_buffer_bound(in.size()));
+      if(lzma_easy_buffer_encode(
+           LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC64, 0,
+           reinterpret_cast<const uint8_t*>(in.data()), in.size(),
+           reinterpret_cast<uint8_t*>(&out[0]), &pos, out.size())
+         != LZMA_OK)
+        {
+        return false;
+        }
+      out.resize(pos);
+      return true;
+      }
+    default:
+      return false;
+    }
+}
+#else
+class cmArchiveWrite::ParallelCompressor {};
+#endif
+
 //----------------------------------------------------------------------------
 struct cmArchiveWrite::Callback
 {
@@ -65,6 +385,13 @@ struct cmArchiveWrite::Callback
                             const void *b, size_t n)
     {
     cmArchiveWrite* self = static_cast<cmArchiveWrite*>(cd);
+#if defined(CMAKE_USE_PTHREADS)
+    if(self->Compressor)
+      {
+      return self->Compressor->Write(static_cast<const char*>(b), n)?
+        static_cast<__LA_SSIZE_T>(n) : static_cast<__LA_SSIZE_T>(-1);
+      }
+#endif
     if(self->Stream.write(static_cast<const char*>(b),
                           static_cast<std::streamsize>(n)))
       {
@@ -79,13 +406,37 @@ struct cmArchiveWrite::Callback
 
 //----------------------------------------------------------------------------
 cmArchiveWrite::cmArchiveWrite(
-  std::ostream& os, Compress c, std::string const& format):
+  std::ostream& os, Compress c, std::string const& format,
+  unsigned int threads):
     Stream(os),
     Archive(archive_write_new()),
     Disk(archive_read_disk_new()),
     Verbose(false),
-    Format(format)
+    Format(format),
+    Uid(-1),
+    Gid(-1),
+    Compressor(0),
+    Finished(false)
 {
+#if defined(CMAKE_USE_PTHREADS)
+  if(threads > 1 && ParallelCompressor::Supports(c))
+    {
+    // libarchive writes the uncompressed archive to our compressor.
+    this->Compressor = new ParallelCompressor(os, c, threads);
+    if(this->Compressor->Started())
+      {
+      c = CompressNone;
+      }
+    else
+      {
+      // No thread could be started, let libarchive compress serially.
+      delete this->Compressor;
+      this->Compressor = 0;
+      }
+    }
+#else
+  (void)threads;
+#endif
   switch (c)
     {
     case CompressNone:
@@ -176,8 +527,37 @@ cmArchiveWrite::cmArchiveWrite(
 //----------------------------------------------------------------------------
 cmArchiveWrite::~cmArchiveWrite()
 {
+  this->Finish();
   archive_read_free(this->Disk);
   archive_write_free(this->Archive);
+  delete this->Compressor;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::Finish()
+{
+  if(this->Finished)
+    {
+    return this->Okay();
+    }
+  this->Finished = true;
+  if(this->Okay() && archive_write_close(this->Archive) != ARCHIVE_OK)
+    {
+    this->Error = "archive_write_close: ";
+    this->Error += cm_archive_error_string(this->Archive);
+    }
+#if defined(CMAKE_USE_PTHREADS)
+  // Write the blocks still compressing after libarchive flushed its data.
+  if(this->Okay() && this->Compressor && !this->Compressor->Finish())
+    {
+    this->Error = "Problem compressing or writing the archive data";
+    }
+#endif
+  if(this->Okay() && !this->Stream.flush())
+    {
+    this->Error = "Problem writing the archive";
+    }
+  return this->Okay();
 }
 
 //----------------------------------------------------------------------------
@@ -210,21 +590,30 @@ bool cmArchiveWrite::AddPath(const char* path,
   cmsys::Directory d;
   if(d.Load(path))
     {
-    std::string next = path;
-    next += "/";
-    std::string::size_type end = next.size();
+    // Add entries in a stable order so that the archive does not
+    // depend on the order in which the file system lists them.
+    std::vector<std::string> files;
     unsigned long n = d.GetNumberOfFiles();
     for(unsigned long i = 0; i < n; ++i)
       {
       const char* file = d.GetFile(i);
       if(strcmp(file, ".") != 0 && strcmp(file, "..") != 0)
         {
-        next.erase(end);
-        next += file;
-        if(!this->AddPath(next.c_str(), skip, prefix))
-          {
-          return false;
-          }
+        files.push_back(file);
+        }
+      }
+    std::sort(files.begin(), files.end());
+    std::string next = path;
+    next += "/";
+    std::string::size_type end = next.size();
+    for(std::vector<std::string>::const_iterator fi = files.begin();
+        fi != files.end(); ++fi)
+      {
+      next.erase(end);
+      next += *fi;
+      if(!this->AddPath(next.c_str(), skip, prefix))
+        {
+        return false;
         }
       }
     }
@@ -277,24 +666,46 @@ bool cmArchiveWrite::AddFile(const char* file,
       return false;
       }
     archive_entry_set_mtime(e, t, 0);
+    archive_entry_unset_atime(e);
+    archive_entry_unset_ctime(e);
+    archive_entry_unset_birthtime(e);
+    }
+  if (this->Uid >= 0)
+    {
+    archive_entry_set_uid(e, this->Uid);
+    archive_entry_set_gid(e, this->Gid);
+    }
+  if (!this->Uname.empty())
+    {
+    archive_entry_copy_uname(e, this->Uname.c_str());
+    archive_entry_copy_gname(e, this->Gname.c_str());
     }
   // Clear acl and xattr fields not useful for distribution.
   archive_entry_acl_clear(e);
   archive_entry_xattr_clear(e);
   archive_entry_set_fflags(e, 0, 0);
 
-  if (this->Format == "pax" || this->Format == "paxr")
+  std::vector<cmArchiveWrite*> targets(1, this);
+  targets.insert(targets.end(), this->Mirrors.begin(), this->Mirrors.end());
+  std::vector<cmArchiveWrite*>::const_iterator ti;
+  for(ti = targets.begin(); ti != targets.end(); ++ti)
     {
-    // Sparse files are a GNU tar extension.
-    // Do not use them in standard tar files.
-    archive_entry_sparse_clear(e);
+    if ((*ti)->Format == "pax" || (*ti)->Format == "paxr")
+      {
+      // Sparse files are a GNU tar extension.
+      // Do not use them in standard tar files.
+      archive_entry_sparse_clear(e);
+      }
     }
 
-  if(archive_write_header(this->Archive, e) != ARCHIVE_OK)
+  for(ti = targets.begin(); ti != targets.end(); ++ti)
     {
-    this->Error = "archive_write_header: ";
-    this->Error += cm_archive_error_string(this->Archive);
-    return false;
+    if(archive_write_header((*ti)->Archive, e) != ARCHIVE_OK)
+      {
+      this->Error = "archive_write_header: ";
+      this->Error += cm_archive_error_string((*ti)->Archive);
+      return false;
+      }
     }
 
   // do not copy content of symlink
@@ -343,6 +754,16 @@ bool cmArchiveWrite::AddData(const char* file, size_t size)
       this->Error += cm_archive_error_string(this->Archive);
       return false;
       }
+    for(std::vector<cmArchiveWrite*>::const_iterator mi =
+          this->Mirrors.begin(); mi != this->Mirrors.end(); ++mi)
+      {
+      if(archive_write_data((*mi)->Archive, buffer, nnext) != nnext_s)
+        {
+        this->Error = "archive_write_data: ";
+        this->Error += cm_archive_error_string((*mi)->Archive);
+        return false;
+        }
+      }
     nleft -= nnext;
     }
   if(nleft > 0)
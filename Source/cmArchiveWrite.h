@@ -38,9 +38,14 @@ public:
     CompressXZ
   };
 
-  /** Construct with output stream to which to write archive.  */
+  /**
+   * Construct with output stream to which to write archive.  The gzip,
+   * bzip2 and xz compressions may run in up to "threads" threads.
+   * They then compress blocks of the archive independently and write
+   * them as consecutive members (gzip, bzip2) or streams (xz).
+   */
   cmArchiveWrite(std::ostream& os, Compress c = CompressNone,
-    std::string const& format = "paxr");
+    std::string const& format = "paxr", unsigned int threads = 1);
 
   ~cmArchiveWrite();
 
@@ -54,6 +59,14 @@ public:
    */
   bool Add(std::string path, size_t skip = 0, const char* prefix = 0);
 
+  /**
+   * Write the end of the archive, including the data still being
+   * compressed, and flush the output stream.  Returns false on an
+   * error.  Nothing may be added afterwards.  The destructor finishes
+   * an archive that was not finished, but cannot report errors.
+   */
+  bool Finish();
+
   /** Returns true if there has been no error.  */
   operator safe_bool() const
     { return this->Okay()? &cmArchiveWrite::safe_bool_true : 0; }
@@ -69,6 +82,18 @@ public:
   void SetVerbose(bool v) { this->Verbose = v; }
 
   void SetMTime(std::string const& t) { this->MTime = t; }
+
+  /** Store the given owner in every entry instead of the on-disk one.  */
+  void SetUIDAndGID(int uid, int gid) { this->Uid = uid; this->Gid = gid; }
+  void SetUNAMEAndGNAME(std::string const& uname, std::string const& gname)
+    { this->Uname = uname; this->Gname = gname; }
+
+  /**
+   * Also write every entry added to this archive to the given one, so
+   * that several archives are produced from a single read of each
+   * file.  The entries get the meta-data settings of this archive.
+   */
+  void AddMirror(cmArchiveWrite* mirror) { this->Mirrors.push_back(mirror); }
 private:
   bool Okay() const { return this->Error.empty(); }
   bool AddPath(const char* path, size_t skip, const char* prefix);
@@ -79,6 +104,7 @@ private:
   friend struct Callback;
 
   class Entry;
+  class ParallelCompressor;
 
   std::ostream& Stream;
   struct archive* Archive;
@@ -87,6 +113,13 @@ private:
   std::string Format;
   std::string Error;
   std::string MTime;
+  int Uid;
+  int Gid;
+  std::string Uname;
+  std::string Gname;
+  std::vector<cmArchiveWrite*> Mirrors;
+  ParallelCompressor* Compressor;
+  bool Finished;
 };
 
 #endif
@@ -295,6 +295,7 @@ cmCTest::cmCTest()
   this->ParallelLevel          = 1;
   this->ParallelLevelSetInCli  = false;
   this->TestLoad               = 0;
+  this->TestMemory             = 0;
   this->SubmitIndex            = 0;
   this->Failover               = false;
   this->BatchJobs              = false;
@@ -2092,6 +2093,21 @@ bool cmCTest::HandleCommandLineArguments(size_t &i,
       }
     }
 
+  if(this->CheckArgument(arg, "--test-memory") && i < args.size() - 1)
+    {
+    i++;
+    unsigned long memory;
+    if (cmSystemTools::StringToULong(args[i].c_str(), &memory))
+      {
+      this->SetTestMemory(memory);
+      }
+    else
+      {
+      cmCTestLog(this, WARNING,
+                 "Invalid value for 'Test Memory' : " << args[i] << std::endl);
+      }
+    }
+
   if(this->CheckArgument(arg, "--no-compress-output"))
     {
     this->CompressTestOutput = false;
@@ -2276,6 +2292,69 @@ bool cmCTest::HandleCommandLineArguments(size_t &i,
     this->GetHandler("test")->SetPersistentOption("RerunFailed", "true");
     this->GetHandler("memcheck")->SetPersistentOption("RerunFailed", "true");
     }
+  if(this->CheckArgument(arg, "--shard-index") && i < args.size() - 1)
+    {
+    i++;
+    this->GetHandler("test")->
+      SetPersistentOption("ShardIndex", args[i].c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("ShardIndex", args[i].c_str());
+    }
+  if(this->CheckArgument(arg, "--shard-count") && i < args.size() - 1)
+    {
+    i++;
+    this->GetHandler("test")->
+      SetPersistentOption("ShardCount", args[i].c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("ShardCount", args[i].c_str());
+    }
+  if(this->CheckArgument(arg, "--stop-on-failure"))
+    {
+    // Running tests are left to finish unless "kill" is given.
+    std::string mode = "stop";
+    if(i < args.size() - 1 && args[i+1] == "kill")
+      {
+      i++;
+      mode = "kill";
+      }
+    this->GetHandler("test")->
+      SetPersistentOption("StopOnFailure", mode.c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("StopOnFailure", mode.c_str());
+    }
+  if(this->CheckArgument(arg, "--adaptive-timeout") && i < args.size() - 1)
+    {
+    i++;
+    this->GetHandler("test")->
+      SetPersistentOption("AdaptiveTimeout", args[i].c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("AdaptiveTimeout", args[i].c_str());
+    }
+  if(this->CheckArgument(arg, "--adaptive-timeout-floor") &&
+     i < args.size() - 1)
+    {
+    i++;
+    this->GetHandler("test")->
+      SetPersistentOption("AdaptiveTimeoutFloor", args[i].c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("AdaptiveTimeoutFloor", args[i].c_str());
+    }
+  if(this->CheckArgument(arg, "--resource-report"))
+    {
+    // The number of tests to list is optional.
+    std::string count = "10";
+    unsigned long value;
+    if(i < args.size() - 1 &&
+       cmSystemTools::StringToULong(args[i+1].c_str(), &value))
+      {
+      i++;
+      count = args[i];
+      }
+    this->GetHandler("test")->
+      SetPersistentOption("ResourceReport", count.c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("ResourceReport", count.c_str());
+    }
   return true;
 }
 
@@ -164,6 +164,10 @@ public:
   unsigned long GetTestLoad() { return this->TestLoad; }
   void SetTestLoad(unsigned long);
 
+  /** Memory budget in megabytes for tests running at the same time */
+  unsigned long GetTestMemory() { return this->TestMemory; }
+  void SetTestMemory(unsigned long mem) { this->TestMemory = mem; }
+
   /**
    * Check if CTest file exists
    */
@@ -504,6 +508,7 @@ private:
   bool                    ParallelLevelSetInCli;
 
   unsigned long           TestLoad;
+  unsigned long           TestMemory;
 
   int                     CompatibilityMode;
 
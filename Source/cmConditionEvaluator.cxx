@@ -11,6 +11,7 @@
 ============================================================================*/
 
 #include "cmConditionEvaluator.h"
+#include "cmRegularExpression.h"
 
 cmConditionEvaluator::cmConditionEvaluator(cmMakefile& makefile):
   Makefile(makefile),
@@ -566,7 +567,7 @@ bool cmConditionEvaluator::HandleLevel2(cmArgumentList &newArgs,
         def = this->GetVariableOrString(*arg);
         const char* rex = argP2->c_str();
         this->Makefile.ClearMatches();
-        cmsys::RegularExpression regEntry;
+        cmRegularExpression regEntry;
         if ( !regEntry.compile(rex) )
           {
           std::ostringstream error;
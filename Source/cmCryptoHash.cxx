@@ -10,11 +10,17 @@
   See the License for more information.
 ============================================================================*/
 #include "cmCryptoHash.h"
+#include "cmSystemTools.h"
 
 #include <cmsys/MD5.h>
 #include <cmsys/FStream.hxx>
 #include "cm_sha2.h"
 
+#if defined(CMAKE_USE_PTHREADS)
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
 //----------------------------------------------------------------------------
 cmsys::auto_ptr<cmCryptoHash> cmCryptoHash::New(const char* algo)
 {
@@ -54,11 +60,15 @@ std::string cmCryptoHash::HashFile(const std::string& file)
 
   this->Initialize();
 
-  // Should be efficient enough on most system:
-  cm_sha2_uint64_t buffer[512];
-  char* buffer_c = reinterpret_cast<char*>(buffer);
+  // Read in large blocks so that the hash, and not the calls to read the
+  // file, takes the time.  Streams read blocks this large directly into
+  // the given buffer.
+  std::vector<cm_sha2_uint64_t> buffer(1 << 17);
+  char* buffer_c = reinterpret_cast<char*>(&buffer[0]);
   unsigned char const* buffer_uc =
-    reinterpret_cast<unsigned char const*>(buffer);
+    reinterpret_cast<unsigned char const*>(&buffer[0]);
+  std::streamsize buffer_size =
+    static_cast<std::streamsize>(buffer.size() * sizeof(buffer[0]));
   // This copy loop is very sensitive on certain platforms with
   // slightly broken stream libraries (like HPUX).  Normally, it is
   // incorrect to not check the error condition on the fin.read()
@@ -66,7 +76,7 @@ std::string cmCryptoHash::HashFile(const std::string& file)
   // error occurred.  Therefore, the loop should be safe everywhere.
   while(fin)
     {
-    fin.read(buffer_c, sizeof(buffer));
+    fin.read(buffer_c, buffer_size);
     if(int gcount = static_cast<int>(fin.gcount()))
       {
       this->Append(buffer_uc, gcount);
@@ -79,6 +89,138 @@ std::string cmCryptoHash::HashFile(const std::string& file)
   return "";
 }
 
+//----------------------------------------------------------------------------
+// Files shared by the threads of cmCryptoHash::HashFiles.  Each thread
+// takes the next file not yet taken until none is left.
+class cmCryptoHashFiles
+{
+public:
+  cmCryptoHashFiles(const char* algo, std::vector<std::string> const& files):
+    Algo(algo), Files(files), Hashes(files.size()), Errors(files.size()),
+    Next(0)
+    {
+#if defined(CMAKE_USE_PTHREADS)
+    pthread_mutex_init(&this->Mutex, 0);
+#endif
+    }
+  ~cmCryptoHashFiles()
+    {
+#if defined(CMAKE_USE_PTHREADS)
+    pthread_mutex_destroy(&this->Mutex);
+#endif
+    }
+
+  void Work()
+    {
+    cmsys::auto_ptr<cmCryptoHash> hash(cmCryptoHash::New(this->Algo));
+    size_t i;
+    while(this->Take(i))
+      {
+      this->Hashes[i] = hash->HashFile(this->Files[i]);
+      if(this->Hashes[i].empty())
+        {
+        this->Errors[i] = cmSystemTools::GetLastSystemError();
+        }
+      }
+    }
+#if defined(CMAKE_USE_PTHREADS)
+  static void* Run(void* self)
+    {
+    static_cast<cmCryptoHashFiles*>(self)->Work();
+    return 0;
+    }
+#endif
+
+  const char* Algo;
+  std::vector<std::string> const& Files;
+  std::vector<std::string> Hashes;
+  std::vector<std::string> Errors;
+
+private:
+  bool Take(size_t& i)
+    {
+#if defined(CMAKE_USE_PTHREADS)
+    pthread_mutex_lock(&this->Mutex);
+#endif
+    i = this->Next;
+    bool found = i < this->Files.size();
+    if(found)
+      {
+      ++this->Next;
+      }
+#if defined(CMAKE_USE_PTHREADS)
+    pthread_mutex_unlock(&this->Mutex);
+#endif
+    return found;
+    }
+
+  size_t Next;
+#if defined(CMAKE_USE_PTHREADS)
+  pthread_mutex_t Mutex;
+#endif
+};
+
+//----------------------------------------------------------------------------
+bool cmCryptoHash::HashFiles(const char* algo,
+                             std::vector<std::string> const& files,
+                             unsigned int threads,
+                             std::vector<std::string>& hashes,
+                             std::string& error)
+{
+  if(!cmCryptoHash::New(algo).get())
+    {
+    hashes.assign(files.size(), std::string());
+    error = std::string("unknown hash algorithm ") + algo;
+    return false;
+    }
+
+  cmCryptoHashFiles work(algo, files);
+#if defined(CMAKE_USE_PTHREADS)
+  if(threads == 0)
+    {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = n > 0? static_cast<unsigned int>(n) : 1;
+    }
+  if(threads > files.size())
+    {
+    threads = static_cast<unsigned int>(files.size());
+    }
+  // Detect the SHA instructions before the threads would race to do it.
+  SHA_DetectCPU();
+  // This thread hashes too, so start one less.
+  std::vector<pthread_t> started;
+  for(unsigned int i = 1; i < threads; ++i)
+    {
+    pthread_t thread;
+    if(pthread_create(&thread, 0, &cmCryptoHashFiles::Run, &work) != 0)
+      {
+      break;
+      }
+    started.push_back(thread);
+    }
+  work.Work();
+  for(std::vector<pthread_t>::const_iterator ti = started.begin();
+      ti != started.end(); ++ti)
+    {
+    pthread_join(*ti, 0);
+    }
+#else
+  (void)threads;
+  work.Work();
+#endif
+
+  hashes.swap(work.Hashes);
+  for(size_t i = 0; i < files.size(); ++i)
+    {
+    if(hashes[i].empty())
+      {
+      error = "failed to read file \"" + files[i] + "\": " + work.Errors[i];
+      return false;
+      }
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 cmCryptoHashMD5::cmCryptoHashMD5(): MD5(cmsysMD5_New())
 {
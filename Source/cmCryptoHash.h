@@ -23,7 +23,20 @@ public:
   static cmsys::auto_ptr<cmCryptoHash> New(const char* algo);
   std::string HashString(const std::string& input);
   std::string HashFile(const std::string& file);
-protected:
+
+  /**
+   * Hash the given files with the named algorithm on up to the given
+   * number of threads, or one per processor if it is 0.  The hashes are
+   * stored in the order of the files, and are empty for files that
+   * cannot be read.  Returns false with a message in error if any.
+   */
+  static bool HashFiles(const char* algo,
+                        std::vector<std::string> const& files,
+                        unsigned int threads,
+                        std::vector<std::string>& hashes,
+                        std::string& error);
+
+  /** Incremental interface for hashing data as it is produced.  */
   virtual void Initialize()=0;
   virtual void Append(unsigned char const*, int)=0;
   virtual std::string Finalize()=0;
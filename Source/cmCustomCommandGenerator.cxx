@@ -87,9 +87,17 @@ std::string escapeForShellOldStyle(const std::string& str)
 void
 cmCustomCommandGenerator
 ::AppendArguments(unsigned int c, std::string& cmd) const
+{
+  this->AppendArguments(c, 1, cmd);
+}
+
+//----------------------------------------------------------------------------
+void
+cmCustomCommandGenerator
+::AppendArguments(unsigned int c, unsigned int first, std::string& cmd) const
 {
   cmCustomCommandLine const& commandLine = this->CC.GetCommandLines()[c];
-  for(unsigned int j=1;j < commandLine.size(); ++j)
+  for(unsigned int j=first;j < commandLine.size(); ++j)
     {
     std::string arg =
         this->GE->Parse(commandLine[j])->Evaluate(this->LG->GetMakefile(),
@@ -107,6 +115,90 @@ cmCustomCommandGenerator
     }
 }
 
+//----------------------------------------------------------------------------
+static bool cmCustomCommandIsShellOperator(std::string const& arg)
+{
+  // Redirections such as "2>" or ">>file" and the operators "|", "||",
+  // "&&" and ";" are interpreted by the shell, not passed to the command.
+  std::string::size_type pos = arg.find_first_not_of("0123456789");
+  return pos != std::string::npos && strchr("<>|&;", arg[pos]) != 0;
+}
+
+//----------------------------------------------------------------------------
+bool cmCustomCommandGenerator::CanBatch(unsigned int c) const
+{
+  // The "cmake -E" commands that only work on files and output text.
+  static const char* const operations[] = {
+    "copy", "copy_directory", "copy_if_different", "create_symlink",
+    "echo", "echo_append", "make_directory", "remove", "remove_directory",
+    "rename", "touch", "touch_nocreate", "cmake_symlink_executable",
+    "cmake_symlink_library", 0
+  };
+  // Without VERBATIM the arguments may be shell syntax meant for this
+  // one command, which must not end up in the middle of a batch.
+  if(this->OldStyle)
+    {
+    return false;
+    }
+  cmCustomCommandLine const& commandLine = this->CC.GetCommandLines()[c];
+  cmMakefile* mf = this->LG->GetMakefile();
+  if(commandLine.size() < 3 ||
+     this->GetCommand(c) != mf->GetRequiredDefinition("CMAKE_COMMAND"))
+    {
+    return false;
+    }
+  std::vector<std::string> args;
+  for(unsigned int j=1;j < commandLine.size(); ++j)
+    {
+    args.push_back(this->GE->Parse(commandLine[j])->Evaluate(mf,
+                                                             this->Config));
+    // The batch separates commands with this argument.
+    if(args.back() == "--" || cmCustomCommandIsShellOperator(args.back()))
+      {
+      return false;
+      }
+    }
+  if(args[0] != "-E")
+    {
+    return false;
+    }
+  for(const char* const* op = operations; *op; ++op)
+    {
+    if(args[1] == *op)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+unsigned int
+cmCustomCommandGenerator
+::AppendBatchArguments(unsigned int c, std::string& cmd) const
+{
+  // Keep the command line short enough for the Windows command prompt.
+  const std::string::size_type maxLength = 8000;
+  std::string batch = " -E batch";
+  unsigned int n = c;
+  for(; n < this->GetNumberOfCommands() && this->CanBatch(n); ++n)
+    {
+    std::string args = " --";
+    this->AppendArguments(n, 2, args);
+    if(n > c + 1 && cmd.size() + batch.size() + args.size() > maxLength)
+      {
+      break;
+      }
+    batch += args;
+    }
+  if(n < c + 2)
+    {
+    return 0;
+    }
+  cmd += batch;
+  return n - c;
+}
+
 //----------------------------------------------------------------------------
 const char* cmCustomCommandGenerator::GetComment() const
 {
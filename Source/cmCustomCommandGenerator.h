@@ -28,6 +28,9 @@ class cmCustomCommandGenerator
   cmGeneratorExpression* GE;
   mutable bool DependsDone;
   mutable std::vector<std::string> Depends;
+  bool CanBatch(unsigned int c) const;
+  void AppendArguments(unsigned int c, unsigned int first,
+                       std::string& cmd) const;
 public:
   cmCustomCommandGenerator(cmCustomCommand const& cc,
                            const std::string& config,
@@ -37,6 +40,14 @@ public:
   unsigned int GetNumberOfCommands() const;
   std::string GetCommand(unsigned int c) const;
   void AppendArguments(unsigned int c, std::string& cmd) const;
+
+  /** If command c and the ones after it are file operations of
+      "cmake -E", append the arguments to run them with "cmake -E batch"
+      in one process and return how many were appended.  Only VERBATIM
+      commands without shell operators among their arguments are
+      batched.  Returns 0 and appends nothing if fewer than two can be
+      batched.  */
+  unsigned int AppendBatchArguments(unsigned int c, std::string& cmd) const;
   const char* GetComment() const;
   std::string GetWorkingDirectory() const;
   std::vector<std::string> const& GetOutputs() const;
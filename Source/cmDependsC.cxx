@@ -159,13 +159,13 @@ bool cmDependsC::WriteDependencies(const std::set<std::string>& sources,
       if((srcFiles>0)
          || cmSystemTools::FileIsFullPath(current.FileName.c_str()))
         {
-        if(cmSystemTools::FileExists(current.FileName.c_str(), true))
+        if(cmSystemTools::CachedFileExists(current.FileName, true))
           {
           fullName = current.FileName;
           }
         }
       else if(!current.QuotedLocation.empty() &&
-              cmSystemTools::FileExists(current.QuotedLocation.c_str(), true))
+              cmSystemTools::CachedFileExists(current.QuotedLocation, true))
         {
         // The include statement producing this entry was a double-quote
         // include and the included file is present in the directory of
@@ -190,7 +190,7 @@ bool cmDependsC::WriteDependencies(const std::set<std::string>& sources,
             cmSystemTools::CollapseCombinedPath(*i, current.FileName);
 
           // Look for the file in this location.
-          if(cmSystemTools::FileExists(tempPathStr.c_str(), true))
+          if(cmSystemTools::CachedFileExists(tempPathStr, true))
             {
             fullName = tempPathStr;
             HeaderLocationCache[current.FileName]=fullName;
@@ -28,6 +28,7 @@
 # include <elf64.h>
   typedef struct Elf32_Ehdr Elf32_Ehdr;
   typedef struct Elf32_Shdr Elf32_Shdr;
+  typedef struct Elf32_Phdr Elf32_Phdr;
   typedef struct Elf32_Sym Elf32_Sym;
   typedef struct Elf32_Rel Elf32_Rel;
   typedef struct Elf32_Rela Elf32_Rela;
@@ -125,6 +126,9 @@ public:
   virtual unsigned int GetDynamicEntryCount() = 0;
   virtual unsigned long GetDynamicEntryPosition(int j) = 0;
   virtual StringEntry const* GetDynamicSectionString(unsigned int tag) = 0;
+  virtual bool GetDynamicSectionStrings(unsigned int tag,
+                                        std::vector<std::string>& out) = 0;
+  virtual bool GetInterpreter(std::string& interp) = 0;
   virtual void PrintInfo(std::ostream& os) const = 0;
 
   bool ReadBytes(unsigned long pos, unsigned long size, char* buf)
@@ -156,6 +160,12 @@ public:
 #endif
     }
 
+  // Lookup all NEEDED entries in the DYNAMIC section.
+  bool GetNeeded(std::vector<std::string>& needed)
+    {
+    return this->GetDynamicSectionStrings(DT_NEEDED, needed);
+    }
+
   // Return the recorded ELF type.
   cmELF::FileType GetFileType() const { return this->ELFType; }
 protected:
@@ -196,6 +206,7 @@ struct cmELFTypes32
 {
   typedef Elf32_Ehdr ELF_Ehdr;
   typedef Elf32_Shdr ELF_Shdr;
+  typedef Elf32_Phdr ELF_Phdr;
   typedef Elf32_Dyn  ELF_Dyn;
   typedef Elf32_Half ELF_Half;
   typedef cmIML_INT_uint32_t tagtype;
@@ -207,6 +218,7 @@ struct cmELFTypes64
 {
   typedef Elf64_Ehdr ELF_Ehdr;
   typedef Elf64_Shdr ELF_Shdr;
+  typedef Elf64_Phdr ELF_Phdr;
   typedef Elf64_Dyn  ELF_Dyn;
   typedef Elf64_Half ELF_Half;
   typedef cmIML_INT_uint64_t tagtype;
@@ -222,6 +234,7 @@ public:
   // Copy the ELF file format types from our configuration parameter.
   typedef typename Types::ELF_Ehdr ELF_Ehdr;
   typedef typename Types::ELF_Shdr ELF_Shdr;
+  typedef typename Types::ELF_Phdr ELF_Phdr;
   typedef typename Types::ELF_Dyn  ELF_Dyn;
   typedef typename Types::ELF_Half ELF_Half;
   typedef typename Types::tagtype tagtype;
@@ -244,6 +257,13 @@ public:
   // Lookup a string from the dynamic section with the given tag.
   virtual StringEntry const* GetDynamicSectionString(unsigned int tag);
 
+  // Lookup all strings from the dynamic section with the given tag.
+  virtual bool GetDynamicSectionStrings(unsigned int tag,
+                                        std::vector<std::string>& out);
+
+  // Lookup the program interpreter from the program headers.
+  virtual bool GetInterpreter(std::string& interp);
+
   // Print information about the ELF file.
   virtual void PrintInfo(std::ostream& os) const
     {
@@ -315,6 +335,18 @@ private:
     cmELFByteSwap(sec_header.sh_entsize);
     }
 
+  void ByteSwap(ELF_Phdr& prog_header)
+    {
+    cmELFByteSwap(prog_header.p_type);
+    cmELFByteSwap(prog_header.p_offset);
+    cmELFByteSwap(prog_header.p_vaddr);
+    cmELFByteSwap(prog_header.p_paddr);
+    cmELFByteSwap(prog_header.p_filesz);
+    cmELFByteSwap(prog_header.p_memsz);
+    cmELFByteSwap(prog_header.p_flags);
+    cmELFByteSwap(prog_header.p_align);
+    }
+
   void ByteSwap(ELF_Dyn& dyn)
     {
     cmELFByteSwap(dyn.d_tag);
@@ -442,6 +474,15 @@ private:
       }
     return this->Stream? true:false;
     }
+  bool Read(ELF_Phdr& x)
+    {
+    if(this->Stream.read(reinterpret_cast<char*>(&x), sizeof(x)) &&
+       this->NeedSwap)
+      {
+      ByteSwap(x);
+      }
+    return this->Stream? true:false;
+    }
   bool Read(ELF_Dyn& x)
     {
     if(this->Stream.read(reinterpret_cast<char*>(&x), sizeof(x)) &&
@@ -724,6 +765,101 @@ cmELFInternalImpl<Types>::GetDynamicSectionString(unsigned int tag)
   return 0;
 }
 
+//----------------------------------------------------------------------------
+template <class Types>
+bool cmELFInternalImpl<Types>::GetDynamicSectionStrings(
+  unsigned int tag, std::vector<std::string>& out)
+{
+  // Try reading the dynamic section.
+  if(!this->LoadDynamicSection())
+    {
+    return false;
+    }
+
+  // Get the string table referenced by the DYNAMIC section.
+  ELF_Shdr const& sec = this->SectionHeaders[this->DynamicSectionIndex];
+  if(sec.sh_link >= this->SectionHeaders.size())
+    {
+    this->SetErrorMessage("Section DYNAMIC has invalid string table index.");
+    return false;
+    }
+  ELF_Shdr const& strtab = this->SectionHeaders[sec.sh_link];
+
+  // Collect every entry with the requested tag, in order.
+  for(typename std::vector<ELF_Dyn>::iterator
+        di = this->DynamicSectionEntries.begin();
+      di != this->DynamicSectionEntries.end(); ++di)
+    {
+    ELF_Dyn& dyn = *di;
+    if(static_cast<tagtype>(dyn.d_tag) == DT_NULL)
+      {
+      break;
+      }
+    if(static_cast<tagtype>(dyn.d_tag) != static_cast<tagtype>(tag))
+      {
+      continue;
+      }
+    if(dyn.d_un.d_val >= strtab.sh_size)
+      {
+      this->SetErrorMessage("Section DYNAMIC references string beyond "
+                            "the end of its string section.");
+      return false;
+      }
+
+    // Read the null-terminated string.
+    unsigned long first = static_cast<unsigned long>(dyn.d_un.d_val);
+    unsigned long end = static_cast<unsigned long>(strtab.sh_size);
+    this->Stream.seekg(strtab.sh_offset + first);
+    std::string value;
+    char c;
+    while(first++ != end && this->Stream.get(c) && c)
+      {
+      value += c;
+      }
+    if(!this->Stream)
+      {
+      this->SetErrorMessage("Dynamic section specifies unreadable string.");
+      return false;
+      }
+    out.push_back(value);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+template <class Types>
+bool cmELFInternalImpl<Types>::GetInterpreter(std::string& interp)
+{
+  // Look for the PT_INTERP entry among the program headers.
+  for(ELF_Half i=0; i < this->ELFHeader.e_phnum; ++i)
+    {
+    ELF_Phdr ph;
+    this->Stream.seekg(this->ELFHeader.e_phoff +
+                       this->ELFHeader.e_phentsize * i);
+    if(!this->Read(ph))
+      {
+      this->SetErrorMessage("Failed to load program headers.");
+      return false;
+      }
+    if(ph.p_type != PT_INTERP)
+      {
+      continue;
+      }
+
+    // The segment holds the null-terminated path of the interpreter.
+    std::vector<char> buf(static_cast<size_t>(ph.p_filesz) + 1, 0);
+    this->Stream.seekg(ph.p_offset);
+    if(!this->Stream.read(&buf[0], static_cast<std::streamsize>(ph.p_filesz)))
+      {
+      this->SetErrorMessage("Program header specifies unreadable INTERP.");
+      return false;
+      }
+    interp = &buf[0];
+    return true;
+    }
+  return false;
+}
+
 //============================================================================
 // External class implementation.
 
@@ -935,6 +1071,36 @@ cmELF::StringEntry const* cmELF::GetRunPath()
     }
 }
 
+//----------------------------------------------------------------------------
+bool cmELF::GetNeeded(std::vector<std::string>& needed)
+{
+  if(this->Valid() &&
+     (this->Internal->GetFileType() == cmELF::FileTypeExecutable ||
+      this->Internal->GetFileType() == cmELF::FileTypeSharedLibrary))
+    {
+    return this->Internal->GetNeeded(needed);
+    }
+  else
+    {
+    return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool cmELF::GetInterpreter(std::string& interp)
+{
+  if(this->Valid() &&
+     (this->Internal->GetFileType() == cmELF::FileTypeExecutable ||
+      this->Internal->GetFileType() == cmELF::FileTypeSharedLibrary))
+    {
+    return this->Internal->GetInterpreter(interp);
+    }
+  else
+    {
+    return false;
+    }
+}
+
 //----------------------------------------------------------------------------
 void cmELF::PrintInfo(std::ostream& os) const
 {
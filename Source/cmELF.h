@@ -95,6 +95,13 @@ public:
   /** Get the RUNPATH field if any.  */
   StringEntry const* GetRunPath();
 
+  /** Get the DT_NEEDED entries, in link order.  Returns false if the
+      file has no DYNAMIC section or it cannot be read.  */
+  bool GetNeeded(std::vector<std::string>& needed);
+
+  /** Get the program interpreter (PT_INTERP) if any.  */
+  bool GetInterpreter(std::string& interp);
+
   /** Print human-readable information about the ELF file.  */
   void PrintInfo(std::ostream& os) const;
 
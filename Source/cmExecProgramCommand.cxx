@@ -280,6 +280,7 @@ bool cmExecProgramCommand::RunCommand(const char* command,
 
   // All output has been read.  Wait for the process to exit.
   cmsysProcess_WaitForExit(cp, 0);
+  cmSystemTools::ClearFileCache();
 
   // Check the result of running the process.
   std::string msg;
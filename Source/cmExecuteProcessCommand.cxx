@@ -13,6 +13,9 @@
 #include "cmSystemTools.h"
 
 #include <cmsys/Process.h>
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+# include <cmsys/SystemInformation.hxx>
+#endif
 
 #include <ctype.h> /* isspace */
 
@@ -25,6 +28,17 @@ void cmExecuteProcessCommandFixText(std::vector<char>& output,
                                     bool strip_trailing_whitespace);
 void cmExecuteProcessCommandAppend(std::vector<char>& output,
                                    const char* data, int length);
+std::string cmExecuteProcessCommandResult(cmsysProcess* cp);
+
+// A process started by execute_process and the output read from it.
+struct cmExecuteProcessCommandRun
+{
+  cmExecuteProcessCommandRun(): Process(0), Finished(false) {}
+  cmsysProcess* Process;
+  bool Finished;
+  std::vector<char> Output;
+  std::vector<char> Error;
+};
 
 // cmExecuteProcessCommand
 bool cmExecuteProcessCommand
@@ -44,6 +58,8 @@ bool cmExecuteProcessCommand
   bool output_strip_trailing_whitespace = false;
   bool error_strip_trailing_whitespace = false;
   std::string timeout_string;
+  std::string jobs_string;
+  bool concurrent = false;
   std::string input_file;
   std::string output_file;
   std::string error_file;
@@ -163,6 +179,20 @@ bool cmExecuteProcessCommand
         return false;
         }
       }
+    else if(args[i] == "JOBS")
+      {
+      doing_command = false;
+      concurrent = true;
+      if(++i < args.size())
+        {
+        jobs_string = args[i];
+        }
+      else
+        {
+        this->SetError(" called with no value for JOBS.");
+        return false;
+        }
+      }
     else if(args[i] == "OUTPUT_QUIET")
       {
       doing_command = false;
@@ -236,153 +266,263 @@ bool cmExecuteProcessCommand
       }
     }
 
-  // Create a process instance.
-  cmsysProcess* cp = cmsysProcess_New();
-
-  // Set the command sequence.
-  for(unsigned int i=0; i < cmds.size(); ++i)
+  // Parse the job limit.
+  unsigned long jobs = 1;
+  if(concurrent)
     {
-    cmsysProcess_AddCommand(cp, &*cmds[i].begin());
+    if(!cmSystemTools::StringToULong(jobs_string.c_str(), &jobs))
+      {
+      this->SetError(" called with JOBS value that could not be parsed.");
+      return false;
+      }
+    if(!output_file.empty() || !error_file.empty())
+      {
+      this->SetError(" may not be given OUTPUT_FILE or ERROR_FILE with JOBS.");
+      return false;
+      }
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+    if(jobs == 0)
+      {
+      // Use every processor of the host.
+      cmsys::SystemInformation info;
+      info.RunCPUCheck();
+      jobs = info.GetNumberOfLogicalCPU();
+      }
+#endif
+    if(jobs == 0)
+      {
+      jobs = 1;
+      }
     }
 
-  // Set the process working directory.
-  if(!working_directory.empty())
+  // Without JOBS the commands form a single pipeline.  With JOBS each
+  // command is run by a process of its own, at most that many at once.
+  std::vector<cmExecuteProcessCommandRun> runs(concurrent? cmds.size() : 1);
+  if(jobs > runs.size())
     {
-    cmsysProcess_SetWorkingDirectory(cp, working_directory.c_str());
+    jobs = static_cast<unsigned long>(runs.size());
     }
 
-  // Always hide the process window.
-  cmsysProcess_SetOption(cp, cmsysProcess_Option_HideWindow, 1);
-
-  // Check the output variables.
   bool merge_output = false;
-  if(!input_file.empty())
-    {
-    cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDIN, input_file.c_str());
-    }
-  if(!output_file.empty())
-    {
-    cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDOUT,
-                             output_file.c_str());
-    }
-  if(!error_file.empty())
+  if (!error_file.empty() && error_file == output_file)
     {
-    if (error_file == output_file)
-      {
-      merge_output = true;
-      }
-    else
-      {
-      cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDERR,
-                               error_file.c_str());
-      }
+    merge_output = true;
     }
   if (!output_variable.empty() && output_variable == error_variable)
     {
     merge_output = true;
     }
-  if (merge_output)
-    {
-    cmsysProcess_SetOption(cp, cmsysProcess_Option_MergeOutput, 1);
-    }
 
-  // Set the timeout if any.
-  if(timeout >= 0)
+  size_t next = 0;
+  size_t running = 0;
+  while(next < runs.size() || running > 0)
     {
-    cmsysProcess_SetTimeout(cp, timeout);
-    }
-
-  // Start the process.
-  cmsysProcess_Execute(cp);
-
-  // Read the process output.
-  std::vector<char> tempOutput;
-  std::vector<char> tempError;
-  int length;
-  char* data;
-  int p;
-  while((p = cmsysProcess_WaitForData(cp, &data, &length, 0), p))
-    {
-    // Put the output in the right place.
-    if (p == cmsysProcess_Pipe_STDOUT && !output_quiet)
+    // Start processes up to the job limit.
+    while(next < runs.size() && running < jobs)
       {
-      if(output_variable.empty())
+      // Create a process instance.
+      cmsysProcess* cp = cmsysProcess_New();
+      runs[next].Process = cp;
+      ++next;
+      ++running;
+
+      // Set the command sequence.
+      if(concurrent)
         {
-        cmSystemTools::Stdout(data, length);
+        cmsysProcess_AddCommand(cp, &*cmds[next-1].begin());
         }
       else
         {
-        cmExecuteProcessCommandAppend(tempOutput, data, length);
+        for(unsigned int i=0; i < cmds.size(); ++i)
+          {
+          cmsysProcess_AddCommand(cp, &*cmds[i].begin());
+          }
+        }
+
+      // Set the process working directory.
+      if(!working_directory.empty())
+        {
+        cmsysProcess_SetWorkingDirectory(cp, working_directory.c_str());
         }
+
+      // Always hide the process window.
+      cmsysProcess_SetOption(cp, cmsysProcess_Option_HideWindow, 1);
+
+      // Check the output variables.
+      if(!input_file.empty())
+        {
+        cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDIN,
+                                 input_file.c_str());
+        }
+      if(!output_file.empty())
+        {
+        cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDOUT,
+                                 output_file.c_str());
+        }
+      if(!error_file.empty() && !merge_output)
+        {
+        cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDERR,
+                                 error_file.c_str());
+        }
+      if (merge_output)
+        {
+        cmsysProcess_SetOption(cp, cmsysProcess_Option_MergeOutput, 1);
+        }
+
+      // Set the timeout if any.
+      if(timeout >= 0)
+        {
+        cmsysProcess_SetTimeout(cp, timeout);
+        }
+
+      // Start the process.
+      cmsysProcess_Execute(cp);
       }
-    else if(p == cmsysProcess_Pipe_STDERR && !error_quiet)
+
+    // Read the output the running processes have so far without
+    // blocking, then block until any of them has more or exits.
+    std::vector<cmsysProcess*> waiting;
+    bool finished = false;
+    for(size_t r = 0; r < next; ++r)
       {
-      if(error_variable.empty())
+      cmExecuteProcessCommandRun& run = runs[r];
+      if(run.Finished)
         {
-        cmSystemTools::Stderr(data, length);
+        continue;
         }
-      else
+
+      double poll = 0;
+      int length;
+      char* data;
+      int p;
+      while((p = cmsysProcess_WaitForData(run.Process, &data, &length,
+                                          &poll), p) &&
+            p != cmsysProcess_Pipe_Timeout)
         {
-        cmExecuteProcessCommandAppend(tempError, data, length);
+        // Put the output in the right place.
+        if (p == cmsysProcess_Pipe_STDOUT && !output_quiet)
+          {
+          if(output_variable.empty())
+            {
+            cmSystemTools::Stdout(data, length);
+            }
+          else
+            {
+            cmExecuteProcessCommandAppend(run.Output, data, length);
+            }
+          }
+        else if(p == cmsysProcess_Pipe_STDERR && !error_quiet)
+          {
+          if(error_variable.empty())
+            {
+            cmSystemTools::Stderr(data, length);
+            }
+          else
+            {
+            cmExecuteProcessCommandAppend(run.Error, data, length);
+            }
+          }
         }
+      if(p == cmsysProcess_Pipe_Timeout)
+        {
+        waiting.push_back(run.Process);
+        continue;
+        }
+
+      // All output has been read.  Wait for the process to exit.
+      cmsysProcess_WaitForExit(run.Process, 0);
+      run.Finished = true;
+      finished = true;
+      --running;
+      }
+    if(!finished && !waiting.empty())
+      {
+      cmsysProcess_WaitForAny(&*waiting.begin(),
+                              static_cast<int>(waiting.size()), 0);
       }
     }
+  cmSystemTools::ClearFileCache();
+
+  std::string results;
+  for(size_t r = 0; r < runs.size(); ++r)
+    {
+    cmExecuteProcessCommandRun& run = runs[r];
 
-  // All output has been read.  Wait for the process to exit.
-  cmsysProcess_WaitForExit(cp, 0);
+    // Name the variables of each command after its index.
+    std::string suffix;
+    if(concurrent)
+      {
+      std::ostringstream index;
+      index << "_" << r;
+      suffix = index.str();
+      }
 
-  // Fix the text in the output strings.
-  cmExecuteProcessCommandFixText(tempOutput,
-                                 output_strip_trailing_whitespace);
-  cmExecuteProcessCommandFixText(tempError,
-                                 error_strip_trailing_whitespace);
+    // Fix the text in the output strings.
+    cmExecuteProcessCommandFixText(run.Output,
+                                   output_strip_trailing_whitespace);
+    cmExecuteProcessCommandFixText(run.Error,
+                                   error_strip_trailing_whitespace);
 
-  // Store the output obtained.
-  if(!output_variable.empty() && !tempOutput.empty())
-    {
-    this->Makefile->AddDefinition(output_variable,
-                                  &*tempOutput.begin());
-    }
-  if(!merge_output && !error_variable.empty() && !tempError.empty())
-    {
-    this->Makefile->AddDefinition(error_variable,
-                                  &*tempError.begin());
-    }
+    // Store the output obtained.
+    if(!output_variable.empty() && !run.Output.empty())
+      {
+      this->Makefile->AddDefinition(output_variable + suffix,
+                                    &*run.Output.begin());
+      }
+    if(!merge_output && !error_variable.empty() && !run.Error.empty())
+      {
+      this->Makefile->AddDefinition(error_variable + suffix,
+                                    &*run.Error.begin());
+      }
 
-  // Store the result of running the process.
-  if(!result_variable.empty())
-    {
-    switch(cmsysProcess_GetState(cp))
+    // Store the result of running the process.
+    if(!result_variable.empty())
       {
-      case cmsysProcess_State_Exited:
+      std::string result = cmExecuteProcessCommandResult(run.Process);
+      this->Makefile->AddDefinition(result_variable + suffix,
+                                    result.c_str());
+      if(r > 0)
         {
-        int v = cmsysProcess_GetExitValue(cp);
-        char buf[100];
-        sprintf(buf, "%d", v);
-        this->Makefile->AddDefinition(result_variable, buf);
+        results += ";";
         }
-        break;
-      case cmsysProcess_State_Exception:
-        this->Makefile->AddDefinition(result_variable,
-                                  cmsysProcess_GetExceptionString(cp));
-        break;
-      case cmsysProcess_State_Error:
-        this->Makefile->AddDefinition(result_variable,
-                                  cmsysProcess_GetErrorString(cp));
-        break;
-      case cmsysProcess_State_Expired:
-        this->Makefile->AddDefinition(result_variable,
-                                  "Process terminated due to timeout");
-        break;
+      results += result;
       }
+
+    // Delete the process instance.
+    cmsysProcess_Delete(run.Process);
     }
 
-  // Delete the process instance.
-  cmsysProcess_Delete(cp);
+  // With JOBS the result variable lists the results of all commands.
+  if(concurrent && !result_variable.empty())
+    {
+    this->Makefile->AddDefinition(result_variable, results.c_str());
+    }
 
   return true;
 }
 
+//----------------------------------------------------------------------------
+std::string cmExecuteProcessCommandResult(cmsysProcess* cp)
+{
+  switch(cmsysProcess_GetState(cp))
+    {
+    case cmsysProcess_State_Exited:
+      {
+      int v = cmsysProcess_GetExitValue(cp);
+      char buf[100];
+      sprintf(buf, "%d", v);
+      return buf;
+      }
+    case cmsysProcess_State_Exception:
+      return cmsysProcess_GetExceptionString(cp);
+    case cmsysProcess_State_Error:
+      return cmsysProcess_GetErrorString(cp);
+    case cmsysProcess_State_Expired:
+      return "Process terminated due to timeout";
+    }
+  return "";
+}
+
 //----------------------------------------------------------------------------
 void cmExecuteProcessCommandFixText(std::vector<char>& output,
                                     bool strip_trailing_whitespace)
@@ -24,6 +24,7 @@
 
 #if defined(CMAKE_BUILD_WITH_CMAKE)
 #include "cmCurl.h"
+#include "cmFileLock.h"
 #include "cmFileLockResult.h"
 #endif
 
@@ -134,6 +135,10 @@ bool cmFileCommand
     {
     return this->HandleHashCommand(args);
     }
+  else if ( subCommand == "HASH_MANY" )
+    {
+    return this->HandleHashManyCommand(args);
+    }
   else if ( subCommand == "STRINGS" )
     {
     return this->HandleStringsCommand(args);
@@ -273,6 +278,7 @@ bool cmFileCommand::HandleWriteCommand(std::vector<std::string> const& args,
   std::string message = cmJoin(cmMakeRange(i, args.end()), std::string());
   file << message;
   file.close();
+  cmSystemTools::InvalidateFileCache(fileName);
   if(mode)
     {
     cmSystemTools::SetPermissions(fileName.c_str(), mode);
@@ -432,6 +438,40 @@ bool cmFileCommand::HandleHashCommand(std::vector<std::string> const& args)
 #endif
 }
 
+//----------------------------------------------------------------------------
+bool
+cmFileCommand::HandleHashManyCommand(std::vector<std::string> const& args)
+{
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  if(args.size() < 3)
+    {
+    this->SetError("HASH_MANY requires an algorithm and output variable");
+    return false;
+    }
+
+  std::vector<std::string> files(args.begin() + 3, args.end());
+  std::vector<std::string> hashes;
+  std::string error;
+  if(!cmCryptoHash::New(args[1].c_str()).get())
+    {
+    std::ostringstream e;
+    e << "HASH_MANY given unknown algorithm \"" << args[1] << "\".";
+    this->SetError(e.str());
+    return false;
+    }
+  if(!cmCryptoHash::HashFiles(args[1].c_str(), files, 0, hashes, error))
+    {
+    this->SetError("HASH_MANY " + error);
+    return false;
+    }
+  this->Makefile->AddDefinition(args[2], cmJoin(hashes, ";").c_str());
+  return true;
+#else
+  this->SetError("HASH_MANY not available during bootstrap");
+  return false;
+#endif
+}
+
 //----------------------------------------------------------------------------
 bool cmFileCommand::HandleStringsCommand(std::vector<std::string> const& args)
 {
@@ -898,6 +938,8 @@ bool cmFileCommand::HandleGlobCommand(std::vector<std::string> const& args,
   i++;
   cmsys::Glob g;
   g.SetRecurse(recurse);
+  // List subdirectories concurrently.  The files found do not change.
+  g.SetThreads(0);
 
   bool explicitFollowSymlinks = false;
   cmPolicies::PolicyStatus status =
@@ -2768,14 +2810,27 @@ typedef std::vector<char> cmFileCommandVectorOfChar;
 
 namespace {
 
+  struct cmFileCommandDownloadSink
+    {
+    cmsys::ofstream* File;
+    cmCryptoHash* Hash;
+    };
+
   size_t
   cmWriteToFileCallback(void *ptr, size_t size, size_t nmemb,
                         void *data)
     {
     int realsize = (int)(size * nmemb);
-    cmsys::ofstream* fout = static_cast<cmsys::ofstream*>(data);
+    cmFileCommandDownloadSink* sink =
+      static_cast<cmFileCommandDownloadSink*>(data);
     const char* chPtr = static_cast<char*>(ptr);
-    fout->write(chPtr, realsize);
+    sink->File->write(chPtr, realsize);
+    // Hash the data as they arrive rather than reading the file again.
+    if(sink->Hash)
+      {
+      sink->Hash->Append(reinterpret_cast<unsigned char const*>(chPtr),
+                         realsize);
+      }
     return realsize;
     }
 
@@ -2987,6 +3042,7 @@ cmFileCommand::HandleDownloadCommand(std::vector<std::string> const& args)
   bool tls_verify = this->Makefile->IsOn("CMAKE_TLS_VERIFY");
   const char* cainfo = this->Makefile->GetDefinition("CMAKE_TLS_CAINFO");
   std::string expectedHash;
+  std::string hashAlgo;
   std::string hashMatchMSG;
   cmsys::auto_ptr<cmCryptoHash> hash;
   bool showProgress = false;
@@ -3074,6 +3130,7 @@ cmFileCommand::HandleDownloadCommand(std::vector<std::string> const& args)
         return false;
         }
       hash = cmsys::auto_ptr<cmCryptoHash>(cmCryptoHash::New("MD5"));
+      hashAlgo = "MD5";
       hashMatchMSG = "MD5 sum";
       expectedHash = cmSystemTools::LowerCase(*i);
       }
@@ -3108,6 +3165,7 @@ cmFileCommand::HandleDownloadCommand(std::vector<std::string> const& args)
         this->SetError(err);
         return false;
         }
+      hashAlgo = algo;
       hashMatchMSG = algo + " hash";
       }
     ++i;
@@ -3149,12 +3207,77 @@ cmFileCommand::HandleDownloadCommand(std::vector<std::string> const& args)
     return false;
     }
 
+  // Files with an expected hash may be in the download cache.
+  std::string cacheDir;
+  if(const char* d = this->Makefile->GetDefinition("CMAKE_DOWNLOAD_CACHE"))
+    {
+    cacheDir = d;
+    }
+  else
+    {
+    cmSystemTools::GetEnv("CMAKE_DOWNLOAD_CACHE", cacheDir);
+    }
+  std::string cacheFile;
+  cmFileLock cacheLock;
+  bool cacheFill = false;
+  if(hash.get() && !cacheDir.empty())
+    {
+    std::string cacheSubDir =
+      cacheDir + "/" + cmSystemTools::LowerCase(hashAlgo);
+    cacheFile = cacheSubDir + "/" + expectedHash;
+    // Drop an entry that does not match its hash any more, e.g. because
+    // it was written through a link, so that it is filled again.
+    if(cmSystemTools::FileExists(cacheFile.c_str()) &&
+       hash->HashFile(cacheFile) != expectedHash)
+      {
+      cmSystemTools::RemoveFile(cacheFile);
+      }
+    if(!cmSystemTools::FileExists(cacheFile.c_str()))
+      {
+      // Hold the lock of the entry while the file is downloaded so that
+      // concurrent downloads of the same file wait for this one.  Without
+      // the lock the file is downloaded as if there were no cache.
+      std::string lockFile = cacheFile + ".lock";
+      FILE* lf = 0;
+      if(cmSystemTools::MakeDirectory(cacheSubDir.c_str()) &&
+         (lf = cmsys::SystemTools::Fopen(lockFile, "a")) != 0)
+        {
+        fclose(lf);
+        cacheFill = cacheLock.Lock(lockFile,
+                                   static_cast<unsigned long>(-1)).IsOk();
+        }
+      }
+    // Another process may have filled the entry while we waited.
+    if(cmSystemTools::FileExists(cacheFile.c_str()))
+      {
+      cmSystemTools::RemoveFile(file);
+      if(cmSystemTools::CreateLink(cacheFile, file) ||
+         cmSystemTools::cmCopyFile(cacheFile.c_str(), file.c_str()))
+        {
+        if(!statusVar.empty())
+          {
+          std::ostringstream result;
+          result << (int)0 << ";\"returning early; file found in "
+            "download cache\"";
+          this->Makefile->AddDefinition(statusVar,
+                                        result.str().c_str());
+          }
+        return true;
+        }
+      cacheFill = false;
+      }
+    }
+
+  // The file may be a link to a cache entry from an earlier download,
+  // which must not be written through.
+  cmSystemTools::RemoveFile(file);
   cmsys::ofstream fout(file.c_str(), std::ios::binary);
   if(!fout)
     {
     this->SetError("DOWNLOAD cannot open file for write.");
     return false;
     }
+  cmSystemTools::InvalidateFileCache(file);
 
 #if defined(_WIN32) && defined(CMAKE_ENCODING_UTF8)
   url = fix_file_url_windows(url);
@@ -3210,7 +3333,14 @@ cmFileCommand::HandleDownloadCommand(std::vector<std::string> const& args)
 
   cmFileCommandVectorOfChar chunkDebug;
 
-  res = ::curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&fout);
+  cmFileCommandDownloadSink sink;
+  sink.File = &fout;
+  sink.Hash = hash.get();
+  if(hash.get())
+    {
+    hash->Initialize();
+    }
+  res = ::curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&sink);
   check_curl_result(res, "DOWNLOAD cannot set write data: ");
 
   res = ::curl_easy_setopt(curl, CURLOPT_DEBUGDATA, (void *)&chunkDebug);
@@ -3275,21 +3405,22 @@ cmFileCommand::HandleDownloadCommand(std::vector<std::string> const& args)
 
   ::curl_global_cleanup();
 
-  // Explicitly flush/close so we can measure the md5 accurately.
+  // Explicitly flush/close so we know the file holds what was hashed.
   //
   fout.flush();
+  bool written = fout.good();
   fout.close();
 
   // Verify MD5 sum if requested:
   //
   if (hash.get())
     {
-    std::string actualHash = hash->HashFile(file);
-    if (actualHash.empty())
+    if (!written)
       {
-      this->SetError("DOWNLOAD cannot compute hash on downloaded file");
+      this->SetError("DOWNLOAD cannot write the downloaded file");
       return false;
       }
+    std::string actualHash = hash->Finalize();
 
     if (expectedHash != actualHash)
       {
@@ -3306,6 +3437,18 @@ cmFileCommand::HandleDownloadCommand(std::vector<std::string> const& args)
       }
     }
 
+  // Add the verified file to the download cache.  A copy is renamed into
+  // place so that the entry appears complete or not at all.
+  if (cacheFill)
+    {
+    std::string cacheTemp = cacheFile + ".tmp";
+    if (!cmSystemTools::cmCopyFile(file.c_str(), cacheTemp.c_str()) ||
+        !cmSystemTools::RenameFile(cacheTemp.c_str(), cacheFile.c_str()))
+      {
+      cmSystemTools::RemoveFile(cacheTemp);
+      }
+    }
+
   if (!logVar.empty())
     {
     chunkDebug.push_back(0);
@@ -3771,6 +3914,7 @@ bool cmFileCommand::HandleLockCommand(
     return false;
     }
   fclose(file);
+  cmSystemTools::InvalidateFileCache(path);
 
   // Actual lock/unlock
   cmFileLockPool& lockPool = this->Makefile->GetGlobalGenerator()
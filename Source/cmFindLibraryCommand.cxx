@@ -105,7 +105,7 @@ void cmFindLibraryCommand::AddArchitecturePath(
 
     // Follow "lib<suffix>".
     std::string next_dir = cur_dir + suffix;
-    if(cmSystemTools::FileIsDirectory(next_dir))
+    if(cmSystemTools::CachedFileIsDirectory(next_dir))
       {
       next_dir += dir.substr(pos+3);
       std::string::size_type next_pos = pos+3+strlen(suffix)+1;
@@ -113,7 +113,7 @@ void cmFindLibraryCommand::AddArchitecturePath(
       }
 
     // Follow "lib".
-    if(cmSystemTools::FileIsDirectory(cur_dir))
+    if(cmSystemTools::CachedFileIsDirectory(cur_dir))
       {
       this->AddArchitecturePath(dir, pos+3+1, suffix, false);
       }
@@ -122,13 +122,13 @@ void cmFindLibraryCommand::AddArchitecturePath(
     {
     // Check for <dir><suffix>/.
     std::string cur_dir  = dir + suffix + "/";
-    if(cmSystemTools::FileIsDirectory(cur_dir))
+    if(cmSystemTools::CachedFileIsDirectory(cur_dir))
       {
       this->SearchPaths.push_back(cur_dir);
       }
 
     // Now add the original unchanged path
-    if(cmSystemTools::FileIsDirectory(dir))
+    if(cmSystemTools::CachedFileIsDirectory(dir))
       {
       this->SearchPaths.push_back(dir);
       }
@@ -348,7 +348,7 @@ bool cmFindLibraryHelper::CheckDirectoryForName(std::string const& path,
     {
     this->TestPath = path;
     this->TestPath += name.Raw;
-    if(cmSystemTools::FileExists(this->TestPath.c_str(), true))
+    if(cmSystemTools::CachedFileExists(this->TestPath, true))
       {
       this->BestPath =
         cmSystemTools::CollapseFullPath(this->TestPath);
@@ -380,7 +380,7 @@ bool cmFindLibraryHelper::CheckDirectoryForName(std::string const& path,
       {
       this->TestPath = path;
       this->TestPath += origName;
-      if(!cmSystemTools::FileIsDirectory(this->TestPath))
+      if(!cmSystemTools::CachedFileIsDirectory(this->TestPath))
         {
         // This is a matching file.  Check if it is better than the
         // best name found so far.  Earlier prefixes are preferred,
@@ -504,7 +504,7 @@ std::string cmFindLibraryCommand::FindFrameworkLibraryNamesPerDir()
       fwPath = *di;
       fwPath += *ni;
       fwPath += ".framework";
-      if(cmSystemTools::FileIsDirectory(fwPath))
+      if(cmSystemTools::CachedFileIsDirectory(fwPath))
         {
         return cmSystemTools::CollapseFullPath(fwPath);
         }
@@ -530,7 +530,7 @@ std::string cmFindLibraryCommand::FindFrameworkLibraryDirsPerName()
       fwPath = *di;
       fwPath += *ni;
       fwPath += ".framework";
-      if(cmSystemTools::FileIsDirectory(fwPath))
+      if(cmSystemTools::CachedFileIsDirectory(fwPath))
         {
         return cmSystemTools::CollapseFullPath(fwPath);
         }
@@ -1402,10 +1402,10 @@ bool cmFindPackageCommand::CheckPackageRegistryEntry(const std::string& fname,
     {
     // The first line in the stream is the full path to a file or
     // directory containing the package.
-    if(cmSystemTools::FileExists(fname.c_str()))
+    if(cmSystemTools::CachedFileExists(fname))
       {
       // The path exists.  Look for the package here.
-      if(!cmSystemTools::FileIsDirectory(fname))
+      if(!cmSystemTools::CachedFileIsDirectory(fname))
         {
         outPaths.AddPath(cmSystemTools::GetFilenamePath(fname));
         }
@@ -1525,7 +1525,7 @@ bool cmFindPackageCommand::FindConfigFile(std::string const& dir,
       {
       fprintf(stderr, "Checking file [%s]\n", file.c_str());
       }
-    if(cmSystemTools::FileExists(file.c_str(), true) &&
+    if(cmSystemTools::CachedFileExists(file, true) &&
        this->CheckVersion(file))
       {
       return true;
@@ -1549,7 +1549,7 @@ bool cmFindPackageCommand::CheckVersion(std::string const& config_file)
   std::string version_file = version_file_base;
   version_file += "-version.cmake";
   if ((haveResult == false)
-       && (cmSystemTools::FileExists(version_file.c_str(), true)))
+       && (cmSystemTools::CachedFileExists(version_file, true)))
     {
     result = this->CheckVersionFile(version_file, version);
     haveResult = true;
@@ -1559,7 +1559,7 @@ bool cmFindPackageCommand::CheckVersion(std::string const& config_file)
   version_file = version_file_base;
   version_file += "Version.cmake";
   if ((haveResult == false)
-       && (cmSystemTools::FileExists(version_file.c_str(), true)))
+       && (cmSystemTools::CachedFileExists(version_file, true)))
     {
     result = this->CheckVersionFile(version_file, version);
     haveResult = true;
@@ -1859,16 +1859,12 @@ private:
     {
     // Construct a list of matches.
     std::vector<std::string> matches;
-    cmsys::Directory d;
-    d.Load(parent);
-    for(unsigned long i=0; i < d.GetNumberOfFiles(); ++i)
+    std::set<std::string> const& files =
+      cmSystemTools::CachedDirectoryContent(parent);
+    for(std::set<std::string>::const_iterator fi = files.begin();
+        fi != files.end(); ++fi)
       {
-      const char* fname = d.GetFile(i);
-      if(strcmp(fname, ".") == 0 ||
-         strcmp(fname, "..") == 0)
-        {
-        continue;
-        }
+      const char* fname = fi->c_str();
       for(std::vector<std::string>::const_iterator ni = this->Names.begin();
           ni != this->Names.end(); ++ni)
         {
@@ -1913,16 +1909,12 @@ private:
     {
     // Construct a list of matches.
     std::vector<std::string> matches;
-    cmsys::Directory d;
-    d.Load(parent);
-    for(unsigned long i=0; i < d.GetNumberOfFiles(); ++i)
+    std::set<std::string> const& files =
+      cmSystemTools::CachedDirectoryContent(parent);
+    for(std::set<std::string>::const_iterator fi = files.begin();
+        fi != files.end(); ++fi)
       {
-      const char* fname = d.GetFile(i);
-      if(strcmp(fname, ".") == 0 ||
-         strcmp(fname, "..") == 0)
-        {
-        continue;
-        }
+      const char* fname = fi->c_str();
       for(std::vector<std::string>::const_iterator ni = this->Names.begin();
           ni != this->Names.end(); ++ni)
         {
@@ -1967,22 +1959,22 @@ private:
     {
     // Look for matching files.
     std::vector<std::string> matches;
-    cmsys::Directory d;
-    d.Load(parent);
-    for(unsigned long i=0; i < d.GetNumberOfFiles(); ++i)
+    std::set<std::string> const& files =
+      cmSystemTools::CachedDirectoryContent(parent);
+    for(std::set<std::string>::const_iterator fi = files.begin();
+        fi != files.end(); ++fi)
       {
-      const char* fname = d.GetFile(i);
-      if(strcmp(fname, ".") == 0 ||
-         strcmp(fname, "..") == 0)
+      if(cmsysString_strcasecmp(fi->c_str(), this->String.c_str()) == 0)
         {
-        continue;
+        matches.push_back(*fi);
         }
-      if(cmsysString_strcasecmp(fname, this->String.c_str()) == 0)
+      }
+    for(std::vector<std::string>::const_iterator i = matches.begin();
+        i != matches.end(); ++i)
+      {
+      if(this->Consider(parent + *i, lister))
         {
-        if(this->Consider(parent + fname, lister))
-          {
-          return true;
-          }
+        return true;
         }
       }
     return false;
@@ -2020,7 +2012,7 @@ private:
     for(std::vector<std::string>::const_iterator fi = files.begin();
         fi != files.end(); ++fi)
       {
-      if(cmSystemTools::FileIsDirectory(*fi))
+      if(cmSystemTools::CachedFileIsDirectory(*fi))
         {
         if(this->Consider(*fi, lister))
           {
@@ -2048,7 +2040,7 @@ bool cmFindPackageCommand::SearchPrefix(std::string const& prefix_in)
     }
 
   // Skip this if the prefix does not exist.
-  if(!cmSystemTools::FileIsDirectory(prefix_in))
+  if(!cmSystemTools::CachedFileIsDirectory(prefix_in))
     {
     return false;
     }
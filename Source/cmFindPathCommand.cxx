@@ -115,7 +115,7 @@ cmFindPathCommand::FindHeaderInFramework(std::string const& file,
       std::string intPath = fpath;
       intPath += "/Headers/";
       intPath += fileName;
-      if(cmSystemTools::FileExists(intPath.c_str()))
+      if(cmSystemTools::CachedFileExists(intPath))
         {
         if(this->IncludeFileInPath)
           {
@@ -159,7 +159,7 @@ std::string cmFindPathCommand::FindNormalHeader()
       {
       tryPath = *p;
       tryPath += *ni;
-      if(cmSystemTools::FileExists(tryPath.c_str()))
+      if(cmSystemTools::CachedFileExists(tryPath))
         {
         if(this->IncludeFileInPath)
           {
@@ -49,7 +49,6 @@ typedef struct {
 #include "cmAlgorithms.h"
 #include "cmInstallGenerator.h"
 
-#include <cmsys/Directory.hxx>
 #include <cmsys/FStream.hxx>
 
 #if defined(CMAKE_BUILD_WITH_CMAKE)
@@ -1613,6 +1612,7 @@ void cmGlobalGenerator::ClearGeneratorMembers()
   this->RuleHashes.clear();
   this->DirectoryContentMap.clear();
   this->BinaryDirectories.clear();
+  cmSystemTools::ClearFileCache();
 }
 
 //----------------------------------------------------------------------------
@@ -2749,27 +2749,15 @@ cmGlobalGenerator::GetDirectoryContent(std::string const& dir, bool needDisk)
   DirectoryContent& dc = this->DirectoryContentMap[dir];
   if(needDisk)
     {
-    long mt = cmSystemTools::ModifiedTime(dir);
-    if (mt != dc.LastDiskTime)
+    unsigned long stamp;
+    std::set<std::string> const& disk =
+      cmSystemTools::CachedDirectoryContent(dir, &stamp);
+    if (stamp != dc.LastDiskStamp)
       {
-      // Reset to non-loaded directory content.
+      // Combine the target files with the new disk content.
       dc.All = dc.Generated;
-
-      // Load the directory content from disk.
-      cmsys::Directory d;
-      if(d.Load(dir))
-        {
-        unsigned long n = d.GetNumberOfFiles();
-        for(unsigned long i = 0; i < n; ++i)
-          {
-          const char* f = d.GetFile(i);
-          if(strcmp(f, ".") != 0 && strcmp(f, "..") != 0)
-            {
-            dc.All.insert(f);
-            }
-          }
-        }
-      dc.LastDiskTime = mt;
+      dc.All.insert(disk.begin(), disk.end());
+      dc.LastDiskStamp = stamp;
       }
     }
   return dc.All;
@@ -268,8 +268,8 @@ public:
                                         const std::string& suffix,
                                         std::string& dir);
 
-  /** Get the content of a directory.  Directory listings are cached
-      and re-loaded from disk only when modified.  During the generation
+  /** Get the content of a directory.  Directory listings come from
+      cmSystemTools::CachedDirectoryContent.  During the generation
       step the content will include the target files to be built even if
       they do not yet exist.  */
   std::set<std::string> const& GetDirectoryContent(std::string const& dir,
@@ -495,12 +495,13 @@ private:
   // Cache directory content and target files to be built.
   struct DirectoryContent
   {
-    long LastDiskTime;
+    unsigned long LastDiskStamp;
     std::set<std::string> All;
     std::set<std::string> Generated;
-    DirectoryContent(): LastDiskTime(-1) {}
+    DirectoryContent(): LastDiskStamp(0) {}
     DirectoryContent(DirectoryContent const& dc):
-      LastDiskTime(dc.LastDiskTime), All(dc.All), Generated(dc.Generated) {}
+      LastDiskStamp(dc.LastDiskStamp), All(dc.All),
+      Generated(dc.Generated) {}
   };
   std::map<std::string, DirectoryContent> DirectoryContentMap;
 
@@ -391,7 +391,12 @@ void cmLocalNinjaGenerator::AppendCustomCommandLines(
       this->ConvertToOutputFormat(ccg.GetCommand(i), SHELL));
 
     std::string& cmd = cmdLines.back();
-    ccg.AppendArguments(i, cmd);
+    // Run consecutive file operations of "cmake -E" in one process.
+    unsigned int batched = ccg.AppendBatchArguments(i, cmd);
+    if (batched > 0)
+      i += batched - 1;
+    else
+      ccg.AppendArguments(i, cmd);
   }
 }
 
@@ -1129,7 +1129,16 @@ cmLocalUnixMakefileGenerator3
                            workingDir.empty()? START_OUTPUT : NONE);
       cmd = launcher + this->ConvertShellCommand(cmd, NONE);
 
-      ccg.AppendArguments(c, cmd);
+      // Run consecutive file operations of "cmake -E" in one process.
+      unsigned int batched = ccg.AppendBatchArguments(c, cmd);
+      if(batched > 0)
+        {
+        c += batched - 1;
+        }
+      else
+        {
+        ccg.AppendArguments(c, cmd);
+        }
       if(content)
         {
         // Rule content does not include the launcher.
@@ -32,6 +32,7 @@
 #include "cmInstallGenerator.h"
 #include "cmTestGenerator.h"
 #include "cmAlgorithms.h"
+#include "cmRegularExpression.h"
 #include "cmake.h"
 #include <stdlib.h> // required for atoi
 
@@ -4522,7 +4523,7 @@ void cmMakefile::ClearMatches()
 }
 
 //----------------------------------------------------------------------------
-void cmMakefile::StoreMatches(cmsys::RegularExpression& re)
+void cmMakefile::StoreMatches(cmRegularExpression& re)
 {
   char highest = 0;
   for (int i=0; i<10; i++)
@@ -40,6 +40,7 @@
 #include <stack>
 
 class cmFunctionBlocker;
+class cmRegularExpression;
 class cmCommand;
 class cmInstallGenerator;
 class cmLocalGenerator;
@@ -783,7 +784,7 @@ public:
   bool IsLoopBlock() const;
 
   void ClearMatches();
-  void StoreMatches(cmsys::RegularExpression& re);
+  void StoreMatches(cmRegularExpression& re);
 
   cmState::Snapshot GetStateSnapshot() const;
 
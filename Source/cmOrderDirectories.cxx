@@ -137,7 +137,7 @@ bool cmOrderDirectoriesConstraint::FileMayConflict(std::string const& dir,
   std::string file = dir;
   file += "/";
   file += name;
-  if(cmSystemTools::FileExists(file.c_str(), true))
+  if(cmSystemTools::CachedFileExists(file, true))
     {
     // The file conflicts only if it is not the same as the original
     // file due to a symlink or hardlink.
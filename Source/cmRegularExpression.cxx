@@ -0,0 +1,1003 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2015 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmRegularExpression.h"
+
+#include <cmsys/RegularExpression.hxx>
+
+#include <list>
+
+#include <string.h>
+
+// Each submatch records a start and an end.
+#define CM_REGEX_NCAPS (2 * cmRegularExpression::NSUBEXP)
+
+// Characters with a special meaning outside of [].
+#define CM_REGEX_META "^$.[()|?+*\\"
+
+#define CM_REGEX_ISMULT(c) ((c) == '*' || (c) == '+' || (c) == '?')
+
+// Largest number of (instruction, position) pairs tracked by the
+// backtracking matcher.  Longer inputs run the NFA simulation.
+#define CM_REGEX_BACKTRACK_STATES (256 * 1024)
+
+//----------------------------------------------------------------------------
+// The pattern compiled to instructions of a Thompson NFA.  The parser
+// follows the one of cmsys::RegularExpression so that both accept the
+// same syntax and agree on the numbering of submatches.
+class cmRegularExpression::Program
+{
+public:
+  enum OpCode
+    {
+    OpChar,   // Match the character Arg.
+    OpAny,    // Match any character.
+    OpClass,  // Match a character of class Arg.
+    OpBol,    // Match at the beginning of the string.
+    OpEol,    // Match at the end of the string.
+    OpSplit,  // Continue at X, and with lower priority at Y.
+    OpJmp,    // Continue at X.
+    OpSave,   // Record the position in capture Arg.
+    OpMatch   // The pattern matched.
+    };
+  struct Inst
+  {
+    OpCode Op;
+    int Arg;
+    int X;
+    int Y;
+  };
+
+  Program(): RefCount(1), NumCaps(0), IsLiteral(false), Anchored(false),
+    MatchesEmpty(true), Fallback(0), Parse(0), NumParens(1) {}
+  ~Program() { delete this->Fallback; }
+
+  bool Compile(std::string const& regex);
+
+  bool Matches(Inst const& inst, unsigned char c) const
+    {
+    switch (inst.Op)
+      {
+      case OpChar: return c == inst.Arg;
+      case OpAny: return true;
+      case OpClass: return this->Classes[inst.Arg * 256 + c] != 0;
+      default: return false;
+      }
+    }
+
+  unsigned int RefCount;
+  std::vector<Inst> Insts;
+  int NumCaps; // Captures of the groups used in the pattern.
+  std::vector<unsigned char> Classes;
+
+  // Patterns without operators are found by a plain string search.
+  bool IsLiteral;
+  std::string Literal;
+
+  // Where a match may start, to skip ahead when no match is in progress.
+  bool Anchored;
+  bool MatchesEmpty;
+  unsigned char First[256];
+
+  // Whether the thread at an instruction may go on with a character.
+  std::vector<unsigned char> Starts;
+  bool MayStart(int pc, unsigned char c) const
+    {
+    return c == 0 || this->Starts[pc * 256 + c] != 0;
+    }
+
+  // Patterns the parser does not handle are matched by cmsys.
+  cmsys::RegularExpression* Fallback;
+
+private:
+  enum { HasWidth = 1 };
+  bool ParseReg(bool paren, int* flagp);
+  bool ParseBranch(int* flagp);
+  bool ParsePiece(int* flagp);
+  bool ParseAtom(int* flagp);
+  bool ParseClass();
+  void Emit(OpCode op, int arg = 0, int x = 0, int y = 0);
+  void Insert(int pos, OpCode op, int x, int y);
+  void Analyze();
+  void AnalyzeStart(int pc, bool atBegin, bool atEnd,
+                    std::vector<bool>& visited, unsigned char* first,
+                    bool& empty);
+
+  const char* Parse;
+  int NumParens;
+};
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::Program::Compile(std::string const& regex)
+{
+  // Let cmsys validate the pattern and report its errors.
+  cmsys::RegularExpression re;
+  if(!re.compile(regex))
+    {
+    return false;
+    }
+
+  this->Parse = regex.c_str();
+  this->Emit(OpSave, 0);
+  int flags;
+  if(!this->ParseReg(false, &flags))
+    {
+    this->Insts.clear();
+    this->Classes.clear();
+    this->Fallback = new cmsys::RegularExpression(regex);
+    return true;
+    }
+  this->Emit(OpSave, 1);
+  this->Emit(OpMatch);
+  this->NumCaps = 2 * this->NumParens;
+  this->Analyze();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void cmRegularExpression::Program::Emit(OpCode op, int arg, int x, int y)
+{
+  Inst inst = { op, arg, x, y };
+  this->Insts.push_back(inst);
+}
+
+//----------------------------------------------------------------------------
+void cmRegularExpression::Program::Insert(int pos, OpCode op, int x, int y)
+{
+  // The instructions after pos were just emitted for one operand and only
+  // jump among themselves, so they move as a block.
+  for(std::vector<Inst>::iterator i = this->Insts.begin() + pos;
+      i != this->Insts.end(); ++i)
+    {
+    if(i->Op == OpSplit || i->Op == OpJmp)
+      {
+      ++i->X;
+      ++i->Y;
+      }
+    }
+  Inst inst = { op, 0, x, y };
+  this->Insts.insert(this->Insts.begin() + pos, inst);
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::Program::ParseReg(bool paren, int* flagp)
+{
+  *flagp = HasWidth;
+  int parno = 0;
+  if(paren)
+    {
+    if(this->NumParens >= NSUBEXP)
+      {
+      return false;
+      }
+    parno = this->NumParens++;
+    this->Emit(OpSave, 2 * parno);
+    }
+
+  // Each branch but the last is preferred over the following ones and
+  // jumps past them when it matched.
+  std::vector<int> jumps;
+  int start = static_cast<int>(this->Insts.size());
+  for(;;)
+    {
+    int flags;
+    if(!this->ParseBranch(&flags))
+      {
+      return false;
+      }
+    if(!(flags & HasWidth))
+      {
+      *flagp &= ~HasWidth;
+      }
+    if(*this->Parse != '|')
+      {
+      break;
+      }
+    ++this->Parse;
+    int next = static_cast<int>(this->Insts.size()) + 2;
+    this->Insert(start, OpSplit, start + 1, next);
+    jumps.push_back(static_cast<int>(this->Insts.size()));
+    this->Emit(OpJmp);
+    start = next;
+    }
+  for(std::vector<int>::const_iterator ji = jumps.begin();
+      ji != jumps.end(); ++ji)
+    {
+    this->Insts[*ji].X = static_cast<int>(this->Insts.size());
+    }
+
+  if(paren)
+    {
+    this->Emit(OpSave, 2 * parno + 1);
+    return *this->Parse++ == ')';
+    }
+  return *this->Parse == '\0';
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::Program::ParseBranch(int* flagp)
+{
+  *flagp = 0;
+  while(*this->Parse != '\0' && *this->Parse != '|' && *this->Parse != ')')
+    {
+    int flags;
+    if(!this->ParsePiece(&flags))
+      {
+      return false;
+      }
+    *flagp |= flags & HasWidth;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::Program::ParsePiece(int* flagp)
+{
+  int start = static_cast<int>(this->Insts.size());
+  int flags;
+  if(!this->ParseAtom(&flags))
+    {
+    return false;
+    }
+  char op = *this->Parse;
+  if(!CM_REGEX_ISMULT(op))
+    {
+    *flagp = flags;
+    return true;
+    }
+  if(!(flags & HasWidth) && op != '?')
+    {
+    return false;
+    }
+  *flagp = (op == '+') ? HasWidth : 0;
+
+  // All repetitions are greedy.
+  int size = static_cast<int>(this->Insts.size());
+  switch (op)
+    {
+    case '*':
+      // Enter the loop at its test, so an iteration is one split.
+      this->Insert(start, OpJmp, size + 1, 0);
+      this->Emit(OpSplit, 0, start + 1, size + 2);
+      break;
+    case '+':
+      this->Emit(OpSplit, 0, start, size + 1);
+      break;
+    default:
+      this->Insert(start, OpSplit, start + 1, size + 1);
+      break;
+    }
+  ++this->Parse;
+  return !CM_REGEX_ISMULT(*this->Parse);
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::Program::ParseAtom(int* flagp)
+{
+  *flagp = 0;
+  switch (*this->Parse++)
+    {
+    case '^':
+      this->Emit(OpBol);
+      break;
+    case '$':
+      this->Emit(OpEol);
+      break;
+    case '.':
+      this->Emit(OpAny);
+      *flagp |= HasWidth;
+      break;
+    case '[':
+      if(!this->ParseClass())
+        {
+        return false;
+        }
+      *flagp |= HasWidth;
+      break;
+    case '(':
+      {
+      int flags;
+      if(!this->ParseReg(true, &flags))
+        {
+        return false;
+        }
+      *flagp |= flags & HasWidth;
+      }
+      break;
+    case '\0':
+    case '|':
+    case ')':
+    case '?':
+    case '+':
+    case '*':
+      return false;
+    case '\\':
+      if(*this->Parse == '\0')
+        {
+        return false;
+        }
+      this->Emit(OpChar, static_cast<unsigned char>(*this->Parse++));
+      *flagp |= HasWidth;
+      break;
+    default:
+      {
+      --this->Parse;
+      size_t len = strcspn(this->Parse, CM_REGEX_META);
+      if(len == 0)
+        {
+        return false;
+        }
+      // Leave the last character to a following operator.
+      if(len > 1 && CM_REGEX_ISMULT(this->Parse[len]))
+        {
+        --len;
+        }
+      for(; len > 0; --len)
+        {
+        this->Emit(OpChar, static_cast<unsigned char>(*this->Parse++));
+        }
+      *flagp |= HasWidth;
+      }
+      break;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::Program::ParseClass()
+{
+  bool negate = false;
+  if(*this->Parse == '^')
+    {
+    negate = true;
+    ++this->Parse;
+    }
+  unsigned char members[256];
+  memset(members, 0, sizeof(members));
+  if(*this->Parse == ']' || *this->Parse == '-')
+    {
+    members[static_cast<unsigned char>(*this->Parse++)] = 1;
+    }
+  while(*this->Parse != '\0' && *this->Parse != ']')
+    {
+    if(*this->Parse == '-')
+      {
+      ++this->Parse;
+      if(*this->Parse == ']' || *this->Parse == '\0')
+        {
+        members['-'] = 1;
+        }
+      else
+        {
+        // The range starts after the character before the '-', which
+        // is already a member.
+        int c = static_cast<unsigned char>(this->Parse[-2]) + 1;
+        int last = static_cast<unsigned char>(*this->Parse++);
+        if(c > last + 1)
+          {
+          return false;
+          }
+        for(; c <= last; ++c)
+          {
+          members[c] = 1;
+          }
+        }
+      }
+    else
+      {
+      members[static_cast<unsigned char>(*this->Parse++)] = 1;
+      }
+    }
+  if(*this->Parse++ != ']')
+    {
+    return false;
+    }
+
+  int index = static_cast<int>(this->Classes.size() / 256);
+  for(int c = 0; c < 256; ++c)
+    {
+    this->Classes.push_back((members[c] != 0) != negate ? 1 : 0);
+    }
+  this->Emit(OpClass, index);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void cmRegularExpression::Program::Analyze()
+{
+  // A pattern of plain characters needs no automaton.
+  this->IsLiteral = true;
+  for(std::vector<Inst>::const_iterator i = this->Insts.begin() + 1;
+      i + 2 != this->Insts.end(); ++i)
+    {
+    if(i->Op != OpChar)
+      {
+      this->IsLiteral = false;
+      break;
+      }
+    this->Literal += static_cast<char>(i->Arg);
+    }
+
+  // Collect the characters a match may start with past the beginning
+  // of the string.
+  size_t size = this->Insts.size();
+  std::vector<bool> visited(size, false);
+  this->MatchesEmpty = false;
+  memset(this->First, 0, sizeof(this->First));
+  this->AnalyzeStart(0, false, true, visited, this->First,
+                     this->MatchesEmpty);
+  this->Anchored = !this->MatchesEmpty;
+  for(int c = 0; c < 256 && this->Anchored; ++c)
+    {
+    this->Anchored = this->First[c] == 0;
+    }
+
+  // Collect the characters the alternatives of each split may continue
+  // with before the end of the string, to skip the hopeless ones.
+  this->Starts.assign(size * 256, 1);
+  for(size_t pc = 0; pc < size; ++pc)
+    {
+    if(this->Insts[pc].Op != OpSplit)
+      {
+      continue;
+      }
+    int targets[2] = { this->Insts[pc].X, this->Insts[pc].Y };
+    for(int t = 0; t < 2; ++t)
+      {
+      unsigned char* first = &this->Starts[targets[t] * 256];
+      bool empty = false;
+      memset(first, 0, 256);
+      visited.assign(size, false);
+      this->AnalyzeStart(targets[t], true, false, visited, first, empty);
+      if(empty)
+        {
+        memset(first, 1, 256);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void cmRegularExpression::Program::AnalyzeStart(int pc, bool atBegin,
+                                                bool atEnd,
+                                                std::vector<bool>& visited,
+                                                unsigned char* first,
+                                                bool& empty)
+{
+  if(visited[pc])
+    {
+    return;
+    }
+  visited[pc] = true;
+  Inst const& inst = this->Insts[pc];
+  switch (inst.Op)
+    {
+    case OpSplit:
+      this->AnalyzeStart(inst.X, atBegin, atEnd, visited, first, empty);
+      this->AnalyzeStart(inst.Y, atBegin, atEnd, visited, first, empty);
+      break;
+    case OpJmp:
+      this->AnalyzeStart(inst.X, atBegin, atEnd, visited, first, empty);
+      break;
+    case OpSave:
+      this->AnalyzeStart(pc + 1, atBegin, atEnd, visited, first, empty);
+      break;
+    case OpBol:
+      if(atBegin)
+        {
+        this->AnalyzeStart(pc + 1, atBegin, atEnd, visited, first, empty);
+        }
+      break;
+    case OpEol:
+      if(atEnd)
+        {
+        this->AnalyzeStart(pc + 1, atBegin, atEnd, visited, first, empty);
+        }
+      break;
+    case OpMatch:
+      empty = true;
+      break;
+    default:
+      for(int c = 1; c < 256; ++c)
+        {
+        if(this->Matches(inst, static_cast<unsigned char>(c)))
+          {
+          first[c] = 1;
+          }
+        }
+      break;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Process-wide cache of compiled patterns, dropping the least recently
+// used ones.  Patterns in use stay alive through their reference count.
+class cmRegularExpressionCache
+{
+public:
+  typedef cmRegularExpression::Program Program;
+  ~cmRegularExpressionCache();
+  Program* Get(std::string const& regex);
+  static void Release(Program* prog)
+    {
+    if(prog && --prog->RefCount == 0)
+      {
+      delete prog;
+      }
+    }
+private:
+  enum { Capacity = 512 };
+  struct Entry
+  {
+    Program* Prog;
+    std::list<std::string>::iterator Use;
+  };
+  std::map<std::string, Entry> Entries;
+  std::list<std::string> Uses; // Most recently used first.
+};
+
+static cmRegularExpressionCache cmRegularExpressionCacheInstance;
+
+//----------------------------------------------------------------------------
+cmRegularExpressionCache::~cmRegularExpressionCache()
+{
+  for(std::map<std::string, Entry>::iterator i = this->Entries.begin();
+      i != this->Entries.end(); ++i)
+    {
+    Release(i->second.Prog);
+    }
+}
+
+//----------------------------------------------------------------------------
+cmRegularExpressionCache::Program*
+cmRegularExpressionCache::Get(std::string const& regex)
+{
+  std::map<std::string, Entry>::iterator i = this->Entries.find(regex);
+  if(i != this->Entries.end())
+    {
+    this->Uses.splice(this->Uses.begin(), this->Uses, i->second.Use);
+    ++i->second.Prog->RefCount;
+    return i->second.Prog;
+    }
+
+  // Invalid patterns are not kept so that every compile reports them.
+  Program* prog = new Program;
+  if(!prog->Compile(regex))
+    {
+    delete prog;
+    return 0;
+    }
+  if(this->Entries.size() >= Capacity)
+    {
+    std::map<std::string, Entry>::iterator old =
+      this->Entries.find(this->Uses.back());
+    Release(old->second.Prog);
+    this->Entries.erase(old);
+    this->Uses.pop_back();
+    }
+  this->Uses.push_front(regex);
+  Entry entry = { prog, this->Uses.begin() };
+  this->Entries[regex] = entry;
+  ++prog->RefCount;
+  return prog;
+}
+
+//----------------------------------------------------------------------------
+cmRegularExpression::cmRegularExpression():
+  Prog(0), SearchString(0), Generation(0)
+{
+  memset(this->StartP, 0, sizeof(this->StartP));
+  memset(this->EndP, 0, sizeof(this->EndP));
+}
+
+//----------------------------------------------------------------------------
+cmRegularExpression::cmRegularExpression(std::string const& regex):
+  Prog(0), SearchString(0), Generation(0)
+{
+  memset(this->StartP, 0, sizeof(this->StartP));
+  memset(this->EndP, 0, sizeof(this->EndP));
+  this->compile(regex);
+}
+
+//----------------------------------------------------------------------------
+cmRegularExpression::cmRegularExpression(cmRegularExpression const& r):
+  Prog(0), SearchString(r.SearchString), Generation(0)
+{
+  memcpy(this->StartP, r.StartP, sizeof(this->StartP));
+  memcpy(this->EndP, r.EndP, sizeof(this->EndP));
+  if(r.Prog)
+    {
+    ++r.Prog->RefCount;
+    }
+  this->SetProgram(r.Prog);
+}
+
+//----------------------------------------------------------------------------
+cmRegularExpression::~cmRegularExpression()
+{
+  cmRegularExpressionCache::Release(this->Prog);
+}
+
+//----------------------------------------------------------------------------
+cmRegularExpression&
+cmRegularExpression::operator=(cmRegularExpression const& r)
+{
+  if(r.Prog)
+    {
+    ++r.Prog->RefCount;
+    }
+  this->SetProgram(r.Prog);
+  this->SearchString = r.SearchString;
+  memcpy(this->StartP, r.StartP, sizeof(this->StartP));
+  memcpy(this->EndP, r.EndP, sizeof(this->EndP));
+  return *this;
+}
+
+//----------------------------------------------------------------------------
+void cmRegularExpression::SetProgram(Program* prog)
+{
+  cmRegularExpressionCache::Release(this->Prog);
+  this->Prog = prog;
+  // The scratch space is sized for the program.
+  this->Threads.clear();
+  this->Captures.clear();
+  this->Marks.clear();
+  this->Generation = 0;
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::compile(std::string const& regex)
+{
+  this->SetProgram(cmRegularExpressionCacheInstance.Get(regex));
+  return this->Prog != 0;
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::find(const char* s)
+{
+  this->SearchString = s;
+  if(!this->Prog)
+    {
+    return false;
+    }
+  memset(this->StartP, 0, sizeof(this->StartP));
+  memset(this->EndP, 0, sizeof(this->EndP));
+
+  Program const& prog = *this->Prog;
+  if(prog.Fallback)
+    {
+    if(!prog.Fallback->find(s))
+      {
+      return false;
+      }
+    // cmsys gives no index for submatches that did not participate.
+    std::string::size_type len = strlen(s);
+    for(int n = 0; n < NSUBEXP; ++n)
+      {
+      std::string::size_type b = prog.Fallback->start(n);
+      std::string::size_type e = prog.Fallback->end(n);
+      if(b <= e && e <= len)
+        {
+        this->StartP[n] = s + b;
+        this->EndP[n] = s + e;
+        }
+      }
+    return true;
+    }
+  if(prog.IsLiteral)
+    {
+    const char* p = strstr(s, prog.Literal.c_str());
+    if(!p)
+      {
+      return false;
+      }
+    this->StartP[0] = p;
+    this->EndP[0] = p + prog.Literal.size();
+    return true;
+    }
+  return this->Run(s);
+}
+
+//----------------------------------------------------------------------------
+void cmRegularExpression::AddThread(int list, int pc, const char** caps,
+                                    const char* sp)
+{
+  // Follow the instructions that consume no input.  A thread reaching an
+  // instruction first has the higher priority, so later ones are dropped.
+  if(this->Marks[pc] == this->Generation)
+    {
+    return;
+    }
+  this->Marks[pc] = this->Generation;
+  Program::Inst const& inst = this->Prog->Insts[pc];
+  switch (inst.Op)
+    {
+    case Program::OpJmp:
+      this->AddThread(list, inst.X, caps, sp);
+      return;
+    case Program::OpSplit:
+      this->AddThread(list, inst.X, caps, sp);
+      this->AddThread(list, inst.Y, caps, sp);
+      return;
+    case Program::OpSave:
+      {
+      const char* old = caps[inst.Arg];
+      caps[inst.Arg] = sp;
+      this->AddThread(list, pc + 1, caps, sp);
+      caps[inst.Arg] = old;
+      }
+      return;
+    case Program::OpBol:
+      if(sp == this->SearchString)
+        {
+        this->AddThread(list, pc + 1, caps, sp);
+        }
+      return;
+    case Program::OpEol:
+      if(*sp == '\0')
+        {
+        this->AddThread(list, pc + 1, caps, sp);
+        }
+      return;
+    default:
+      break;
+    }
+  size_t size = this->Prog->Insts.size();
+  size_t t = list * size + this->Count[list]++;
+  this->Threads[t] = pc;
+  int ncaps = this->Prog->NumCaps;
+  memcpy(&this->Captures[t * ncaps], caps, ncaps * sizeof(const char*));
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::Backtrack(const char* s, size_t len)
+{
+  // Explore the alternatives depth-first in priority order, like cmsys
+  // does, but visit each instruction at each position at most once.  A
+  // state that failed fails again whatever the path to it, so the search
+  // stays linear in the size of the input.
+  Program const& prog = *this->Prog;
+  size_t positions = len + 1;
+  this->Visited.assign((prog.Insts.size() * positions + 31) / 32, 0);
+  const char* caps[CM_REGEX_NCAPS];
+  memset(caps, 0, sizeof(caps));
+
+  for(const char* p = s;; ++p)
+    {
+    if(p != s)
+      {
+      if(prog.Anchored)
+        {
+        return false;
+        }
+      if(!prog.MatchesEmpty)
+        {
+        while(*p && !prog.First[static_cast<unsigned char>(*p)])
+          {
+          ++p;
+          }
+        if(!*p)
+          {
+          return false;
+          }
+        }
+      }
+
+    Job start = { 0, p };
+    this->Jobs.push_back(start);
+    while(!this->Jobs.empty())
+      {
+      Job job = this->Jobs.back();
+      this->Jobs.pop_back();
+      if(job.Pc < 0)
+        {
+        caps[-1 - job.Pc] = job.Sp;
+        continue;
+        }
+      int pc = job.Pc;
+      const char* sp = job.Sp;
+      for(bool alive = true; alive;)
+        {
+        size_t state = pc * positions + (sp - s);
+        unsigned int bit = 1u << (state % 32);
+        if(this->Visited[state / 32] & bit)
+          {
+          break;
+          }
+        this->Visited[state / 32] |= bit;
+        Program::Inst const& inst = prog.Insts[pc];
+        switch (inst.Op)
+          {
+          case Program::OpMatch:
+            {
+            this->Jobs.clear();
+            for(int n = 0; n < NSUBEXP; ++n)
+              {
+              this->StartP[n] = caps[2 * n];
+              this->EndP[n] = caps[2 * n + 1];
+              }
+            }
+            return true;
+          case Program::OpSplit:
+            {
+            unsigned char c = static_cast<unsigned char>(*sp);
+            bool x = prog.MayStart(inst.X, c);
+            if(prog.MayStart(inst.Y, c))
+              {
+              Job alternative = { inst.Y, sp };
+              if(!x)
+                {
+                pc = inst.Y;
+                break;
+                }
+              this->Jobs.push_back(alternative);
+              }
+            alive = x;
+            pc = inst.X;
+            }
+            break;
+          case Program::OpJmp:
+            pc = inst.X;
+            break;
+          case Program::OpSave:
+            {
+            Job restore = { -1 - inst.Arg, caps[inst.Arg] };
+            this->Jobs.push_back(restore);
+            caps[inst.Arg] = sp;
+            ++pc;
+            }
+            break;
+          case Program::OpBol:
+            alive = sp == s;
+            ++pc;
+            break;
+          case Program::OpEol:
+            alive = *sp == '\0';
+            ++pc;
+            break;
+          default:
+            alive = *sp && prog.Matches(inst, static_cast<unsigned char>(*sp));
+            ++pc;
+            ++sp;
+            break;
+          }
+        }
+      }
+    if(!*p)
+      {
+      return false;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool cmRegularExpression::Run(const char* s)
+{
+  Program const& prog = *this->Prog;
+  size_t size = prog.Insts.size();
+  size_t len = strlen(s);
+  if(size * (len + 1) <= CM_REGEX_BACKTRACK_STATES)
+    {
+    return this->Backtrack(s, len);
+    }
+  if(this->Marks.size() != size)
+    {
+    this->Threads.resize(2 * size);
+    this->Captures.resize(2 * size * prog.NumCaps);
+    this->Marks.assign(size, 0);
+    this->Generation = 0;
+    }
+
+  const char* caps[CM_REGEX_NCAPS];
+  memset(caps, 0, sizeof(caps));
+  const char* best[CM_REGEX_NCAPS];
+  memset(best, 0, sizeof(best));
+  bool matched = false;
+  int cur = 0;
+  this->Count[cur] = 0;
+  ++this->Generation;
+
+  // Advance all threads in step over the string, in priority order, and
+  // start a new one at each position until the leftmost match is found.
+  for(const char* sp = s;; ++sp)
+    {
+    if(!matched)
+      {
+      if(this->Count[cur] == 0 && sp != s)
+        {
+        if(prog.Anchored)
+          {
+          break;
+          }
+        if(!prog.MatchesEmpty)
+          {
+          while(*sp && !prog.First[static_cast<unsigned char>(*sp)])
+            {
+            ++sp;
+            }
+          if(!*sp)
+            {
+            break;
+            }
+          }
+        }
+      this->AddThread(cur, 0, caps, sp);
+      }
+
+    int next = 1 - cur;
+    this->Count[next] = 0;
+    if(++this->Generation == 0)
+      {
+      std::fill(this->Marks.begin(), this->Marks.end(), 0);
+      this->Generation = 1;
+      }
+    for(int i = 0; i < this->Count[cur]; ++i)
+      {
+      size_t t = cur * size + i;
+      Program::Inst const& inst = prog.Insts[this->Threads[t]];
+      const char** tcaps = &this->Captures[t * prog.NumCaps];
+      if(inst.Op == Program::OpMatch)
+        {
+        // Threads of lower priority cannot give the preferred match.
+        memcpy(best, tcaps, prog.NumCaps * sizeof(const char*));
+        matched = true;
+        break;
+        }
+      if(*sp && prog.Matches(inst, static_cast<unsigned char>(*sp)))
+        {
+        this->AddThread(next, this->Threads[t] + 1, tcaps, sp + 1);
+        }
+      }
+    if(!*sp || (matched && this->Count[next] == 0))
+      {
+      break;
+      }
+    cur = next;
+    }
+
+  if(!matched)
+    {
+    return false;
+    }
+  for(int n = 0; n < NSUBEXP; ++n)
+    {
+    this->StartP[n] = best[2 * n];
+    this->EndP[n] = best[2 * n + 1];
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::string::size_type cmRegularExpression::start(int n) const
+{
+  return this->StartP[n]?
+    static_cast<std::string::size_type>(this->StartP[n] - this->SearchString)
+    : std::string::npos;
+}
+
+//----------------------------------------------------------------------------
+std::string::size_type cmRegularExpression::end(int n) const
+{
+  return this->EndP[n]?
+    static_cast<std::string::size_type>(this->EndP[n] - this->SearchString)
+    : std::string::npos;
+}
+
+//----------------------------------------------------------------------------
+std::string cmRegularExpression::match(int n) const
+{
+  if(!this->StartP[n])
+    {
+    return std::string();
+    }
+  return std::string(this->StartP[n],
+    static_cast<std::string::size_type>(this->EndP[n] - this->StartP[n]));
+}
@@ -0,0 +1,95 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2015 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#ifndef cmRegularExpression_h
+#define cmRegularExpression_h
+
+#include "cmStandardIncludes.h"
+
+/** \class cmRegularExpression
+ * \brief Regular expression with the syntax of cmsys::RegularExpression.
+ *
+ * Patterns are accepted and matched exactly like cmsys::RegularExpression,
+ * which also reports the errors of invalid patterns.  Compiled patterns
+ * are kept in a process-wide cache, so compiling the same pattern again
+ * is a lookup.  Matching takes time linear in the input while finding
+ * the same leftmost match and submatches as cmsys.  When the pattern
+ * times the input length is small, a bit-state backtracker explores the
+ * alternatives in priority order but visits each instruction at each
+ * position at most once.  Longer inputs run a Thompson NFA simulation
+ * that follows all alternatives at once.
+ */
+class cmRegularExpression
+{
+public:
+  /** Number of submatches recorded, including the whole match.  */
+  enum { NSUBEXP = 10 };
+
+  cmRegularExpression();
+  cmRegularExpression(std::string const& regex);
+  cmRegularExpression(cmRegularExpression const& r);
+  ~cmRegularExpression();
+  cmRegularExpression& operator=(cmRegularExpression const& r);
+
+  /**
+   * Compile the given pattern.  Returns false if it is invalid.
+   */
+  bool compile(std::string const& regex);
+
+  /**
+   * Find the pattern in the given string.  Returns true if found, and
+   * sets the start and end indexes accordingly.
+   */
+  bool find(const char* s);
+  bool find(std::string const& s) { return this->find(s.c_str()); }
+
+  /**
+   * Index of the start and end of the nth submatch of the last find,
+   * or std::string::npos if it did not participate in the match.
+   */
+  std::string::size_type start(int n = 0) const;
+  std::string::size_type end(int n = 0) const;
+
+  /** The nth submatch of the last find as a string.  */
+  std::string match(int n) const;
+
+  bool is_valid() const { return this->Prog != 0; }
+
+private:
+  class Program;
+  friend class cmRegularExpressionCache;
+
+  void SetProgram(Program* prog);
+  bool Run(const char* s);
+  bool Backtrack(const char* s, size_t len);
+  void AddThread(int list, int pc, const char** caps, const char* sp);
+
+  Program* Prog;
+  const char* SearchString;
+  const char* StartP[NSUBEXP];
+  const char* EndP[NSUBEXP];
+
+  // Scratch space of find, kept to avoid allocations in loops.
+  struct Job
+  {
+    int Pc; // Or the capture to restore as -1 - Pc.
+    const char* Sp;
+  };
+  std::vector<Job> Jobs;
+  std::vector<unsigned int> Visited;
+  std::vector<int> Threads;
+  std::vector<const char*> Captures;
+  std::vector<unsigned int> Marks;
+  unsigned int Generation;
+  int Count[2];
+};
+
+#endif
@@ -11,8 +11,8 @@
 ============================================================================*/
 #include "cmStringCommand.h"
 #include "cmCryptoHash.h"
+#include "cmRegularExpression.h"
 
-#include <cmsys/RegularExpression.hxx>
 #include <cmsys/SystemTools.hxx>
 
 #include <stdlib.h> // required for atoi
@@ -309,8 +309,8 @@ bool cmStringCommand::RegexMatch(std::vector<std::string> const& args)
 
   this->Makefile->ClearMatches();
   // Compile the regular expression.
-  cmsys::RegularExpression re;
-  if(!re.compile(regex.c_str()))
+  cmRegularExpression re;
+  if(!re.compile(regex))
     {
     std::string e =
       "sub-command REGEX, mode MATCH failed to compile regex \""+regex+"\".";
@@ -354,8 +354,8 @@ bool cmStringCommand::RegexMatchAll(std::vector<std::string> const& args)
 
   this->Makefile->ClearMatches();
   // Compile the regular expression.
-  cmsys::RegularExpression re;
-  if(!re.compile(regex.c_str()))
+  cmRegularExpression re;
+  if(!re.compile(regex))
     {
     std::string e =
       "sub-command REGEX, mode MATCHALL failed to compile regex \""+
@@ -454,8 +454,8 @@ bool cmStringCommand::RegexReplace(std::vector<std::string> const& args)
 
   this->Makefile->ClearMatches();
   // Compile the regular expression.
-  cmsys::RegularExpression re;
-  if(!re.compile(regex.c_str()))
+  cmRegularExpression re;
+  if(!re.compile(regex))
     {
     std::string e =
       "sub-command REGEX, mode REPLACE failed to compile regex \""+
@@ -26,6 +26,8 @@
 #include <cmsys/System.h>
 #include <cmsys/Encoding.hxx>
 #if defined(CMAKE_BUILD_WITH_CMAKE)
+# include "cmArchiveDecompressor.h"
+# include "cmArchiveDiskWriter.h"
 # include "cmArchiveWrite.h"
 # include "cmLocale.h"
 # include <cm_libarchive.h>
@@ -739,6 +741,10 @@ bool cmSystemTools::RunSingleCommand(std::vector<std::string>const& command,
     }
 
   cmsysProcess_WaitForExit(cp, 0);
+
+  // The child may have changed any file.
+  cmSystemTools::ClearFileCache();
+
   if ( captureStdOut && tempStdOut.begin() != tempStdOut.end())
     {
     captureStdOut->append(&*tempStdOut.begin(), tempStdOut.size());
@@ -888,14 +894,293 @@ std::string cmSystemTools::FileExistsInParentDirectories(const char* fname,
   return "";
 }
 
+//----------------------------------------------------------------------------
+struct cmSystemToolsFileCacheEntry
+{
+  cmSystemToolsFileCacheEntry(): Exists(-1), IsDirectory(-1) {}
+  // Each is -1 until queried.
+  signed char Exists;
+  signed char IsDirectory;
+};
+
+struct cmSystemToolsDirectoryCacheEntry
+{
+  std::set<std::string> Files;
+  unsigned long Stamp;
+};
+
+// All keys are collapsed full paths.
+typedef std::map<std::string, cmSystemToolsFileCacheEntry>
+  cmSystemToolsFileCacheMap;
+typedef std::map<std::string, cmSystemToolsDirectoryCacheEntry>
+  cmSystemToolsDirectoryCacheMap;
+static cmSystemToolsFileCacheMap cmSystemToolsFileCache;
+static cmSystemToolsDirectoryCacheMap cmSystemToolsDirectoryCache;
+static unsigned long cmSystemToolsDirectoryCacheStamp = 0;
+
+//----------------------------------------------------------------------------
+static bool cmSystemToolsSplitParent(std::string const& path,
+                                     std::string& dir, std::string& name)
+{
+  std::string::size_type slash = path.rfind('/');
+  if(slash == std::string::npos || slash + 1 == path.size())
+    {
+    return false;
+    }
+  // Keep the slash of a root directory such as "/" or "c:/".
+  if(slash == 0 || path[slash - 1] == ':')
+    {
+    dir = path.substr(0, slash + 1);
+    }
+  else
+    {
+    dir = path.substr(0, slash);
+    }
+  name = path.substr(slash + 1);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+static cmSystemToolsFileCacheEntry&
+cmSystemToolsGetFileCacheEntry(std::string const& key)
+{
+  cmSystemToolsFileCacheMap::iterator i = cmSystemToolsFileCache.find(key);
+  if(i != cmSystemToolsFileCache.end())
+    {
+    return i->second;
+    }
+  cmSystemToolsFileCacheEntry& e = cmSystemToolsFileCache[key];
+
+  // A directory listing loaded before tells that a path does not exist.
+  std::string dir;
+  std::string name;
+  if(cmSystemToolsSplitParent(key, dir, name))
+    {
+    cmSystemToolsDirectoryCacheMap::const_iterator d =
+      cmSystemToolsDirectoryCache.find(dir);
+    if(d != cmSystemToolsDirectoryCache.end() &&
+       d->second.Files.find(name) == d->second.Files.end())
+      {
+      e.Exists = 0;
+      e.IsDirectory = 0;
+      }
+    }
+  return e;
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::CachedFileExists(std::string const& path, bool isFile)
+{
+  std::string key = cmSystemTools::CollapseFullPath(path);
+  cmSystemToolsFileCacheEntry& e = cmSystemToolsGetFileCacheEntry(key);
+  if(e.Exists < 0)
+    {
+    e.Exists = Superclass::FileExists(key)? 1 : 0;
+    }
+  if(e.Exists && isFile)
+    {
+    if(e.IsDirectory < 0)
+      {
+      e.IsDirectory = Superclass::FileIsDirectory(key)? 1 : 0;
+      }
+    return !e.IsDirectory;
+    }
+  return e.Exists != 0;
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::CachedFileIsDirectory(std::string const& path)
+{
+  std::string key = cmSystemTools::CollapseFullPath(path);
+  cmSystemToolsFileCacheEntry& e = cmSystemToolsGetFileCacheEntry(key);
+  if(e.IsDirectory < 0)
+    {
+    e.IsDirectory = Superclass::FileIsDirectory(key)? 1 : 0;
+    }
+  return e.IsDirectory != 0;
+}
+
+//----------------------------------------------------------------------------
+std::set<std::string> const&
+cmSystemTools::CachedDirectoryContent(std::string const& dir,
+                                      unsigned long* stamp)
+{
+  std::string key = cmSystemTools::CollapseFullPath(dir);
+  cmSystemToolsDirectoryCacheMap::iterator i =
+    cmSystemToolsDirectoryCache.find(key);
+  if(i == cmSystemToolsDirectoryCache.end())
+    {
+    i = cmSystemToolsDirectoryCache.insert(
+      cmSystemToolsDirectoryCacheMap::value_type(
+        key, cmSystemToolsDirectoryCacheEntry())).first;
+    i->second.Stamp = ++cmSystemToolsDirectoryCacheStamp;
+    cmsys::Directory d;
+    if(d.Load(key))
+      {
+      unsigned long n = d.GetNumberOfFiles();
+      for(unsigned long f = 0; f < n; ++f)
+        {
+        const char* name = d.GetFile(f);
+        if(strcmp(name, ".") != 0 && strcmp(name, "..") != 0)
+          {
+          i->second.Files.insert(name);
+          }
+        }
+      }
+    }
+  if(stamp)
+    {
+    *stamp = i->second.Stamp;
+    }
+  return i->second.Files;
+}
+
+//----------------------------------------------------------------------------
+template <class Map>
+static void cmSystemToolsEraseTree(Map& m, std::string const& key)
+{
+  m.erase(key);
+  std::string prefix = key;
+  if(prefix.empty() || prefix[prefix.size() - 1] != '/')
+    {
+    prefix += '/';
+    }
+  typename Map::iterator i = m.lower_bound(prefix);
+  typename Map::iterator e = i;
+  while(e != m.end() && e->first.compare(0, prefix.size(), prefix) == 0)
+    {
+    ++e;
+    }
+  m.erase(i, e);
+}
+
+//----------------------------------------------------------------------------
+void cmSystemTools::InvalidateFileCache(std::string const& path)
+{
+  if(cmSystemToolsFileCache.empty() && cmSystemToolsDirectoryCache.empty())
+    {
+    return;
+    }
+  std::string key = cmSystemTools::CollapseFullPath(path);
+  cmSystemToolsEraseTree(cmSystemToolsFileCache, key);
+  cmSystemToolsEraseTree(cmSystemToolsDirectoryCache, key);
+
+  // Creating a path may create its parent directories too.
+  std::string dir;
+  std::string name;
+  while(cmSystemToolsSplitParent(key, dir, name))
+    {
+    cmSystemToolsFileCache.erase(dir);
+    cmSystemToolsDirectoryCache.erase(dir);
+    key = dir;
+    }
+}
+
+//----------------------------------------------------------------------------
+void cmSystemTools::ClearFileCache()
+{
+  cmSystemToolsFileCache.clear();
+  cmSystemToolsDirectoryCache.clear();
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::MakeDirectory(const char* path)
+{
+  if(!path)
+    {
+    return false;
+    }
+  return cmSystemTools::MakeDirectory(std::string(path));
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::MakeDirectory(std::string const& path)
+{
+  cmSystemTools::InvalidateFileCache(path);
+  return Superclass::MakeDirectory(path);
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::CopyFileAlways(std::string const& source,
+                                   std::string const& destination)
+{
+  cmSystemTools::InvalidateFileCache(destination);
+  return Superclass::CopyFileAlways(source, destination);
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::CopyAFile(std::string const& source,
+                              std::string const& destination,
+                              bool always)
+{
+  cmSystemTools::InvalidateFileCache(destination);
+  return Superclass::CopyAFile(source, destination, always);
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::CopyADirectory(std::string const& source,
+                                   std::string const& destination,
+                                   bool always)
+{
+  cmSystemTools::InvalidateFileCache(destination);
+  return Superclass::CopyADirectory(source, destination, always);
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::RemoveFile(std::string const& source)
+{
+  cmSystemTools::InvalidateFileCache(source);
+  return Superclass::RemoveFile(source);
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::RemoveADirectory(std::string const& source)
+{
+  cmSystemTools::InvalidateFileCache(source);
+  return Superclass::RemoveADirectory(source);
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::Touch(std::string const& filename, bool create)
+{
+  cmSystemTools::InvalidateFileCache(filename);
+  return Superclass::Touch(filename, create);
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::CreateSymlink(std::string const& origName,
+                                  std::string const& newName)
+{
+  cmSystemTools::InvalidateFileCache(newName);
+  return Superclass::CreateSymlink(origName, newName);
+}
+
+//----------------------------------------------------------------------------
+bool cmSystemTools::CreateLink(std::string const& origName,
+                               std::string const& newName)
+{
+  // Create a hard link.
+  cmSystemTools::InvalidateFileCache(newName);
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  return CreateHardLinkW(cmsys::Encoding::ToWide(newName).c_str(),
+                         cmsys::Encoding::ToWide(origName).c_str(),
+                         0) != 0;
+#else
+  return ::link(origName.c_str(), newName.c_str()) == 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
 bool cmSystemTools::cmCopyFile(const char* source, const char* destination)
 {
+  cmSystemTools::InvalidateFileCache(destination);
   return Superclass::CopyFileAlways(source, destination);
 }
 
 bool cmSystemTools::CopyFileIfDifferent(const char* source,
   const char* destination)
 {
+  cmSystemTools::InvalidateFileCache(destination);
   return Superclass::CopyFileIfDifferent(source, destination);
 }
 
@@ -940,6 +1225,8 @@ cmSystemTools::WindowsFileRetry cmSystemTools::GetWindowsFileRetry()
 //----------------------------------------------------------------------------
 bool cmSystemTools::RenameFile(const char* oldname, const char* newname)
 {
+  cmSystemTools::InvalidateFileCache(oldname);
+  cmSystemTools::InvalidateFileCache(newname);
 #ifdef _WIN32
 # ifndef INVALID_FILE_ATTRIBUTES
 #  define INVALID_FILE_ATTRIBUTES ((DWORD)-1)
@@ -1477,19 +1764,34 @@ bool cmSystemTools::CreateTar(const char* outFileName,
                               const std::vector<std::string>& files,
                               cmTarCompression compressType,
                               bool verbose, std::string const& mtime,
-                              std::string const& format)
+                              std::string const& format,
+                              unsigned int threads)
 {
 #if defined(CMAKE_BUILD_WITH_CMAKE)
   std::string cwd = cmSystemTools::GetCurrentWorkingDirectory();
-  cmsys::ofstream fout(outFileName, std::ios::out | std::ios::binary);
-  if(!fout)
-    {
-    std::string e = "Cannot open output file \"";
-    e += outFileName;
-    e += "\": ";
-    e += cmSystemTools::GetLastSystemError();
-    cmSystemTools::Error(e.c_str());
-    return false;
+  cmsys::ofstream fout;
+  std::ostream* out = &std::cout;
+  if(strcmp(outFileName, "-") == 0)
+    {
+    // The archive itself goes to stdout.
+    verbose = false;
+#if defined(_WIN32)
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    }
+  else
+    {
+    fout.open(outFileName, std::ios::out | std::ios::binary);
+    if(!fout)
+      {
+      std::string e = "Cannot open output file \"";
+      e += outFileName;
+      e += "\": ";
+      e += cmSystemTools::GetLastSystemError();
+      cmSystemTools::Error(e.c_str());
+      return false;
+      }
+    out = &fout;
     }
   cmArchiveWrite::Compress compress = cmArchiveWrite::CompressNone;
   switch (compressType)
@@ -1508,8 +1810,8 @@ bool cmSystemTools::CreateTar(const char* outFileName,
       break;
     }
 
-  cmArchiveWrite a(fout, compress,
-    format.empty() ? "paxr" : format);
+  cmArchiveWrite a(*out, compress,
+    format.empty() ? "paxr" : format, threads);
 
   a.SetMTime(mtime);
   a.SetVerbose(verbose);
@@ -1527,7 +1829,7 @@ bool cmSystemTools::CreateTar(const char* outFileName,
       break;
       }
     }
-  if(!a)
+  if(!a.Finish())
     {
     cmSystemTools::Error(a.GetError().c_str());
     return false;
@@ -1537,6 +1839,7 @@ bool cmSystemTools::CreateTar(const char* outFileName,
   (void)outFileName;
   (void)files;
   (void)verbose;
+  (void)threads;
   return false;
 #endif
 }
@@ -1698,16 +2001,33 @@ long copy_data(struct archive *ar, struct archive *aw)
 }
 
 bool extract_tar(const char* outFileName, bool verbose,
-                 bool extract)
+                 bool extract, unsigned int threads)
 {
   cmLocaleRAII localeRAII;
   static_cast<void>(localeRAII);
+  cmArchiveDecompressor decompressor(threads);
+  cmArchiveDiskWriter writer(extract? threads : 1);
   struct archive* a = archive_read_new();
   struct archive *ext = archive_write_disk_new();
   archive_read_support_filter_all(a);
   archive_read_support_format_all(a);
   struct archive_entry *entry;
-  int r = cm_archive_read_open_file(a, outFileName, 10240);
+  int r;
+  if(strcmp(outFileName, "-") == 0)
+    {
+#if defined(_WIN32)
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    r = archive_read_open_fd(a, 0, 10240);
+    }
+  else if(decompressor.Open(a, outFileName))
+    {
+    r = ARCHIVE_OK;
+    }
+  else
+    {
+    r = cm_archive_read_open_file(a, outFileName, 10240);
+    }
   if(r)
     {
     cmSystemTools::Error("Problem with archive_read_open_file(): ",
@@ -1758,6 +2078,16 @@ bool extract_tar(const char* outFileName, bool verbose,
         break;
         }
 
+      // Small regular files are written on the threads of the writer.
+      if(writer.Add(a, entry))
+        {
+        if(writer.Failed())
+          {
+          break;
+          }
+        continue;
+        }
+
       r = archive_write_header(ext, entry);
       if (r == ARCHIVE_OK)
         {
@@ -1789,6 +2119,13 @@ bool extract_tar(const char* outFileName, bool verbose,
         }
       }
     }
+  // Finish the files before libarchive fixes up the directories.
+  if(!writer.Wait())
+    {
+    cmSystemTools::Error("Problem writing extracted files: ",
+                         writer.GetError().c_str());
+    r = ARCHIVE_FATAL;
+    }
   archive_write_free(ext);
   archive_read_close(a);
   archive_read_free(a);
@@ -1798,25 +2135,27 @@ bool extract_tar(const char* outFileName, bool verbose,
 #endif
 
 bool cmSystemTools::ExtractTar(const char* outFileName,
-                               bool verbose)
+                               bool verbose, unsigned int threads)
 {
 #if defined(CMAKE_BUILD_WITH_CMAKE)
-  return extract_tar(outFileName, verbose, true);
+  return extract_tar(outFileName, verbose, true, threads);
 #else
   (void)outFileName;
   (void)verbose;
+  (void)threads;
   return false;
 #endif
 }
 
 bool cmSystemTools::ListTar(const char* outFileName,
-                            bool verbose)
+                            bool verbose, unsigned int threads)
 {
 #if defined(CMAKE_BUILD_WITH_CMAKE)
-  return extract_tar(outFileName, verbose, false);
+  return extract_tar(outFileName, verbose, false, threads);
 #else
   (void)outFileName;
   (void)verbose;
+  (void)threads;
   return false;
 #endif
 }
@@ -179,6 +179,48 @@ public:
                          std::vector<std::string>& files,
                          int type = 0);
 
+  /**
+   * Cached versions of FileExists, FileIsDirectory and a directory
+   * listing.  Results are kept for the whole process, including those
+   * of missing paths, so repeated probes of the same candidates do not
+   * touch the disk again.  The file modification functions below forget
+   * the paths they change.  Code that writes files otherwise must call
+   * InvalidateFileCache, and the whole cache is cleared after running
+   * child processes.
+   */
+  static bool CachedFileExists(std::string const& path, bool isFile = false);
+  static bool CachedFileIsDirectory(std::string const& path);
+
+  /** Names in a directory other than "." and "..".  The optional stamp
+      changes each time the content is loaded from disk again.  */
+  static std::set<std::string> const&
+  CachedDirectoryContent(std::string const& dir, unsigned long* stamp = 0);
+
+  /** Forget cached results for a path, everything below it and its
+      parent directories.  */
+  static void InvalidateFileCache(std::string const& path);
+  static void ClearFileCache();
+
+  /** Superclass file modification functions that also forget the
+      cached results of the paths they change.  */
+  static bool MakeDirectory(const char* path);
+  static bool MakeDirectory(std::string const& path);
+  static bool CopyFileAlways(std::string const& source,
+                             std::string const& destination);
+  static bool CopyAFile(std::string const& source,
+                        std::string const& destination,
+                        bool always = true);
+  static bool CopyADirectory(std::string const& source,
+                             std::string const& destination,
+                             bool always = true);
+  static bool RemoveFile(std::string const& source);
+  static bool RemoveADirectory(std::string const& source);
+  static bool Touch(std::string const& filename, bool create);
+  static bool CreateSymlink(std::string const& origName,
+                            std::string const& newName);
+  static bool CreateLink(std::string const& origName,
+                         std::string const& newName);
+
   ///! Copy a file.
   static bool cmCopyFile(const char* source, const char* destination);
   static bool CopyFileIfDifferent(const char* source,
@@ -388,14 +430,19 @@ public:
     TarCompressXZ,
     TarCompressNone
   };
+  // The archive file name "-" means stdin or stdout.  Compression,
+  // decompression and writing of extracted files may use the given
+  // number of threads.
   static bool ListTar(const char* outFileName,
-                      bool verbose);
+                      bool verbose, unsigned int threads = 1);
   static bool CreateTar(const char* outFileName,
                         const std::vector<std::string>& files,
                         cmTarCompression compressType, bool verbose,
                         std::string const& mtime = std::string(),
-                        std::string const& format = std::string());
-  static bool ExtractTar(const char* inFileName, bool verbose);
+                        std::string const& format = std::string(),
+                        unsigned int threads = 1);
+  static bool ExtractTar(const char* inFileName, bool verbose,
+                         unsigned int threads = 1);
   // This should be called first thing in main
   // it will keep child processes from inheriting the
   // stdin and stdout of this process.  This is important
@@ -82,6 +82,7 @@ bool cmWriteFileCommand
     }
   file << message << std::endl;
   file.close();
+  cmSystemTools::InvalidateFileCache(fileName);
   if(mode)
     {
     cmSystemTools::SetPermissions(fileName.c_str(), mode);
@@ -377,6 +377,226 @@ static const sha_word64 sha512_initial_hash_value[8] = {
 static const char *sha_hex_digits = "0123456789abcdef";
 
 
+/*** SHA-NI: **********************************************************/
+/*
+ * CMake modification: on x86 processors with the SHA extensions, process
+ * whole blocks of SHA-1 and SHA-224/256 with the dedicated instructions.
+ * The compiler is asked for them per function, so the portable transforms
+ * remain the fallback and the choice is made at runtime with cpuid.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(__INTEL_COMPILER) && \
+    ((defined(__clang__) && \
+      (__clang_major__ > 3 || \
+       (__clang_major__ == 3 && __clang_minor__ >= 8)) && \
+      (!defined(__apple_build_version__) || __clang_major__ >= 8)) || \
+     (!defined(__clang__) && defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SHA2_HAVE_SHANI 1
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+/* -1 until the processor has been checked by SHA_DetectCPU() */
+static int SHA_Internal_SHANI = -1;
+
+static int SHA_Internal_HaveSHANI(void) {
+	if (SHA_Internal_SHANI < 0) {
+		SHA_DetectCPU();
+	}
+	return SHA_Internal_SHANI;
+}
+
+/* Four rounds of SHA-1 with message words msg, and the next e in eout: */
+#define SHANI_SHA1_ROUNDS(ein, eout, msg, f) \
+	ein = _mm_sha1nexte_epu32(ein, msg); \
+	eout = abcd; \
+	abcd = _mm_sha1rnds4_epu32(abcd, ein, f)
+
+/* The same, and schedule the words of later rounds: */
+#define SHANI_SHA1_STEP(ein, eout, cur, prev, next, prev2, f) \
+	SHANI_SHA1_ROUNDS(ein, eout, cur, f); \
+	next = _mm_sha1msg2_epu32(next, cur); \
+	prev = _mm_sha1msg1_epu32(prev, cur); \
+	prev2 = _mm_xor_si128(prev2, cur)
+
+SHANI_TARGET
+static void SHA1_Internal_Transform_SHANI(sha_word32* state,
+					  const sha_byte* data,
+					  size_t blocks) {
+	__m128i abcd, abcd_save, e0, e0_save, e1;
+	__m128i msg0, msg1, msg2, msg3;
+	const __m128i mask = _mm_set_epi64x(SHA_UINT64_C(0x0001020304050607),
+					    SHA_UINT64_C(0x08090a0b0c0d0e0f));
+
+	abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1b);
+	e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+	while (blocks-- > 0) {
+		abcd_save = abcd;
+		e0_save = e0;
+
+		msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), mask);
+		msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), mask);
+		msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), mask);
+		msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), mask);
+
+		/* Rounds 0-15, the first without a previous e */
+		e0 = _mm_add_epi32(e0, msg0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		SHANI_SHA1_ROUNDS(e1, e0, msg1, 0);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		SHANI_SHA1_ROUNDS(e0, e1, msg2, 0);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+		SHANI_SHA1_ROUNDS(e1, e0, msg3, 0);
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+
+		/* Rounds 16-67 */
+		SHANI_SHA1_STEP(e0, e1, msg0, msg3, msg1, msg2, 0);
+		SHANI_SHA1_STEP(e1, e0, msg1, msg0, msg2, msg3, 1);
+		SHANI_SHA1_STEP(e0, e1, msg2, msg1, msg3, msg0, 1);
+		SHANI_SHA1_STEP(e1, e0, msg3, msg2, msg0, msg1, 1);
+		SHANI_SHA1_STEP(e0, e1, msg0, msg3, msg1, msg2, 1);
+		SHANI_SHA1_STEP(e1, e0, msg1, msg0, msg2, msg3, 1);
+		SHANI_SHA1_STEP(e0, e1, msg2, msg1, msg3, msg0, 2);
+		SHANI_SHA1_STEP(e1, e0, msg3, msg2, msg0, msg1, 2);
+		SHANI_SHA1_STEP(e0, e1, msg0, msg3, msg1, msg2, 2);
+		SHANI_SHA1_STEP(e1, e0, msg1, msg0, msg2, msg3, 2);
+		SHANI_SHA1_STEP(e0, e1, msg2, msg1, msg3, msg0, 2);
+		SHANI_SHA1_STEP(e1, e0, msg3, msg2, msg0, msg1, 3);
+		SHANI_SHA1_STEP(e0, e1, msg0, msg3, msg1, msg2, 3);
+
+		/* Rounds 68-79, with the last words already scheduled */
+		SHANI_SHA1_ROUNDS(e1, e0, msg1, 3);
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		msg3 = _mm_xor_si128(msg3, msg1);
+		SHANI_SHA1_ROUNDS(e0, e1, msg2, 3);
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		SHANI_SHA1_ROUNDS(e1, e0, msg3, 3);
+
+		/* Add this block to the intermediate hash value */
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+		data += 64;
+	}
+
+	_mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1b));
+	state[4] = (sha_word32)_mm_extract_epi32(e0, 3);
+}
+
+/* Four rounds of SHA-256 with message words msg and constants K256[k]: */
+#define SHANI_SHA256_ROUNDS(msg, k) \
+	tmp = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i*)&K256[k])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, tmp); \
+	tmp = _mm_shuffle_epi32(tmp, 0x0e); \
+	state0 = _mm_sha256rnds2_epu32(state0, state1, tmp)
+
+/* Complete the words of next from cur and prev: */
+#define SHANI_SHA256_SCHEDULE(cur, prev, next) \
+	next = _mm_sha256msg2_epu32( \
+		_mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4)), cur)
+
+/* Four rounds, and schedule the words of later rounds: */
+#define SHANI_SHA256_STEP(cur, prev, next, k) \
+	SHANI_SHA256_ROUNDS(cur, k); \
+	SHANI_SHA256_SCHEDULE(cur, prev, next); \
+	prev = _mm_sha256msg1_epu32(prev, cur)
+
+SHANI_TARGET
+static void SHA256_Internal_Transform_SHANI(sha_word32* state,
+					    const sha_byte* data,
+					    size_t blocks) {
+	__m128i state0, state1, save0, save1, tmp;
+	__m128i msg0, msg1, msg2, msg3;
+	const __m128i mask = _mm_set_epi64x(SHA_UINT64_C(0x0c0d0e0f08090a0b),
+					    SHA_UINT64_C(0x0405060700010203));
+	int k;
+
+	/* The instructions keep the state as ABEF and CDGH */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state + 4)), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+	while (blocks-- > 0) {
+		save0 = state0;
+		save1 = state1;
+
+		msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), mask);
+		msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), mask);
+		msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), mask);
+		msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), mask);
+
+		/* Rounds 0-15 */
+		SHANI_SHA256_ROUNDS(msg0, 0);
+		SHANI_SHA256_ROUNDS(msg1, 4);
+		msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+		SHANI_SHA256_ROUNDS(msg2, 8);
+		msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+		SHANI_SHA256_ROUNDS(msg3, 12);
+		SHANI_SHA256_SCHEDULE(msg3, msg2, msg0);
+		msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+		/* Rounds 16-51 */
+		for (k = 16; k < 48; k += 16) {
+			SHANI_SHA256_STEP(msg0, msg3, msg1, k);
+			SHANI_SHA256_STEP(msg1, msg0, msg2, k + 4);
+			SHANI_SHA256_STEP(msg2, msg1, msg3, k + 8);
+			SHANI_SHA256_STEP(msg3, msg2, msg0, k + 12);
+		}
+		SHANI_SHA256_STEP(msg0, msg3, msg1, 48);
+
+		/* Rounds 52-63, with the last words already scheduled */
+		SHANI_SHA256_ROUNDS(msg1, 52);
+		SHANI_SHA256_SCHEDULE(msg1, msg0, msg2);
+		SHANI_SHA256_ROUNDS(msg2, 56);
+		SHANI_SHA256_SCHEDULE(msg2, msg1, msg3);
+		SHANI_SHA256_ROUNDS(msg3, 60);
+
+		/* Add this block to the intermediate hash value */
+		state0 = _mm_add_epi32(state0, save0);
+		state1 = _mm_add_epi32(state1, save1);
+		data += 64;
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	_mm_storeu_si128((__m128i*)state, _mm_blend_epi16(tmp, state1, 0xf0));
+	_mm_storeu_si128((__m128i*)(state + 4), _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#endif /* x86 with SHA-NI support in the compiler */
+
+/*
+ * Check once which instructions the processor has.  The first transform
+ * does this too, but threads hashing at the same time would race on it,
+ * so SHA_DetectCPU() is called before such threads are started.
+ */
+void SHA_DetectCPU(void) {
+#ifdef SHA2_HAVE_SHANI
+	unsigned int a, b, c, d;
+	int found = 0;
+	if (SHA_Internal_SHANI >= 0) {
+		return;
+	}
+	if (__get_cpuid(0, &a, &b, &c, &d) && a >= 7) {
+		/* SSSE3 and SSE4.1, then SHA in leaf 7 */
+		__cpuid(1, a, b, c, d);
+		if ((c & (1u << 9)) && (c & (1u << 19))) {
+			__cpuid_count(7, 0, a, b, c, d);
+			found = (b & (1u << 29)) != 0;
+		}
+	}
+	SHA_Internal_SHANI = found;
+#endif
+}
+
+
 /*** SHA-1: ***********************************************************/
 void SHA1_Init(SHA_CTX* context) {
 	/* Sanity check: */
@@ -642,6 +862,21 @@ void SHA1_Internal_Transform(SHA_CTX* context, const sha_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+/* CMake modification: process whole blocks on the fastest transform. */
+static void SHA1_Internal_Blocks(SHA_CTX* context, const sha_byte* data,
+				 size_t blocks) {
+#ifdef SHA2_HAVE_SHANI
+	if (SHA_Internal_HaveSHANI()) {
+		SHA1_Internal_Transform_SHANI(context->s1.state, data, blocks);
+		return;
+	}
+#endif
+	while (blocks-- > 0) {
+		SHA1_Internal_Transform(context, (const sha_word32*)data);
+		data += 64;
+	}
+}
+
 void SHA1_Update(SHA_CTX* context, const sha_byte *data, size_t len) {
 	unsigned int	freespace, usedspace;
 	if (len == 0) {
@@ -663,7 +898,7 @@ void SHA1_Update(SHA_CTX* context, const sha_byte *data, size_t len) {
 			context->s1.bitcount += freespace << 3;
 			len -= freespace;
 			data += freespace;
-			SHA1_Internal_Transform(context, (const sha_word32*)context->s1.buffer);
+			SHA1_Internal_Blocks(context, context->s1.buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			MEMCPY_BCOPY(&context->s1.buffer[usedspace], data, len);
@@ -673,12 +908,13 @@ void SHA1_Update(SHA_CTX* context, const sha_byte *data, size_t len) {
 			return;
 		}
 	}
-	while (len >= 64) {
+	if (len >= 64) {
 		/* Process as many complete blocks as we can */
-		SHA1_Internal_Transform(context, (const sha_word32*)data);
-		context->s1.bitcount += 512;
-		len -= 64;
-		data += 64;
+		size_t	blocks = len / 64;
+		SHA1_Internal_Blocks(context, data, blocks);
+		context->s1.bitcount += (sha_word64)blocks << 9;
+		len -= blocks * 64;
+		data += blocks * 64;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -982,6 +1218,21 @@ void SHA256_Internal_Transform(SHA_CTX* context, const sha_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+/* CMake modification: process whole blocks on the fastest transform. */
+static void SHA256_Internal_Blocks(SHA_CTX* context, const sha_byte* data,
+				 size_t blocks) {
+#ifdef SHA2_HAVE_SHANI
+	if (SHA_Internal_HaveSHANI()) {
+		SHA256_Internal_Transform_SHANI(context->s256.state, data, blocks);
+		return;
+	}
+#endif
+	while (blocks-- > 0) {
+		SHA256_Internal_Transform(context, (const sha_word32*)data);
+		data += 64;
+	}
+}
+
 void SHA256_Update(SHA_CTX* context, const sha_byte *data, size_t len) {
 	unsigned int	freespace, usedspace;
 
@@ -1004,7 +1255,7 @@ void SHA256_Update(SHA_CTX* context, const sha_byte *data, size_t len) {
 			context->s256.bitcount += freespace << 3;
 			len -= freespace;
 			data += freespace;
-			SHA256_Internal_Transform(context, (const sha_word32*)context->s256.buffer);
+			SHA256_Internal_Blocks(context, context->s256.buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			MEMCPY_BCOPY(&context->s256.buffer[usedspace], data, len);
@@ -1014,12 +1265,13 @@ void SHA256_Update(SHA_CTX* context, const sha_byte *data, size_t len) {
 			return;
 		}
 	}
-	while (len >= 64) {
+	if (len >= 64) {
 		/* Process as many complete blocks as we can */
-		SHA256_Internal_Transform(context, (const sha_word32*)data);
-		context->s256.bitcount += 512;
-		len -= 64;
-		data += 64;
+		size_t	blocks = len / 64;
+		SHA256_Internal_Blocks(context, data, blocks);
+		context->s256.bitcount += (sha_word64)blocks << 9;
+		len -= blocks * 64;
+		data += blocks * 64;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -98,6 +98,8 @@ typedef union _SHA_CTX {
 
 /*** SHA-256/384/512 Function Prototypes ******************************/
 
+void SHA_DetectCPU(void);
+
 void SHA1_Init(SHA_CTX*);
 void SHA1_Update(SHA_CTX*, const cm_sha2_uint8_t*, size_t);
 void SHA1_Final(cm_sha2_uint8_t[SHA1_DIGEST_LENGTH], SHA_CTX*);
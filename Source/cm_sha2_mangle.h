@@ -14,6 +14,7 @@
 
 /* Mangle sha2 symbol names to avoid possible conflict with
    implementations in other libraries to which CMake links.  */
+#define SHA_DetectCPU              cmSHA_DetectCPU
 #define SHA1_Data                  cmSHA1_Data
 #define SHA1_End                   cmSHA1_End
 #define SHA1_Final                 cmSHA1_Final
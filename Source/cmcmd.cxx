@@ -25,6 +25,9 @@
 #include <cmsys/Process.h>
 #include <cmsys/FStream.hxx>
 #include <cmsys/Terminal.h>
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+# include <cmsys/SystemInformation.hxx>
+#endif
 
 #if defined(CMAKE_HAVE_VS_GENERATORS)
 #include "cmCallVisualStudioMacro.h"
@@ -55,6 +58,8 @@ void CMakeCommandUsage(const char* program)
   errorStream
     << "Usage: " << program << " -E [command] [arguments ...]\n"
     << "Available commands: \n"
+    << "  batch (file|-|-- command [args]... [-- command [args]...]...)\n"
+    << "                            - run several commands in one process\n"
     << "  chdir dir cmd [args]...   - run command in a given directory\n"
     << "  compare_files file1 file2 - check if file1 is same as file2\n"
     << "  copy file destination     - copy file to destination (either file "
@@ -332,6 +337,12 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
       return ret;
       }
 
+    // Run several commands in this process
+    else if (args[1] == "batch" && args.size() > 2)
+      {
+      return cmcmd::ExecuteBatch(args);
+      }
+
     // Echo string
     else if (args[1] == "echo" )
       {
@@ -836,6 +847,7 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
       std::vector<std::string> files;
       std::string mtime;
       std::string format;
+      unsigned int threads = 1;
       bool doing_options = true;
       for (std::string::size_type cc = 4; cc < args.size(); cc ++)
         {
@@ -858,6 +870,30 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
               return 1;
               }
             }
+          else if (cmHasLiteralPrefix(arg, "--threads="))
+            {
+            unsigned long n = 0;
+            if (!cmSystemTools::StringToULong(arg.c_str() + 10, &n))
+              {
+              cmSystemTools::Error("Invalid -E tar --threads= argument: ",
+                arg.c_str() + 10);
+              return 1;
+              }
+            threads = static_cast<unsigned int>(n);
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+            if (threads == 0)
+              {
+              // Use every processor of the host.
+              cmsys::SystemInformation info;
+              info.RunCPUCheck();
+              threads = info.GetNumberOfLogicalCPU();
+              }
+#endif
+            if (threads == 0)
+              {
+              threads = 1;
+              }
+            }
           else if (cmHasLiteralPrefix(arg, "--format="))
             {
             format = arg.substr(9);
@@ -920,7 +956,7 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
 
       if ( flags.find_first_of('t') != flags.npos )
         {
-        if ( !cmSystemTools::ListTar(outFile.c_str(), verbose) )
+        if ( !cmSystemTools::ListTar(outFile.c_str(), verbose, threads) )
           {
           cmSystemTools::Error("Problem listing tar: ", outFile.c_str());
           return 1;
@@ -929,7 +965,8 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
       else if ( flags.find_first_of('c') != flags.npos )
         {
         if ( !cmSystemTools::CreateTar(
-               outFile.c_str(), files, compress, verbose, mtime, format) )
+               outFile.c_str(), files, compress, verbose, mtime, format,
+               threads) )
           {
           cmSystemTools::Error("Problem creating tar: ", outFile.c_str());
           return 1;
@@ -938,7 +975,7 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
       else if ( flags.find_first_of('x') != flags.npos )
         {
         if ( !cmSystemTools::ExtractTar(
-            outFile.c_str(), verbose) )
+            outFile.c_str(), verbose, threads) )
           {
           cmSystemTools::Error("Problem extracting tar: ", outFile.c_str());
           return 1;
@@ -1007,6 +1044,79 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int cmcmd::ExecuteBatch(std::vector<std::string>& args)
+{
+  // Each command is given with the name of the program first, as if it
+  // were run by "cmake -E" itself.
+  std::vector<std::vector<std::string> > commands;
+  if (args[2] == "--")
+    {
+    // The commands follow on the command line, each after a "--".
+    for (std::vector<std::string>::const_iterator a = args.begin() + 2;
+         a != args.end(); ++a)
+      {
+      if (*a == "--")
+        {
+        commands.push_back(std::vector<std::string>(1, args[0]));
+        }
+      else
+        {
+        commands.back().push_back(*a);
+        }
+      }
+    }
+  else if (args.size() == 3)
+    {
+    // The commands are read one per line from a file or stdin, with
+    // their arguments quoted as for a shell.
+    cmsys::ifstream fin;
+    std::istream* in = &std::cin;
+    if (args[2] != "-")
+      {
+      fin.open(args[2].c_str());
+      if (!fin)
+        {
+        std::cerr << "Error reading batch file \"" << args[2] << "\".\n";
+        return 1;
+        }
+      in = &fin;
+      }
+    std::string line;
+    while (cmSystemTools::GetLineFromStream(*in, line))
+      {
+      std::vector<std::string> command(1, args[0]);
+      cmSystemTools::ParseUnixCommandLine(line.c_str(), command);
+      if (command.size() > 1 && command[1][0] != '#')
+        {
+        commands.push_back(command);
+        }
+      }
+    }
+  else
+    {
+    ::CMakeCommandUsage(args[0].c_str());
+    return 1;
+    }
+
+  // Run the commands in order and stop at the first one failing.
+  for (std::vector<std::vector<std::string> >::iterator c = commands.begin();
+       c != commands.end(); ++c)
+    {
+    if (c->size() < 2)
+      {
+      continue;
+      }
+    int ret = cmcmd::ExecuteCMakeCommand(*c);
+    std::cout.flush();
+    if (ret != 0)
+      {
+      return ret;
+      }
+    }
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 int cmcmd::SymlinkLibrary(std::vector<std::string>& args)
 {
@@ -26,6 +26,7 @@ public:
   static int ExecuteCMakeCommand(std::vector<std::string>&);
 protected:
 
+  static int ExecuteBatch(std::vector<std::string>& args);
   static int SymlinkLibrary(std::vector<std::string>& args);
   static int SymlinkExecutable(std::vector<std::string>& args);
   static bool SymlinkInternal(std::string const& file,
@@ -75,6 +75,16 @@ static const char * cmDocumentationOptions[][2] =
    "Run a specific number of tests by number."},
   {"-U, --union", "Take the Union of -I and -R"},
   {"--rerun-failed", "Run only the tests that failed previously"},
+  {"--shard-index <i>", "Run only the tests assigned to shard <i>."},
+  {"--shard-count <n>", "Split the tests into <n> cost-balanced shards."},
+  {"--stop-on-failure [kill]", "Stop running tests after the first "
+   "failure."},
+  {"--adaptive-timeout <factor>", "Time out tests after <factor> times "
+   "their usual run time."},
+  {"--adaptive-timeout-floor <sec>", "Minimum timeout used by "
+   "--adaptive-timeout."},
+  {"--resource-report [<n>]", "List the <n> tests that used the most "
+   "CPU time and memory."},
   {"--repeat-until-fail <n>", "Require each test to run <n> "
    "times without failing in order to pass"},
   {"--max-width <width>", "Set the max width for a test name to output"},
@@ -99,6 +109,7 @@ static const char * cmDocumentationOptions[][2] =
   {"--test-command", "The test to run with the --build-and-test option."},
   {"--test-timeout", "The time limit in seconds, internal use only."},
   {"--test-load", "CPU load threshold for starting new parallel tests."},
+  {"--test-memory <mb>", "Memory budget for tests running in parallel."},
   {"--tomorrow-tag", "Nightly or experimental starts with next day tag."},
   {"--ctest-config", "The configuration file used to initialize CTest state "
    "when submitting dashboards."},
@@ -40,6 +40,9 @@ public:
   // Array of Files
   kwsys_stl::vector<kwsys_stl::string> Files;
 
+  // Kind of each file, if known from the listing
+  kwsys_stl::vector<Directory::FileType> FileTypes;
+
   // Path to Open'ed directory
   kwsys_stl::string Path;
 };
@@ -72,6 +75,16 @@ const char* Directory::GetFile(unsigned long dindex) const
   return this->Internal->Files[dindex].c_str();
 }
 
+//----------------------------------------------------------------------------
+Directory::FileType Directory::GetFileType(unsigned long dindex) const
+{
+  if ( dindex >= this->Internal->FileTypes.size() )
+    {
+    return FileTypeUnknown;
+    }
+  return this->Internal->FileTypes[dindex];
+}
+
 //----------------------------------------------------------------------------
 const char* Directory::GetPath() const
 {
@@ -83,6 +96,7 @@ void Directory::Clear()
 {
   this->Internal->Path.resize(0);
   this->Internal->Files.clear();
+  this->Internal->FileTypes.clear();
 }
 
 } // namespace KWSYS_NAMESPACE
@@ -147,6 +161,7 @@ bool Directory::Load(const kwsys_stl::string& name)
   do
     {
     this->Internal->Files.push_back(Encoding::ToNarrow(data.name));
+    this->Internal->FileTypes.push_back(FileTypeUnknown);
     }
   while ( _wfindnext(srchHandle, &data) != -1 );
   this->Internal->Path = name;
@@ -220,6 +235,25 @@ unsigned long Directory::GetNumberOfFilesInDirectory(const kwsys_stl::string& na
 namespace KWSYS_NAMESPACE
 {
 
+static Directory::FileType DirectoryFileType(kwsys_dirent* d)
+{
+#if defined(DT_UNKNOWN) && defined(DT_DIR) && defined(DT_REG) && \
+    defined(DT_LNK)
+  // Many file systems report the kind of file with the name.
+  switch (d->d_type)
+    {
+    case DT_UNKNOWN: return Directory::FileTypeUnknown;
+    case DT_REG: return Directory::FileTypeRegular;
+    case DT_DIR: return Directory::FileTypeDirectory;
+    case DT_LNK: return Directory::FileTypeSymlink;
+    default: return Directory::FileTypeOther;
+    }
+#else
+  (void)d;
+  return Directory::FileTypeUnknown;
+#endif
+}
+
 bool Directory::Load(const kwsys_stl::string& name)
 {
   this->Clear();
@@ -234,6 +268,7 @@ bool Directory::Load(const kwsys_stl::string& name)
   for (kwsys_dirent* d = readdir(dir); d; d = readdir(dir) )
     {
     this->Internal->Files.push_back(d->d_name);
+    this->Internal->FileTypes.push_back(DirectoryFileType(d));
     }
   this->Internal->Path = name;
   closedir(dir);
@@ -38,6 +38,16 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <string.h>
+
+#if defined(KWSYS_GLOB_USE_PTHREADS)
+# include KWSYS_HEADER(stl/deque)
+# if 0
+#  include "kwsys_stl_deque.hxx.in"
+# endif
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
 namespace KWSYS_NAMESPACE
 {
 #if defined(_WIN32) || defined(__APPLE__) || defined(__CYGWIN__)
@@ -73,6 +83,8 @@ Glob::Glob()
   // Keep separate variables for directory listing for back compatibility
   this->ListDirs = true;
   this->RecurseListDirs = false;
+
+  this->Threads = 1;
 }
 
 //----------------------------------------------------------------------------
@@ -220,10 +232,50 @@ kwsys_stl::string Glob::PatternToRegex(const kwsys_stl::string& pattern,
   return regex;
 }
 
+//----------------------------------------------------------------------------
+// Tell whether a listed file is a directory, following symlinks, and
+// optionally whether a directory is a symlink.  The file is examined
+// only when the listing did not report its kind.
+static bool GlobIsDirectory(Directory::FileType type,
+  const kwsys_stl::string& path, bool* isSymLink)
+{
+  bool isDir;
+  bool isLink = false;
+  switch(type)
+    {
+    case Directory::FileTypeRegular:
+    case Directory::FileTypeOther:
+      isDir = false;
+      break;
+    case Directory::FileTypeDirectory:
+      isDir = true;
+      break;
+    case Directory::FileTypeSymlink:
+      isDir = SystemTools::FileIsDirectory(path);
+      isLink = true;
+      break;
+    default:
+      isDir = SystemTools::FileIsDirectory(path);
+      isLink = isDir && isSymLink && SystemTools::FileIsSymlink(path);
+      break;
+    }
+  if(isSymLink)
+    {
+    *isSymLink = isLink;
+    }
+  return isDir;
+}
+
 //----------------------------------------------------------------------------
 bool Glob::RecurseDirectory(kwsys_stl::string::size_type start,
   const kwsys_stl::string& dir, GlobMessages* messages)
 {
+#if defined(KWSYS_GLOB_USE_PTHREADS)
+  if ( this->Threads != 1 )
+    {
+    return this->RecurseDirectoryParallel(start, dir, messages);
+    }
+#endif
   kwsys::Directory d;
   if ( !d.Load(dir) )
     {
@@ -254,8 +306,8 @@ bool Glob::RecurseDirectory(kwsys_stl::string::size_type start,
     fname = kwsys::SystemTools::LowerCase(fname);
 #endif
 
-    bool isDir = kwsys::SystemTools::FileIsDirectory(realname);
-    bool isSymLink = kwsys::SystemTools::FileIsSymlink(realname);
+    bool isSymLink;
+    bool isDir = GlobIsDirectory(d.GetFileType(cc), realname, &isSymLink);
 
     if ( isDir && (!isSymLink || this->RecurseThroughSymlinks) )
       {
@@ -337,6 +389,386 @@ bool Glob::RecurseDirectory(kwsys_stl::string::size_type start,
   return true;
 }
 
+#if defined(KWSYS_GLOB_USE_PTHREADS)
+//----------------------------------------------------------------------------
+// A directory listed by RecurseDirectoryParallel.  Its results are kept
+// in listing order so that they can be replayed exactly as the serial
+// traversal would have produced them.
+struct GlobTreeNode;
+
+struct GlobTreeItem
+{
+  enum Kind
+  {
+    File,         // Add Text to the files found.
+    Symlink,      // Count a followed symlink.
+    Subdirectory, // Replay the results of Child.
+    Cycle,        // Report the cyclic recursion Text.
+    Error         // Report the error Text and stop.
+  };
+  Kind Type;
+  kwsys_stl::string Text;
+  GlobTreeNode* Child;
+  GlobTreeItem(Kind type, const kwsys_stl::string& text,
+               GlobTreeNode* child = 0):
+    Type(type), Text(text), Child(child) {}
+};
+
+struct GlobTreeNode
+{
+  kwsys_stl::string Dir;
+  kwsys_stl::string::size_type Start;
+  kwsys_stl::vector<kwsys_stl::string> VisitedSymlinks;
+  kwsys_stl::vector<GlobTreeItem> Items;
+  GlobTreeNode(const kwsys_stl::string& dir,
+               kwsys_stl::string::size_type start,
+               const kwsys_stl::vector<kwsys_stl::string>& visited):
+    Dir(dir), Start(start), VisitedSymlinks(visited) {}
+  ~GlobTreeNode()
+    {
+    for(kwsys_stl::vector<GlobTreeItem>::iterator i = this->Items.begin();
+        i != this->Items.end(); ++i)
+      {
+      delete i->Child;
+      }
+    }
+private:
+  GlobTreeNode(const GlobTreeNode&);  // Not implemented.
+  void operator=(const GlobTreeNode&);  // Not implemented.
+};
+
+//----------------------------------------------------------------------------
+// Lists the directories of a tree on several threads.  Each worker takes
+// the directories it found last from its own queue, and steals the
+// oldest ones from the queues of the others when it has none left.
+// Helper threads are started only once there is work for them.
+class GlobTreeQueue
+{
+public:
+  GlobTreeQueue(unsigned int threads, const RegularExpression* expression,
+                bool throughSymlinks, bool listDirs);
+  ~GlobTreeQueue();
+
+  //! List root and all directories below it.
+  void Run(GlobTreeNode* root);
+
+private:
+  struct Helper
+  {
+    GlobTreeQueue* Queue;
+    unsigned int Worker;
+  };
+  static void* HelperMain(void* arg);
+
+  void Work(unsigned int worker);
+  void Scan(unsigned int worker, GlobTreeNode* node,
+            RegularExpression* expression);
+  void Push(unsigned int worker, GlobTreeNode* node);
+  GlobTreeNode* Pop(unsigned int worker);
+  void Done();
+
+  pthread_mutex_t Lock;
+  pthread_cond_t Wake;
+  kwsys_stl::vector<kwsys_stl::deque<GlobTreeNode*> > Queues;
+  kwsys_stl::vector<Helper> Helpers;
+  kwsys_stl::vector<pthread_t> HelperThreads;
+  unsigned int MaxThreads;
+  unsigned int Pending;
+  const RegularExpression* Expression;
+  bool ThroughSymlinks;
+  bool ListDirs;
+};
+
+//----------------------------------------------------------------------------
+GlobTreeQueue::GlobTreeQueue(unsigned int threads,
+                             const RegularExpression* expression,
+                             bool throughSymlinks, bool listDirs):
+  Queues(threads > 0? threads : 1), Helpers(threads > 0? threads : 1),
+  MaxThreads(threads > 0? threads : 1), Pending(0), Expression(expression),
+  ThroughSymlinks(throughSymlinks), ListDirs(listDirs)
+{
+  pthread_mutex_init(&this->Lock, 0);
+  pthread_cond_init(&this->Wake, 0);
+}
+
+//----------------------------------------------------------------------------
+GlobTreeQueue::~GlobTreeQueue()
+{
+  pthread_cond_destroy(&this->Wake);
+  pthread_mutex_destroy(&this->Lock);
+}
+
+//----------------------------------------------------------------------------
+void GlobTreeQueue::Run(GlobTreeNode* root)
+{
+  this->Pending = 1;
+  this->Queues[0].push_back(root);
+  this->Work(0);
+
+  // All directories are listed, so the helpers are about to return.
+  for(kwsys_stl::vector<pthread_t>::iterator i = this->HelperThreads.begin();
+      i != this->HelperThreads.end(); ++i)
+    {
+    pthread_join(*i, 0);
+    }
+}
+
+//----------------------------------------------------------------------------
+void* GlobTreeQueue::HelperMain(void* arg)
+{
+  Helper* helper = static_cast<Helper*>(arg);
+  helper->Queue->Work(helper->Worker);
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void GlobTreeQueue::Work(unsigned int worker)
+{
+  // Matching modifies the expression, so each worker has its own.
+  RegularExpression expression;
+  if(this->Expression)
+    {
+    expression = *this->Expression;
+    }
+  while(GlobTreeNode* node = this->Pop(worker))
+    {
+    this->Scan(worker, node, this->Expression? &expression : 0);
+    this->Done();
+    }
+}
+
+//----------------------------------------------------------------------------
+void GlobTreeQueue::Push(unsigned int worker, GlobTreeNode* node)
+{
+  pthread_mutex_lock(&this->Lock);
+  ++this->Pending;
+  this->Queues[worker].push_back(node);
+  unsigned int helpers =
+    static_cast<unsigned int>(this->HelperThreads.size());
+  if(helpers + 1 < this->MaxThreads)
+    {
+    Helper& helper = this->Helpers[helpers + 1];
+    helper.Queue = this;
+    helper.Worker = helpers + 1;
+    pthread_t thread;
+    if(pthread_create(&thread, 0, &GlobTreeQueue::HelperMain, &helper) == 0)
+      {
+      this->HelperThreads.push_back(thread);
+      }
+    else
+      {
+      // Continue with the threads we have.
+      this->MaxThreads = helpers + 1;
+      }
+    }
+  pthread_cond_signal(&this->Wake);
+  pthread_mutex_unlock(&this->Lock);
+}
+
+//----------------------------------------------------------------------------
+GlobTreeNode* GlobTreeQueue::Pop(unsigned int worker)
+{
+  GlobTreeNode* node = 0;
+  unsigned int n = static_cast<unsigned int>(this->Queues.size());
+  pthread_mutex_lock(&this->Lock);
+  while(!node)
+    {
+    kwsys_stl::deque<GlobTreeNode*>& own = this->Queues[worker];
+    if(!own.empty())
+      {
+      node = own.back();
+      own.pop_back();
+      break;
+      }
+    for(unsigned int i = 1; i < n && !node; ++i)
+      {
+      kwsys_stl::deque<GlobTreeNode*>& other = this->Queues[(worker + i) % n];
+      if(!other.empty())
+        {
+        node = other.front();
+        other.pop_front();
+        }
+      }
+    if(!node)
+      {
+      if(this->Pending == 0)
+        {
+        break;
+        }
+      pthread_cond_wait(&this->Wake, &this->Lock);
+      }
+    }
+  pthread_mutex_unlock(&this->Lock);
+  return node;
+}
+
+//----------------------------------------------------------------------------
+void GlobTreeQueue::Done()
+{
+  pthread_mutex_lock(&this->Lock);
+  if(--this->Pending == 0)
+    {
+    pthread_cond_broadcast(&this->Wake);
+    }
+  pthread_mutex_unlock(&this->Lock);
+}
+
+//----------------------------------------------------------------------------
+void GlobTreeQueue::Scan(unsigned int worker, GlobTreeNode* node,
+                         RegularExpression* expression)
+{
+  kwsys::Directory d;
+  if ( !d.Load(node->Dir) )
+    {
+    return;
+    }
+  unsigned long cc;
+  kwsys_stl::string realname;
+  kwsys_stl::string fname;
+  for ( cc = 0; cc < d.GetNumberOfFiles(); cc ++ )
+    {
+    fname = d.GetFile(cc);
+    if ( fname == "." || fname == ".." )
+      {
+      continue;
+      }
+
+    if ( node->Start == 0 )
+      {
+      realname = node->Dir + fname;
+      }
+    else
+      {
+      realname = node->Dir + "/" + fname;
+      }
+
+#if defined( KWSYS_GLOB_CASE_INDEPENDENT )
+    // On Windows and apple, no difference between lower and upper case
+    fname = kwsys::SystemTools::LowerCase(fname);
+#endif
+
+    bool isSymLink;
+    bool isDir = GlobIsDirectory(d.GetFileType(cc), realname, &isSymLink);
+
+    if ( isDir && (!isSymLink || this->ThroughSymlinks) )
+      {
+      kwsys_stl::vector<kwsys_stl::string> visited;
+      if (isSymLink)
+        {
+        node->Items.push_back(GlobTreeItem(GlobTreeItem::Symlink, ""));
+        kwsys_stl::string realPathErrorMessage;
+        kwsys_stl::string canonicalPath(SystemTools::GetRealPath(node->Dir,
+            &realPathErrorMessage));
+
+        if(!realPathErrorMessage.empty())
+          {
+          node->Items.push_back(GlobTreeItem(GlobTreeItem::Error,
+            "Canonical path generation from path '" + node->Dir +
+            "' failed! Reason: '" + realPathErrorMessage + "'"));
+          return;
+          }
+
+        kwsys_stl::vector<kwsys_stl::string>::const_iterator
+          pathIt = kwsys_stl::find(node->VisitedSymlinks.begin(),
+                                   node->VisitedSymlinks.end(),
+                                   canonicalPath);
+        if(pathIt != node->VisitedSymlinks.end())
+          {
+          // we have already visited this symlink - prevent cyclic recursion
+          kwsys_stl::string message;
+          for(; pathIt != node->VisitedSymlinks.end(); ++pathIt)
+            {
+            message += *pathIt + "\n";
+            }
+          message += canonicalPath + "/" + fname;
+          node->Items.push_back(GlobTreeItem(GlobTreeItem::Cycle, message));
+          continue;
+          }
+        visited = node->VisitedSymlinks;
+        visited.push_back(canonicalPath);
+        }
+      if(this->ListDirs)
+        {
+        node->Items.push_back(GlobTreeItem(GlobTreeItem::File, realname));
+        }
+      GlobTreeNode* child = new GlobTreeNode(realname, node->Start + 1,
+        isSymLink? visited : node->VisitedSymlinks);
+      node->Items.push_back(
+        GlobTreeItem(GlobTreeItem::Subdirectory, "", child));
+      this->Push(worker, child);
+      }
+    else
+      {
+      if ( expression && expression->find(fname) )
+        {
+        node->Items.push_back(GlobTreeItem(GlobTreeItem::File, realname));
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool Glob::RecurseDirectoryParallel(kwsys_stl::string::size_type start,
+  const kwsys_stl::string& dir, GlobMessages* messages)
+{
+  unsigned int threads = this->Threads;
+  if ( threads == 0 )
+    {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = n > 0? static_cast<unsigned int>(n) : 1;
+    }
+
+  GlobTreeNode root(dir, start, this->VisitedSymlinks);
+  {
+  GlobTreeQueue queue(threads,
+    this->Internals->Expressions.empty()? 0 :
+    &*this->Internals->Expressions.rbegin(),
+    this->RecurseThroughSymlinks, this->RecurseListDirs);
+  queue.Run(&root);
+  }
+
+  // Replay the results in the order of the serial traversal.
+  typedef kwsys_stl::pair<const GlobTreeNode*, size_t> Position;
+  kwsys_stl::vector<Position> stack;
+  stack.push_back(Position(&root, 0));
+  while ( !stack.empty() )
+    {
+    const GlobTreeNode* node = stack.back().first;
+    if ( stack.back().second == node->Items.size() )
+      {
+      stack.pop_back();
+      continue;
+      }
+    const GlobTreeItem& item = node->Items[stack.back().second++];
+    switch ( item.Type )
+      {
+      case GlobTreeItem::File:
+        this->AddFile(this->Internals->Files, item.Text);
+        break;
+      case GlobTreeItem::Symlink:
+        ++this->FollowedSymlinkCount;
+        break;
+      case GlobTreeItem::Subdirectory:
+        stack.push_back(Position(item.Child, 0));
+        break;
+      case GlobTreeItem::Cycle:
+        if(messages)
+          {
+          messages->push_back(Message(Glob::cyclicRecursion, item.Text));
+          }
+        break;
+      case GlobTreeItem::Error:
+        if(messages)
+          {
+          messages->push_back(Message(Glob::error, item.Text));
+          }
+        return false;
+      }
+    }
+  return true;
+}
+#endif
+
 //----------------------------------------------------------------------------
 void Glob::ProcessDirectory(kwsys_stl::string::size_type start,
   const kwsys_stl::string& dir, GlobMessages* messages)
@@ -389,11 +821,13 @@ void Glob::ProcessDirectory(kwsys_stl::string::size_type start,
     // << this->Internals->TextExpressions[start].c_str() << kwsys_ios::endl;
     //kwsys_ios::cout << "Real name: " << realname << kwsys_ios::endl;
 
-    if( (!last && !kwsys::SystemTools::FileIsDirectory(realname))
-      || (!this->ListDirs && last &&
-          kwsys::SystemTools::FileIsDirectory(realname)) )
+    if ( !last || !this->ListDirs )
       {
-      continue;
+      bool isDir = GlobIsDirectory(d.GetFileType(cc), realname, 0);
+      if ( isDir == last )
+        {
+        continue;
+        }
       }
 
     if ( this->Internals->Expressions[start].find(fname) )
@@ -24,7 +24,10 @@
 
 Implementation for UNIX
 
-On UNIX, a child process is forked to exec the program.  Three output
+On UNIX, a child process is forked to exec the program.  Where the C
+library implements posix_spawn with vfork-like semantics (glibc 2.24
+and later) the child is spawned instead, so the cost of starting it
+does not grow with the size of the parent's address space.  Three output
 pipes are read by the parent process using a select call to block
 until data are ready.  Two of the pipes are stdout and stderr for the
 child.  The third is a special pipe populated by a signal handler to
@@ -60,6 +63,7 @@ do.
 #include <sys/time.h>  /* struct timeval */
 #include <sys/types.h> /* pid_t, fd_set */
 #include <sys/wait.h>  /* waitpid */
+#include <sys/resource.h> /* struct rusage */
 #include <sys/stat.h>  /* open mode */
 #include <unistd.h>    /* pipe, close, fork, execvp, select, _exit */
 #include <fcntl.h>     /* fcntl */
@@ -113,6 +117,23 @@ static inline void kwsysProcess_usleep(unsigned int msec)
 # define KWSYSPE_USE_SELECT 1
 #endif
 
+/* Use wait4 to reap children where it is available so that their
+   resource usage can be reported.  */
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+# define KWSYSPE_USE_WAIT4 1
+#endif
+
+/* Create children with posix_spawn where the C library creates them
+   sharing the memory of the parent, so that no page tables are copied
+   however large the parent is, and reports the errors of exec.  */
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 24))
+# define KWSYSPE_USE_SPAWN 1
+# include <spawn.h>
+extern char** environ;
+#endif
+
 /* Some platforms do not have siginfo on their signal handlers.  */
 #if defined(SA_SIGINFO) && !defined(__BEOS__)
 # define KWSYSPE_USE_SIGINFO 1
@@ -179,7 +200,13 @@ static void kwsysProcessChildErrorExit(int errorPipe);
 static void kwsysProcessRestoreDefaultSignalHandlers(void);
 static pid_t kwsysProcessFork(kwsysProcess* cp,
                               kwsysProcessCreateInformation* si);
+#if KWSYSPE_USE_SPAWN
+static int kwsysProcessSpawn(kwsysProcess* cp, int prIndex,
+                             kwsysProcessCreateInformation* si);
+#endif
 static void kwsysProcessKill(pid_t process_id);
+static pid_t kwsysProcessWaitPid(kwsysProcess* cp, pid_t pid, int* status,
+                                 int options);
 #if defined(__VMS)
 static int kwsysProcessSetVMSFeature(const char* name, int value);
 #endif
@@ -289,6 +316,10 @@ struct kwsysProcess_s
   /* The exit codes of each child process in the pipeline.  */
   int* CommandExitCodes;
 
+  /* Resources used by the children reaped so far.  */
+  int HaveResourceUsage;
+  kwsysProcess_ResourceUsage ResourceUsage;
+
   /* Name of files to which stdin and stdout pipes are attached.  */
   char* PipeFileSTDIN;
   char* PipeFileSTDOUT;
@@ -705,6 +736,23 @@ int kwsysProcess_GetExitValue(kwsysProcess* cp)
   return cp? cp->ExitValue : -1;
 }
 
+/*--------------------------------------------------------------------------*/
+int kwsysProcess_GetResourceUsage(kwsysProcess* cp,
+                                  kwsysProcess_ResourceUsage* usage)
+{
+  if(!usage)
+    {
+    return 0;
+    }
+  if(!cp || !cp->HaveResourceUsage)
+    {
+    memset(usage, 0, sizeof(*usage));
+    return 0;
+    }
+  *usage = cp->ResourceUsage;
+  return 1;
+}
+
 /*--------------------------------------------------------------------------*/
 const char* kwsysProcess_GetErrorString(kwsysProcess* cp)
 {
@@ -1419,6 +1467,156 @@ static int kwsysProcessWaitForPipe(kwsysProcess* cp, char** data, int* length,
 #endif
 }
 
+/*--------------------------------------------------------------------------*/
+int kwsysProcess_WaitForAny(kwsysProcess* const* cps, int count,
+                            double* userTimeout)
+{
+  kwsysProcessTime userStartTime = {0, 0};
+  kwsysProcessTime timeoutTime = {-1, -1};
+  kwsysProcessTimeNative timeoutLength;
+  int timeoutIndex = -1;
+  int ready = -1;
+  int i;
+#if KWSYSPE_USE_SELECT
+  fd_set set;
+  int max = -1;
+  int numReady;
+  FD_ZERO(&set);
+#endif
+
+  if(count <= 0)
+    {
+    return -1;
+    }
+
+  /* The call times out at the user timeout, or at the earliest timeout
+     of the processes.  */
+  if(userTimeout)
+    {
+    userStartTime = kwsysProcessTimeGetCurrent();
+    timeoutTime = kwsysProcessTimeAdd(
+      userStartTime, kwsysProcessTimeFromDouble(*userTimeout));
+    }
+  for(i=0; i < count && ready < 0; ++i)
+    {
+    kwsysProcess* cp = cps[i];
+    kwsysProcessTime processTimeoutTime;
+    int j;
+
+    /* kwsysProcess_WaitForData returns at once for a process that
+       no longer has pipes to read.  */
+    if(!cp || cp->State != kwsysProcess_State_Executing || cp->Killed ||
+       cp->TimeoutExpired || cp->PipesLeft <= 0)
+      {
+      ready = i;
+      break;
+      }
+    kwsysProcessGetTimeoutTime(cp, 0, &processTimeoutTime);
+    if(processTimeoutTime.tv_sec >= 0 &&
+       (timeoutTime.tv_sec < 0 ||
+        kwsysProcessTimeLess(processTimeoutTime, timeoutTime)))
+      {
+      timeoutTime = processTimeoutTime;
+      timeoutIndex = i;
+      }
+#if KWSYSPE_USE_SELECT
+    for(j=0; j < KWSYSPE_PIPE_COUNT; ++j)
+      {
+      int fd = cp->PipeReadEnds[j];
+      if(fd >= 0)
+        {
+        /* Pipes reported ready by the last select of the process are
+           read before it selects again.  */
+        if(FD_ISSET(fd, &cp->PipeSet))
+          {
+          ready = i;
+          }
+        FD_SET(fd, &set);
+        if(fd > max)
+          {
+          max = fd;
+          }
+        }
+      }
+#else
+    (void)j;
+#endif
+    }
+
+  if(ready < 0)
+    {
+    if(kwsysProcessGetTimeoutLeft(&timeoutTime, userTimeout,
+                                  &timeoutLength, 0))
+      {
+      /* A timeout has already expired.  */
+      ready = timeoutIndex;
+      }
+    else
+      {
+#if KWSYSPE_USE_SELECT
+      /* Block until any of the pipes, including the ones that report
+         the termination of children, is ready.  */
+      while(((numReady = select(max+1, &set, 0, 0,
+                                timeoutTime.tv_sec < 0? 0 : &timeoutLength))
+             < 0) && (errno == EINTR));
+      if(numReady == 0)
+        {
+        /* The timeout expired.  */
+        ready = timeoutIndex;
+        }
+      else if(numReady < 0)
+        {
+        /* Let kwsysProcess_WaitForData report the error.  */
+        ready = 0;
+        }
+      for(i=0; i < count && numReady > 0 && ready < 0; ++i)
+        {
+        int j;
+        for(j=0; j < KWSYSPE_PIPE_COUNT; ++j)
+          {
+          if(cps[i]->PipeReadEnds[j] >= 0 &&
+             FD_ISSET(cps[i]->PipeReadEnds[j], &set))
+            {
+            ready = i;
+            }
+          }
+        }
+#else
+      /* Without select the processes can only be polled.  Sleep a
+         little and let the caller poll them.  */
+      unsigned int usec = 10000;
+      if(timeoutTime.tv_sec >= 0 && timeoutLength.tv_sec == 0 &&
+         (unsigned int)timeoutLength.tv_usec < usec)
+        {
+        usec = (unsigned int)timeoutLength.tv_usec;
+        }
+      kwsysProcess_usleep(usec);
+      ready = 0;
+      if(kwsysProcessGetTimeoutLeft(&timeoutTime, userTimeout,
+                                    &timeoutLength, 1))
+        {
+        ready = timeoutIndex;
+        }
+#endif
+      }
+    }
+
+  /* Update the user timeout.  */
+  if(userTimeout)
+    {
+    kwsysProcessTime userEndTime = kwsysProcessTimeGetCurrent();
+    kwsysProcessTime difference = kwsysProcessTimeSubtract(userEndTime,
+                                                           userStartTime);
+    double d = kwsysProcessTimeToDouble(difference);
+    *userTimeout -= d;
+    if(*userTimeout < 0)
+      {
+      *userTimeout = 0;
+      }
+    }
+  return ready;
+}
+
 /*--------------------------------------------------------------------------*/
 int kwsysProcess_WaitForExit(kwsysProcess* cp, double* userTimeout)
 {
@@ -1574,7 +1772,8 @@ void kwsysProcess_Kill(kwsysProcess* cp)
 
       /* Reap the child.  Keep trying until the call is not
          interrupted.  */
-      while((waitpid(cp->ForkPIDs[i], &status, 0) < 0) && (errno == EINTR));
+      while((kwsysProcessWaitPid(cp, cp->ForkPIDs[i], &status, 0) < 0) &&
+            (errno == EINTR));
       }
     }
 
@@ -1638,6 +1837,8 @@ static int kwsysProcessInitialize(kwsysProcess* cp)
   cp->ExitValue = 1;
   cp->ErrorMessage[0] = 0;
   strcpy(cp->ExitExceptionString, "No exception");
+  cp->HaveResourceUsage = 0;
+  memset(&cp->ResourceUsage, 0, sizeof(cp->ResourceUsage));
 
   oldForkPIDs = cp->ForkPIDs;
   cp->ForkPIDs = (volatile pid_t*)malloc(
@@ -1836,6 +2037,17 @@ static int kwsysProcessCreate(kwsysProcess* cp, int prIndex,
   char tmp;
   ssize_t readRes;
 
+#if KWSYSPE_USE_SPAWN
+  /* Spawn the child unless the options need a fork.  */
+  {
+  int spawned = kwsysProcessSpawn(cp, prIndex, si);
+  if(spawned >= 0)
+    {
+    return spawned;
+    }
+  }
+#endif
+
   /* Create the error reporting pipe.  */
   if(pipe(si->ErrorPipe) < 0)
     {
@@ -2044,8 +2256,9 @@ static void kwsysProcessDestroy(kwsysProcess* cp)
     if(cp->ForkPIDs[i])
       {
       int result;
-      while(((result = waitpid(cp->ForkPIDs[i],
-                               &cp->CommandExitCodes[i], WNOHANG)) < 0) &&
+      while(((result = kwsysProcessWaitPid(cp, cp->ForkPIDs[i],
+                                           &cp->CommandExitCodes[i],
+                                           WNOHANG)) < 0) &&
             (errno == EINTR));
       if(result > 0)
         {
@@ -2077,6 +2290,43 @@ static void kwsysProcessDestroy(kwsysProcess* cp)
   sigprocmask(SIG_SETMASK, &old_mask, 0);
 }
 
+/*--------------------------------------------------------------------------*/
+/* Reap a child like waitpid and accumulate its resource usage.  */
+static pid_t kwsysProcessWaitPid(kwsysProcess* cp, pid_t pid, int* status,
+                                 int options)
+{
+#if KWSYSPE_USE_WAIT4
+  struct rusage ru;
+  pid_t result = wait4(pid, status, options, &ru);
+  if(result > 0)
+    {
+    kwsysProcess_ResourceUsage* usage = &cp->ResourceUsage;
+    long maxrss = (long)ru.ru_maxrss;
+# if defined(__APPLE__)
+    /* OS X reports bytes instead of kilobytes.  */
+    maxrss /= 1024;
+# endif
+    usage->UserTime += (double)ru.ru_utime.tv_sec +
+      (double)ru.ru_utime.tv_usec * 0.000001;
+    usage->SystemTime += (double)ru.ru_stime.tv_sec +
+      (double)ru.ru_stime.tv_usec * 0.000001;
+    if(maxrss > usage->MaxResidentSetSize)
+      {
+      usage->MaxResidentSetSize = maxrss;
+      }
+    usage->VoluntaryContextSwitches += (long)ru.ru_nvcsw;
+    usage->InvoluntaryContextSwitches += (long)ru.ru_nivcsw;
+    usage->BlockInputOperations += (long)ru.ru_inblock;
+    usage->BlockOutputOperations += (long)ru.ru_oublock;
+    cp->HaveResourceUsage = 1;
+    }
+  return result;
+#else
+  (void)cp;
+  return waitpid(pid, status, options);
+#endif
+}
+
 /*--------------------------------------------------------------------------*/
 static int kwsysProcessSetupOutputPipeFile(int* p, const char* name)
 {
@@ -2582,6 +2832,138 @@ static pid_t kwsysProcessFork(kwsysProcess* cp,
 }
 #endif
 
+/*--------------------------------------------------------------------------*/
+#if KWSYSPE_USE_SPAWN
+static int kwsysProcessCloseOnExec(int fd)
+{
+  int flags = fcntl(fd, F_GETFD);
+  return flags >= 0 && (flags & FD_CLOEXEC);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Create a child with posix_spawn, set up like the forked child of
+   kwsysProcessCreate.  Returns -1 if the options or the program need a
+   fork, 0 on error and 1 on success.  */
+static int kwsysProcessSpawn(kwsysProcess* cp, int prIndex,
+                             kwsysProcessCreateInformation* si)
+{
+  posix_spawn_file_actions_t actions;
+  posix_spawnattr_t attr;
+  sigset_t mask, old_mask, all;
+  short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+  pid_t pid;
+  int result = 0;
+
+  /* A detached child is created by an intermediate process.  */
+  if(cp->OptionDetach)
+    {
+    return -1;
+    }
+  if(cp->CreateProcessGroup)
+    {
+#if defined(POSIX_SPAWN_SETSID)
+    flags |= POSIX_SPAWN_SETSID;
+#else
+    return -1;
+#endif
+    }
+
+  /* The forked child clears the close-on-exec flag of the standard
+     descriptors it shares with us, which the spawned one cannot do.  */
+  if((si->StdIn == 0 && kwsysProcessCloseOnExec(0)) ||
+     (si->StdOut == 1 && kwsysProcessCloseOnExec(1)) ||
+     (si->StdErr == 2 && kwsysProcessCloseOnExec(2)))
+    {
+    return -1;
+    }
+
+  if(posix_spawn_file_actions_init(&actions) != 0)
+    {
+    return -1;
+    }
+  if(posix_spawnattr_init(&attr) != 0)
+    {
+    posix_spawn_file_actions_destroy(&actions);
+    return -1;
+    }
+
+  /* Setup the stdin, stdout, and stderr pipes.  */
+  if(si->StdIn > 0)
+    {
+    result = posix_spawn_file_actions_adddup2(&actions, si->StdIn, 0);
+    }
+  else if(si->StdIn < 0 && fcntl(0, F_GETFD) >= 0)
+    {
+    result = posix_spawn_file_actions_addclose(&actions, 0);
+    }
+  if(result == 0 && si->StdOut != 1)
+    {
+    result = posix_spawn_file_actions_adddup2(&actions, si->StdOut, 1);
+    }
+  if(result == 0 && si->StdErr != 2)
+    {
+    result = posix_spawn_file_actions_adddup2(&actions, si->StdErr, 2);
+    }
+
+  /* Restore all default signal handlers in the child.  */
+  sigfillset(&all);
+  if(result == 0)
+    {
+    result = posix_spawnattr_setflags(&attr, flags);
+    }
+  if(result == 0)
+    {
+    result = posix_spawnattr_setsigdefault(&attr, &all);
+    }
+
+  /* Block SIGINT / SIGTERM while we start, so that our signal handler
+     knows the child before it kill()s the PIDs from ForkPIDs.  The child
+     gets the mask from before.  */
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  if(result == 0 && sigprocmask(SIG_BLOCK, &mask, &old_mask) < 0)
+    {
+    result = errno;
+    }
+  else if(result == 0)
+    {
+    result = posix_spawnattr_setsigmask(&attr, &old_mask);
+    if(result == 0)
+      {
+      /* The call returns once the program has been executed, or with
+         the error that prevented it.  */
+      result = posix_spawnp(&pid, cp->Commands[prIndex][0], &actions,
+                            &attr, cp->Commands[prIndex], environ);
+      if(result == 0)
+        {
+        cp->ForkPIDs[prIndex] = pid;
+        }
+      }
+    sigprocmask(SIG_SETMASK, &old_mask, 0);
+    }
+
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+
+  /* Unlike execvp, posix_spawnp does not run a file without a "#!" line
+     through /bin/sh.  Let the forked child do that.  */
+  if(result == ENOEXEC)
+    {
+    return -1;
+    }
+  if(result != 0)
+    {
+    strncpy(cp->ErrorMessage, strerror(result), KWSYSPE_PIPE_BUFFER_SIZE);
+    return 0;
+    }
+
+  /* A child has been created.  */
+  ++cp->CommandsLeft;
+  return 1;
+}
+#endif
+
 /*--------------------------------------------------------------------------*/
 /* We try to obtain process information by invoking the ps command.
    Here we define the command to call on each platform and the
@@ -901,6 +901,19 @@ int kwsysProcess_GetExitValue(kwsysProcess* cp)
   return cp? cp->ExitValue : -1;
 }
 
+/*--------------------------------------------------------------------------*/
+int kwsysProcess_GetResourceUsage(kwsysProcess* cp,
+                                  kwsysProcess_ResourceUsage* usage)
+{
+  /* Resource usage is not yet reported on Windows.  */
+  (void)cp;
+  if(usage)
+    {
+    memset(usage, 0, sizeof(*usage));
+    }
+  return 0;
+}
+
 /*--------------------------------------------------------------------------*/
 int kwsysProcess_GetExitCode(kwsysProcess* cp)
 {
@@ -1409,6 +1422,142 @@ int kwsysProcess_WaitForData(kwsysProcess* cp, char** data, int* length,
     }
 }
 
+/*--------------------------------------------------------------------------*/
+int kwsysProcess_WaitForAny(kwsysProcess* const* cps, int count,
+                            double* userTimeout)
+{
+  HANDLE events[MAXIMUM_WAIT_OBJECTS];
+  int owners[MAXIMUM_WAIT_OBJECTS];
+  DWORD numEvents = 0;
+  int partial = 0;
+  kwsysProcessTime userStartTime;
+  kwsysProcessTime timeoutTime;
+  kwsysProcessTime timeoutLength;
+  DWORD timeout;
+  int timeoutIndex = -1;
+  int ready = -1;
+  int i;
+  DWORD w;
+
+  if(count <= 0)
+    {
+    return -1;
+    }
+
+  /* The call times out at the user timeout, or at the earliest timeout
+     of the processes.  */
+  userStartTime = kwsysProcessTimeGetCurrent();
+  timeoutTime.QuadPart = -1;
+  if(userTimeout)
+    {
+    timeoutTime = kwsysProcessTimeAdd(
+      userStartTime, kwsysProcessTimeFromDouble(*userTimeout));
+    }
+  for(i=0; i < count && ready < 0; ++i)
+    {
+    kwsysProcess* cp = cps[i];
+    kwsysProcessTime processTimeoutTime;
+    int j;
+
+    /* kwsysProcess_WaitForData returns at once for a process that
+       no longer has pipes to read.  */
+    if(!cp || cp->State != kwsysProcess_State_Executing || cp->Killed ||
+       cp->TimeoutExpired || cp->PipesLeft <= 0)
+      {
+      ready = i;
+      break;
+      }
+
+    /* Let the thread that reported the last data read more.  */
+    if(cp->CurrentIndex < KWSYSPE_PIPE_COUNT)
+      {
+      ReleaseSemaphore(cp->Pipe[cp->CurrentIndex].Reader.Go, 1, 0);
+      cp->CurrentIndex = KWSYSPE_PIPE_COUNT;
+      }
+
+    kwsysProcessGetTimeoutTime(cp, 0, &processTimeoutTime);
+    if(processTimeoutTime.QuadPart >= 0 &&
+       (timeoutTime.QuadPart < 0 ||
+        kwsysProcessTimeLess(processTimeoutTime, timeoutTime)))
+      {
+      timeoutTime = processTimeoutTime;
+      timeoutIndex = i;
+      }
+
+    /* Wait for the pipe threads and the children of each process as
+       kwsysProcess_WaitForData does, as many as one call can.  */
+    for(j=0; j < cp->ProcessEventsLength; ++j)
+      {
+      if(numEvents == MAXIMUM_WAIT_OBJECTS)
+        {
+        partial = 1;
+        break;
+        }
+      events[numEvents] = cp->ProcessEvents[j];
+      owners[numEvents] = i;
+      ++numEvents;
+      }
+    }
+
+  if(ready < 0)
+    {
+    if(kwsysProcessGetTimeoutLeft(&timeoutTime, userTimeout,
+                                  &timeoutLength))
+      {
+      /* A timeout has already expired.  */
+      ready = timeoutIndex;
+      }
+    else
+      {
+      timeout = timeoutTime.QuadPart < 0? INFINITE :
+        kwsysProcessTimeToDWORD(timeoutLength);
+      if(partial && timeout > 10)
+        {
+        /* Some processes could not be waited for.  Return soon so that
+           the caller polls them.  */
+        timeout = 10;
+        }
+      w = WaitForMultipleObjects(numEvents, events, 0, timeout);
+      if(w == WAIT_TIMEOUT)
+        {
+        ready = partial? 0 : timeoutIndex;
+        }
+      else if(w >= WAIT_OBJECT_0 && w < WAIT_OBJECT_0 + numEvents)
+        {
+        kwsysProcess* cp;
+        ready = owners[w - WAIT_OBJECT_0];
+        cp = cps[ready];
+        if(events[w - WAIT_OBJECT_0] == cp->Full)
+          {
+          /* Waiting took the signal of the pipe thread.  Give it back
+             for kwsysProcess_WaitForData to take.  */
+          ReleaseSemaphore(cp->Full, 1, 0);
+          }
+        }
+      else
+        {
+        /* Let kwsysProcess_WaitForData report the error.  */
+        ready = 0;
+        }
+      }
+    }
+
+  /* Update the user timeout.  */
+  if(userTimeout)
+    {
+    kwsysProcessTime userEndTime = kwsysProcessTimeGetCurrent();
+    kwsysProcessTime difference = kwsysProcessTimeSubtract(userEndTime,
+                                                           userStartTime);
+    double d = kwsysProcessTimeToDouble(difference);
+    *userTimeout -= d;
+    if(*userTimeout < 0)
+      {
+      *userTimeout = 0;
+      }
+    }
+  return ready;
+}
+
 /*--------------------------------------------------------------------------*/
 int kwsysProcess_WaitForExit(kwsysProcess* cp, double* userTimeout)
 {
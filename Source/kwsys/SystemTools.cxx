@@ -84,6 +84,13 @@
 #include <signal.h>    /* sigprocmask */
 #endif
 
+#if defined(__linux__)
+# include <sys/sendfile.h>
+# include <sys/syscall.h>
+/* Share the blocks of one file with another (linux/fs.h). */
+# define KWSYS_ST_FICLONE _IOW(0x94, 9, int)
+#endif
+
 // Windows API.
 #if defined(_WIN32)
 # include <windows.h>
@@ -2203,7 +2210,8 @@ bool SystemTools::CopyFileIfDifferent(const kwsys_stl::string& source,
   return true;
 }
 
-#define KWSYS_ST_BUFFER 4096
+// Large blocks, read directly into the buffers by the streams.
+#define KWSYS_ST_BUFFER (256 * 1024)
 
 bool SystemTools::FilesDiffer(const kwsys_stl::string& source,
                               const kwsys_stl::string& destination)
@@ -2260,7 +2268,9 @@ bool SystemTools::FilesDiffer(const kwsys_stl::string& source,
     return true;
     }
 
-  if(statSource.st_size == 0)
+  if(statSource.st_size == 0 ||
+     (statSource.st_dev == statDestination.st_dev &&
+      statSource.st_ino == statDestination.st_ino))
     {
     return false;
     }
@@ -2284,8 +2294,9 @@ bool SystemTools::FilesDiffer(const kwsys_stl::string& source,
     }
 
   // Compare the files a block at a time.
-  char source_buf[KWSYS_ST_BUFFER];
-  char dest_buf[KWSYS_ST_BUFFER];
+  kwsys_stl::vector<char> buffers(2 * KWSYS_ST_BUFFER);
+  char* source_buf = &buffers[0];
+  char* dest_buf = source_buf + KWSYS_ST_BUFFER;
   while(nleft > 0)
     {
     // Read a block from each file.
@@ -2317,6 +2328,125 @@ bool SystemTools::FilesDiffer(const kwsys_stl::string& source,
 }
 
 
+#if !defined(_WIN32)
+/* Keep the descriptors of a copy out of processes started meanwhile. */
+# if defined(O_CLOEXEC)
+#  define KWSYS_ST_O_CLOEXEC O_CLOEXEC
+# else
+#  define KWSYS_ST_O_CLOEXEC 0
+# endif
+
+//----------------------------------------------------------------------------
+// Write all of a buffer to a file.
+static bool SystemToolsWriteAll(int fd, const char* data, size_t size)
+{
+  while(size > 0)
+    {
+    ssize_t n = write(fd, data, size);
+    if(n < 0)
+      {
+      if(errno == EINTR)
+        {
+        continue;
+        }
+      return false;
+      }
+    data += n;
+    size -= static_cast<size_t>(n);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Copy the content of a file opened for reading to an empty one opened
+// for writing.  The fastest way the system supports is tried first: a
+// reflink sharing the blocks on file systems with copy-on-write, then a
+// copy within the kernel.  Each of them continues where the previous one
+// stopped, ending with plain reads and writes.  A kernel copy that copies
+// nothing of a file that is not empty is taken as unsupported, as some
+// file systems report no error for it.
+static bool SystemToolsCopyFileContent(int fin, int fout)
+{
+#if defined(__linux__)
+  struct stat st;
+  // The kernel copies stop at the size of the file, so files like those
+  // of /proc that have none are read instead.
+  if(fstat(fin, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+    if(ioctl(fout, KWSYS_ST_FICLONE, fin) == 0)
+      {
+      return true;
+      }
+    const size_t chunk = 1 << 30;
+    bool done = false;
+    bool copied = false;
+# if defined(__NR_copy_file_range)
+    while(!done)
+      {
+      long n = syscall(__NR_copy_file_range, fin, static_cast<void*>(0),
+                       fout, static_cast<void*>(0), chunk, 0u);
+      if(n > 0)
+        {
+        copied = true;
+        }
+      else if(n == 0 && copied)
+        {
+        done = true;
+        }
+      else if(n == 0 || errno != EINTR)
+        {
+        // Not supported here, or a real error the reads will report.
+        break;
+        }
+      }
+# endif
+    while(!done)
+      {
+      ssize_t n = sendfile(fout, fin, 0, chunk);
+      if(n > 0)
+        {
+        copied = true;
+        }
+      else if(n == 0 && copied)
+        {
+        done = true;
+        }
+      else if(n == 0 || errno != EINTR)
+        {
+        break;
+        }
+      }
+    if(done)
+      {
+      return true;
+      }
+    }
+#endif
+
+  kwsys_stl::vector<char> buffer(KWSYS_ST_BUFFER);
+  for(;;)
+    {
+    ssize_t n = read(fin, &buffer[0], buffer.size());
+    if(n == 0)
+      {
+      return true;
+      }
+    if(n < 0)
+      {
+      if(errno == EINTR)
+        {
+        continue;
+        }
+      return false;
+      }
+    if(!SystemToolsWriteAll(fout, &buffer[0], static_cast<size_t>(n)))
+      {
+      return false;
+      }
+    }
+}
+#endif
+
 //----------------------------------------------------------------------------
 /**
  * Copy a file named by "source" to the file named by "destination".
@@ -2331,9 +2461,6 @@ bool SystemTools::CopyFileAlways(const kwsys_stl::string& source, const kwsys_st
   mode_t perm = 0;
   bool perms = SystemTools::GetPermissions(source, perm);
 
-  const int bufferSize = 4096;
-  char buffer[bufferSize];
-
   // If destination is a directory, try to create a file with the same
   // name as the source in that directory.
 
@@ -2362,14 +2489,17 @@ bool SystemTools::CopyFileAlways(const kwsys_stl::string& source, const kwsys_st
   kwsys::ifstream fin(Encoding::ToNarrow(
     SystemTools::ConvertToWindowsExtendedPath(source)).c_str(),
                 kwsys_ios::ios::in | kwsys_ios_binary);
-#else
-  kwsys::ifstream fin(source.c_str(),
-                kwsys_ios::ios::in | kwsys_ios_binary);
-#endif
   if(!fin)
     {
     return false;
     }
+#else
+  int fin = open(source.c_str(), O_RDONLY | KWSYS_ST_O_CLOEXEC);
+  if(fin < 0)
+    {
+    return false;
+    }
+#endif
 
   // try and remove the destination file so that read only destination files
   // can be written to.
@@ -2381,15 +2511,13 @@ bool SystemTools::CopyFileAlways(const kwsys_stl::string& source, const kwsys_st
   kwsys::ofstream fout(Encoding::ToNarrow(
     SystemTools::ConvertToWindowsExtendedPath(real_destination)).c_str(),
                      kwsys_ios::ios::out | kwsys_ios::ios::trunc | kwsys_ios_binary);
-#else
-  kwsys::ofstream fout(real_destination.c_str(),
-                     kwsys_ios::ios::out | kwsys_ios::ios::trunc | kwsys_ios_binary);
-#endif
   if(!fout)
     {
     return false;
     }
 
+  kwsys_stl::vector<char> buffer(KWSYS_ST_BUFFER);
+
   // This copy loop is very sensitive on certain platforms with
   // slightly broken stream libraries (like HPUX).  Normally, it is
   // incorrect to not check the error condition on the fin.read()
@@ -2397,10 +2525,10 @@ bool SystemTools::CopyFileAlways(const kwsys_stl::string& source, const kwsys_st
   // error occurred.  Therefore, the loop should be safe everywhere.
   while(fin)
     {
-    fin.read(buffer, bufferSize);
+    fin.read(&buffer[0], static_cast<kwsys_ios::streamsize>(buffer.size()));
     if(fin.gcount())
       {
-      fout.write(buffer, fin.gcount());
+      fout.write(&buffer[0], fin.gcount());
       }
     else
       {
@@ -2420,6 +2548,26 @@ bool SystemTools::CopyFileAlways(const kwsys_stl::string& source, const kwsys_st
     {
     return false;
     }
+#else
+  int fout = open(real_destination.c_str(),
+                  O_WRONLY | O_CREAT | O_TRUNC | KWSYS_ST_O_CLOEXEC, 0666);
+  if(fout < 0)
+    {
+    close(fin);
+    return false;
+    }
+  bool copied = SystemToolsCopyFileContent(fin, fout);
+  // Closing reports the errors of writes not yet finished.
+  if(close(fout) != 0)
+    {
+    copied = false;
+    }
+  close(fin);
+  if(!copied)
+    {
+    return false;
+    }
+#endif
   if ( perms )
     {
     if ( !SystemTools::SetPermissions(real_destination, perm) )
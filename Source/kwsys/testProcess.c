@@ -30,6 +30,7 @@
 #else
 # include <unistd.h>
 # include <signal.h>
+# include <sys/stat.h>
 #endif
 
 #if defined(__BORLANDC__)
@@ -357,6 +358,37 @@ static int test10_grandchild(int argc, const char* argv[])
   return 0;
 }
 
+#if !defined(_WIN32)
+static int test11(void)
+{
+  /* Run a script without a "#!" line.  Like execvp we should run it with
+     /bin/sh instead of failing with an exec format error.  */
+  const char* script = "testProcess-11.sh";
+  const char* cmd[2];
+  int r;
+  FILE* f = fopen(script, "w");
+  if(!f)
+    {
+    fprintf(stderr, "Cannot write %s.\n", script);
+    return 1;
+    }
+  fprintf(f, "echo \"Output on stdout from script without #! line.\"\n"
+             "exit 42\n");
+  fclose(f);
+  if(chmod(script, 0755) != 0)
+    {
+    fprintf(stderr, "Cannot make %s executable.\n", script);
+    return 1;
+    }
+  cmd[0] = "./testProcess-11.sh";
+  cmd[1] = 0;
+  r = runChild(cmd, kwsysProcess_State_Exited, kwsysProcess_Exception_None,
+               42, 0, 1, 0, 10, 0, 1, 0, 0, 0);
+  remove(script);
+  return r;
+}
+#endif
+
 static int runChild2(kwsysProcess* kp,
               const char* cmd[], int state, int exception, int value,
               int share, int output, int delay, double timeout,
@@ -707,6 +739,12 @@ int main(int argc, const char* argv[])
 #endif
     return r;
     }
+#if !defined(_WIN32)
+  else if(n == 11)
+    {
+    return test11();
+    }
+#endif
   else if(argc > 2 && strcmp(argv[1], "0") == 0)
     {
     /* This is the special debugging test to run a given command
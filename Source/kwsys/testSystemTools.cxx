@@ -16,12 +16,14 @@
 #endif
 
 #include KWSYS_HEADER(SystemTools.hxx)
+#include KWSYS_HEADER(FStream.hxx)
 #include KWSYS_HEADER(ios/iostream)
 
 // Work-around CMake dependency scanning limitation.  This must
 // duplicate the above list of headers.
 #if 0
 # include "SystemTools.hxx.in"
+# include "FStream.hxx.in"
 # include "kwsys_ios_iostream.h.in"
 #endif
 
@@ -29,6 +31,7 @@
 // left on disk.
 #include <testSystemTools.h>
 
+#include <stdio.h> /* fopen */
 #include <string.h> /* strcmp */
 
 //----------------------------------------------------------------------------
@@ -260,6 +263,77 @@ static bool CheckFileOperations()
   return res;
 }
 
+//----------------------------------------------------------------------------
+static bool CheckFileCopy()
+{
+  bool res = true;
+  const kwsys_stl::string testCopyDir(TEST_SYSTEMTOOLS_BINARY_DIR
+    "/testSystemToolsCopy");
+  const kwsys_stl::string testSource(testCopyDir + "/source.bin");
+  const kwsys_stl::string testCopy(testCopyDir + "/copy/source.bin");
+
+  // Larger than the blocks of the copy, and not a multiple of them.
+  kwsys::SystemTools::RemoveADirectory(testCopyDir);
+  kwsys::SystemTools::MakeDirectory(testCopyDir + "/copy");
+  {
+  kwsys::ofstream fout(testSource.c_str(),
+                       kwsys_ios::ios::out | kwsys_ios_binary);
+  for(int i = 0; i < 3 * 1024 * 1024 + 7; ++i)
+    {
+    fout.put(static_cast<char>(i * 7 + i / 4096));
+    }
+  }
+
+  if (!kwsys::SystemTools::CopyFileAlways(testSource, testCopyDir + "/copy")
+      || kwsys::SystemTools::FilesDiffer(testSource, testCopy))
+    {
+    kwsys_ios::cerr
+      << "Problem with CopyFileAlways to directory: "
+      << testCopyDir << "/copy" << kwsys_ios::endl;
+    res = false;
+    }
+
+  // Change the last byte only.
+  if (FILE* f = fopen(testCopy.c_str(), "r+b"))
+    {
+    fseek(f, -1, SEEK_END);
+    fputc('x', f);
+    fclose(f);
+    }
+  if (!kwsys::SystemTools::FilesDiffer(testSource, testCopy))
+    {
+    kwsys_ios::cerr
+      << "Problem with FilesDiffer for a change at the end of: "
+      << testCopy << kwsys_ios::endl;
+    res = false;
+    }
+  if (!kwsys::SystemTools::CopyFileIfDifferent(testSource, testCopy) ||
+      kwsys::SystemTools::FilesDiffer(testSource, testCopy))
+    {
+    kwsys_ios::cerr
+      << "Problem with CopyFileIfDifferent to: "
+      << testCopy << kwsys_ios::endl;
+    res = false;
+    }
+
+#if defined(__linux__)
+  // Files that do not tell their size are copied too.
+  const kwsys_stl::string testProc(testCopyDir + "/cpuinfo");
+  if (kwsys::SystemTools::FileExists("/proc/cpuinfo") &&
+      (!kwsys::SystemTools::CopyFileAlways("/proc/cpuinfo", testProc) ||
+       kwsys::SystemTools::FileLength(testProc) == 0))
+    {
+    kwsys_ios::cerr
+      << "Problem with CopyFileAlways from /proc/cpuinfo to: "
+      << testProc << kwsys_ios::endl;
+    res = false;
+    }
+#endif
+
+  kwsys::SystemTools::RemoveADirectory(testCopyDir);
+  return res;
+}
+
 //----------------------------------------------------------------------------
 static bool CheckStringOperations()
 {
@@ -678,6 +752,8 @@ int testSystemTools(int, char*[])
 
   res &= CheckFileOperations();
 
+  res &= CheckFileCopy();
+
   res &= CheckStringOperations();
 
   res &= CheckEnvironmentOperations();
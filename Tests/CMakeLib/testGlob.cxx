@@ -0,0 +1,111 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2015 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmSystemTools.h"
+
+#include <cmsys/Glob.hxx>
+
+#define cmPassed(m) std::cout << "Passed: " << m << "\n"
+#define cmFailed(m) std::cout << "FAILED: " << m << "\n"; failed=1
+
+// Create a tree with a few levels of directories and files.
+static void testGlobCreateTree(std::string const& dir, int depth)
+{
+  cmSystemTools::MakeDirectory(dir);
+  for(int i = 0; i < 4; ++i)
+    {
+    std::ostringstream name;
+    name << dir << "/f" << i << (i % 2? ".txt" : ".cxx");
+    cmSystemTools::Touch(name.str(), true);
+    }
+  if(depth > 0)
+    {
+    for(int i = 0; i < 5; ++i)
+      {
+      std::ostringstream name;
+      name << dir << "/d" << i;
+      testGlobCreateTree(name.str(), depth - 1);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+struct testGlobResult
+{
+  std::vector<std::string> Files;
+  std::vector<std::string> Messages;
+  unsigned int FollowedSymlinks;
+};
+
+static testGlobResult testGlobRun(std::string const& expr,
+                                  unsigned int threads, bool listDirs)
+{
+  cmsys::Glob g;
+  g.RecurseOn();
+  g.SetRecurseListDirs(listDirs);
+  g.SetThreads(threads);
+  cmsys::Glob::GlobMessages messages;
+  g.FindFiles(expr, &messages);
+
+  testGlobResult result;
+  result.Files = g.GetFiles();
+  for(cmsys::Glob::GlobMessagesIterator i = messages.begin();
+      i != messages.end(); ++i)
+    {
+    result.Messages.push_back(i->content);
+    }
+  result.FollowedSymlinks = g.GetFollowedSymlinkCount();
+  return result;
+}
+
+//----------------------------------------------------------------------------
+int testGlob(int, char*[])
+{
+  int failed = 0;
+
+  std::string top = cmSystemTools::GetCurrentWorkingDirectory();
+  top += "/testGlob";
+  cmSystemTools::RemoveADirectory(top);
+  testGlobCreateTree(top, 3);
+#if !defined(_WIN32)
+  // A followed symlink and a cyclic one.
+  cmSystemTools::CreateSymlink(top + "/d1", top + "/d0/link");
+  cmSystemTools::CreateSymlink("..", top + "/d2/d3/loop");
+#endif
+
+  const char* const patterns[] = { "/*.cxx", "/*", 0 };
+  for(const char* const* p = patterns; *p; ++p)
+    {
+    for(int listDirs = 0; listDirs < 2; ++listDirs)
+      {
+      std::string expr = top + *p;
+      testGlobResult serial = testGlobRun(expr, 1, listDirs != 0);
+      testGlobResult parallel = testGlobRun(expr, 4, listDirs != 0);
+      if(serial.Files.size() < 100)
+        {
+        cmFailed("Glob finds the files of " << expr);
+        }
+      if(parallel.Files != serial.Files ||
+         parallel.Messages != serial.Messages ||
+         parallel.FollowedSymlinks != serial.FollowedSymlinks)
+        {
+        cmFailed("Glob on 4 threads finds the same as on 1 in " << expr);
+        }
+      }
+    }
+
+  cmSystemTools::RemoveADirectory(top);
+  if(!failed)
+    {
+    cmPassed("Glob on several threads finds the same as on one");
+    }
+  return failed;
+}
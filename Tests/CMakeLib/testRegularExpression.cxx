@@ -0,0 +1,219 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2015 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmRegularExpression.h"
+
+#include <cmsys/RegularExpression.hxx>
+
+#define cmPassed(m) std::cout << "Passed: " << m << "\n"
+#define cmFailed(m) std::cout << "FAILED: " << m << "\n"; failed=1
+
+// Compare a find of cmRegularExpression with the one of cmsys.
+static bool testRegularExpressionSame(std::string const& regex,
+                                      std::string const& input,
+                                      bool everyPosition = true)
+{
+  cmsys::RegularExpression expected;
+  cmRegularExpression actual;
+  if(!expected.compile(regex))
+    {
+    return !actual.compile(regex);
+    }
+  if(!actual.compile(regex))
+    {
+    return false;
+    }
+  // Search from each position, as string(REGEX MATCHALL) does.
+  for(const char* p = input.c_str();; ++p)
+    {
+    bool found = expected.find(p);
+    if(actual.find(p) != found)
+      {
+      return false;
+      }
+    for(int n = 0; found && n < cmRegularExpression::NSUBEXP; ++n)
+      {
+      if(actual.match(n) != expected.match(n) ||
+         (actual.start(n) != std::string::npos &&
+          (actual.start(n) != expected.start(n) ||
+           actual.end(n) != expected.end(n))))
+        {
+        return false;
+        }
+      }
+    if(!*p || !everyPosition)
+      {
+      return true;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Pseudo-random patterns that cmsys accepts.
+static unsigned int testRegularExpressionSeed = 1;
+
+static unsigned int testRegularExpressionRandom(unsigned int n)
+{
+  testRegularExpressionSeed = testRegularExpressionSeed * 1103515245 + 12345;
+  return (testRegularExpressionSeed / 65536) % n;
+}
+
+static std::string testRegularExpressionGenerate(int depth, int& parens,
+                                                 bool& width)
+{
+  static const char* const atoms[] = {
+    "a", "b", "ab", "ba", ".", "[ab]", "[^a]", "[a-c]", "[]a]", "\\.",
+    "^", "$"
+  };
+  std::string regex;
+  width = true;
+  unsigned int branches = 1 + testRegularExpressionRandom(2);
+  for(unsigned int b = 0; b < branches; ++b)
+    {
+    bool branchWidth = false;
+    if(b > 0)
+      {
+      regex += "|";
+      }
+    unsigned int pieces = testRegularExpressionRandom(4);
+    for(unsigned int i = 0; i < pieces; ++i)
+      {
+      std::string atom;
+      bool atomWidth = true;
+      if(depth < 2 && parens < 9 && testRegularExpressionRandom(4) == 0)
+        {
+        ++parens;
+        atom = "(" +
+          testRegularExpressionGenerate(depth + 1, parens, atomWidth) + ")";
+        }
+      else
+        {
+        atom = atoms[testRegularExpressionRandom(
+          sizeof(atoms) / sizeof(atoms[0]))];
+        atomWidth = atom != "^" && atom != "$";
+        }
+      switch (testRegularExpressionRandom(atomWidth? 5 : 3))
+        {
+        case 0: atom += "?"; atomWidth = false; break;
+        case 3: atom += "*"; atomWidth = false; break;
+        case 4: atom += "+"; break;
+        default: break;
+        }
+      regex += atom;
+      branchWidth = branchWidth || atomWidth;
+      }
+    width = width && branchWidth;
+    }
+  return regex;
+}
+
+//----------------------------------------------------------------------------
+int testRegularExpression(int, char*[])
+{
+  int failed = 0;
+
+  static const char* const cases[][2] = {
+    {"^([^;]*);(.*)$", "first;second;third"},
+    {"(a|ab)(c|bcd)(d*)", "abcd"},
+    {"((a)|b)*", "ab"},
+    {"([a-z]+)\\.([a-z]*)", "file.name.ext"},
+    {"^ab", "abab"},
+    {"b$", "abab"},
+    {"x*", "aaa"},
+    {"(a*)+b", "aaab"},
+    {"[--z]+", "a-z"},
+    {"", "abc"},
+    {"lib", "path/to/libfoo.so"},
+    {"(())?x", "x"},
+    {"(a)|(b)|(c)", "c"},
+    {"(a)(b)(c)(d)(e)(f)(g)(h)(i)", "abcdefghi"},
+    {0, 0}
+  };
+  for(int i = 0; cases[i][0]; ++i)
+    {
+    if(!testRegularExpressionSame(cases[i][0], cases[i][1]))
+      {
+      cmFailed("cmRegularExpression \"" << cases[i][0]
+               << "\" finds the same as cmsys in \"" << cases[i][1] << "\"");
+      }
+    }
+
+  // Invalid patterns are rejected by both.
+  static const char* const invalid[] = {
+    "(", ")", "[a", "a**", "*a", "(a?)*", "^*", "a\\", "[b-a]",
+    "(a)(b)(c)(d)(e)(f)(g)(h)(i)(j)", 0
+  };
+  for(int i = 0; invalid[i]; ++i)
+    {
+    cmRegularExpression re;
+    if(re.compile(invalid[i]) || re.is_valid())
+      {
+      cmFailed("cmRegularExpression rejects \"" << invalid[i] << "\"");
+      }
+    }
+
+  // Compare both engines on generated patterns and inputs.
+  static const char* const inputs[] = {
+    "", "a", "ab", "ba", "aab", "abab", "a.b", "bba]", "cab.ab", "]]ab.c"
+  };
+  // Long inputs are not matched by backtracking.
+  std::string longInput;
+  for(int i = 0; i < 500; ++i)
+    {
+    longInput += inputs[i % (sizeof(inputs) / sizeof(inputs[0]))];
+    }
+  for(int i = 0; i < 2000 && !failed; ++i)
+    {
+    int parens = 0;
+    bool width;
+    std::string regex = testRegularExpressionGenerate(0, parens, width);
+    for(size_t j = 0; j < sizeof(inputs) / sizeof(inputs[0]); ++j)
+      {
+      if(!testRegularExpressionSame(regex, inputs[j]))
+        {
+        cmFailed("cmRegularExpression \"" << regex
+                 << "\" finds the same as cmsys in \"" << inputs[j] << "\"");
+        break;
+        }
+      }
+    if(!failed && !testRegularExpressionSame(regex, longInput, false))
+      {
+      cmFailed("cmRegularExpression \"" << regex
+               << "\" finds the same as cmsys in a long input");
+      }
+    }
+
+  // Matching takes linear time where backtracking would not finish.
+  std::string many(100000, 'a');
+  cmRegularExpression slow("^(a|aa)*(a|aa)*(a|aa)*b");
+  if(slow.find(many))
+    {
+    cmFailed("cmRegularExpression does not find \"b\" in many \"a\"");
+    }
+
+  // A copy keeps the matches of the original.
+  cmRegularExpression group("(b+)");
+  if(!group.find("abbc"))
+    {
+    cmFailed("cmRegularExpression finds \"(b+)\" in \"abbc\"");
+    }
+  cmRegularExpression copy(group);
+  if(copy.match(1) != "bb" || copy.start(1) != 1 || copy.end(1) != 3)
+    {
+    cmFailed("cmRegularExpression copies keep their matches");
+    }
+
+  if(!failed)
+    {
+    cmPassed("cmRegularExpression finds the same matches as cmsys");
+    }
+  return failed;
+}
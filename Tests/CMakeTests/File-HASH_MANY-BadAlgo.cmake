@@ -0,0 +1 @@
+file(HASH_MANY MD4 md4 ${CMAKE_CURRENT_LIST_DIR}/File-HASH-Input.txt)
@@ -0,0 +1,4 @@
+file(HASH_MANY MD5 md5
+  ${CMAKE_CURRENT_LIST_DIR}/File-HASH-Input.txt
+  ${CMAKE_CURRENT_LIST_DIR}/DoesNotExist.cmake
+  )
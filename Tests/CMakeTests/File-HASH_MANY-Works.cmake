@@ -0,0 +1,12 @@
+# More than a few blocks of the hash, and a remainder.
+set(long "0123456789abcdef")
+foreach(i RANGE 1 7)
+  set(long "${long}${long}")
+endforeach()
+file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/File-HASH_MANY-Long.txt "${long}tail")
+file(HASH_MANY SHA256 sha256
+  ${CMAKE_CURRENT_LIST_DIR}/File-HASH-Input.txt
+  ${CMAKE_CURRENT_BINARY_DIR}/File-HASH_MANY-Long.txt
+  )
+file(HASH_MANY SHA1 sha1 ${CMAKE_CURRENT_BINARY_DIR}/File-HASH_MANY-Long.txt)
+message("${sha256};${sha1}")
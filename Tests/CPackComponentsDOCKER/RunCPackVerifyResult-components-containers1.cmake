@@ -31,3 +31,14 @@ if(NOT actual_count EQUAL expected_count)
   message(STATUS "actual_count='${actual_count}'")
   message(FATAL_ERROR "error: expected_count=${expected_count} does not match actual_count=${actual_count}: CPackComponents test fails. (CPack_output=${CPack_output}, CPack_error=${CPack_error})")
 endif()
+
+# packaging unchanged content again must not rebuild the image
+run_cpack(actual_output
+          CPack_output
+          CPack_error
+          EXPECTED_FILE_MASK "${expected_file_mask}"
+          CONFIG_ARGS ${config_args}
+          CONFIG_VERBOSE ${config_verbose})
+if(NOT CPack_output MATCHES "Docker image [^ ]+ is up to date")
+  message(FATAL_ERROR "error: unchanged image was rebuilt. (CPack_output=${CPack_output}, CPack_error=${CPack_error})")
+endif()
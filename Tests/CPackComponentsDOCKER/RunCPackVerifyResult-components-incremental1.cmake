@@ -0,0 +1,73 @@
+if(NOT CPackComponentsDOCKER_SOURCE_DIR)
+  message(FATAL_ERROR "CPackComponentsDOCKER_SOURCE_DIR not set")
+endif()
+
+include(${CPackComponentsDOCKER_SOURCE_DIR}/RunCPackVerifyResult.cmake)
+
+
+# expected results
+set(expected_file_mask "${CPackComponentsDOCKER_BINARY_DIR}/MyLib-*.dockerfile")
+set(expected_count 1)
+
+
+set(actual_output)
+run_cpack(actual_output
+          CPack_output
+          CPack_error
+          EXPECTED_FILE_MASK "${expected_file_mask}"
+          CONFIG_ARGS ${config_args}
+          CONFIG_VERBOSE ${config_verbose})
+
+
+if(NOT actual_output)
+  message(STATUS "expected_count='${expected_count}'")
+  message(STATUS "expected_file_mask='${expected_file_mask}'")
+  message(STATUS "actual_output_files='${actual_output}'")
+  message(FATAL_ERROR "error: expected_files do not exist: CPackComponentsDOCKER test fails. (CPack_output=${CPack_output}, CPack_error=${CPack_error}")
+endif()
+
+list(LENGTH actual_output actual_count)
+if(NOT actual_count EQUAL expected_count)
+  message(STATUS "actual_count='${actual_count}'")
+  message(FATAL_ERROR "error: expected_count=${expected_count} does not match actual_count=${actual_count}: CPackComponents test fails. (CPack_output=${CPack_output}, CPack_error=${CPack_error})")
+endif()
+
+# the staging tree of the previous run is updated in place
+file(GLOB_RECURSE _staged "${CPackComponentsDOCKER_BINARY_DIR}/_CPack_Packages/mylib.h")
+get_filename_component(_stale "${_staged}" DIRECTORY)
+set(_stale "${_stale}/stale/stale.h")
+file(WRITE "${_stale}" "stale")
+# a second run only installs what changed and removes the stale file
+run_cpack(actual_output
+          CPack_output
+          CPack_error
+          EXPECTED_FILE_MASK "${expected_file_mask}"
+          CONFIG_ARGS ${config_args}
+          CONFIG_VERBOSE -V)
+if(NOT CPack_output MATCHES "Up-to-date: [^\n]*mylib\\.h")
+  message(FATAL_ERROR "error: unchanged file was installed again. (CPack_output=${CPack_output}, CPack_error=${CPack_error})")
+endif()
+if(EXISTS "${_stale}")
+  message(FATAL_ERROR "error: file no longer installed was kept: ${_stale}")
+endif()
+
+find_program(DOCKER_EXECUTABLE docker)
+if(DOCKER_EXECUTABLE)
+  set(docker_output_errors_all "")
+  foreach(_f IN LISTS actual_output)
+    run_docker(run_docker_output 
+               run_docker_result
+               FILENAME "${_f}")
+    file(WRITE "${_f}.log" ${run_docker_output})
+    if(run_docker_result)
+      message(FATAL_ERROR "Error while running the dockerfile")
+    endif()
+    delete_docker(delete_docker_output
+                  delete_docker_result
+                  FILENAME "${_f}")
+    file(APPEND "${_f}.log" ${delete_docker_output})
+    if(delete_docker_result)
+      message(FATAL_ERROR "Error while deleting the docker image")
+    endif()
+  endforeach()
+endif()
@@ -0,0 +1,70 @@
+if(NOT CPackComponentsDOCKER_SOURCE_DIR)
+  message(FATAL_ERROR "CPackComponentsDOCKER_SOURCE_DIR not set")
+endif()
+
+include(${CPackComponentsDOCKER_SOURCE_DIR}/RunCPackVerifyResult.cmake)
+
+
+# expected results
+set(expected_file_mask "${CPackComponentsDOCKER_BINARY_DIR}/MyLib-*.oci.tar")
+set(expected_count 1)
+
+
+set(actual_output)
+run_cpack(actual_output
+          CPack_output
+          CPack_error
+          EXPECTED_FILE_MASK "${expected_file_mask}"
+          CONFIG_ARGS ${config_args}
+          CONFIG_VERBOSE ${config_verbose})
+
+
+if(NOT actual_output)
+  message(STATUS "expected_count='${expected_count}'")
+  message(STATUS "expected_file_mask='${expected_file_mask}'")
+  message(STATUS "actual_output_files='${actual_output}'")
+  message(FATAL_ERROR "error: expected_files do not exist: CPackComponentsDOCKER test fails. (CPack_output=${CPack_output}, CPack_error=${CPack_error}")
+endif()
+
+list(LENGTH actual_output actual_count)
+if(NOT actual_count EQUAL expected_count)
+  message(STATUS "actual_count='${actual_count}'")
+  message(FATAL_ERROR "error: expected_count=${expected_count} does not match actual_count=${actual_count}: CPackComponents test fails. (CPack_output=${CPack_output}, CPack_error=${CPack_error})")
+endif()
+
+# the image layout must be complete and every blob must match its digest
+set(_layout "${CPackComponentsDOCKER_BINARY_DIR}/oci-layout-check")
+file(REMOVE_RECURSE "${_layout}")
+file(MAKE_DIRECTORY "${_layout}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf "${actual_output}"
+                WORKING_DIRECTORY "${_layout}")
+foreach(_f oci-layout index.json manifest.json)
+  if(NOT EXISTS "${_layout}/${_f}")
+    message(FATAL_ERROR "error: ${_f} missing from OCI image ${actual_output}")
+  endif()
+endforeach()
+file(GLOB _blobs "${_layout}/blobs/sha256/*")
+list(LENGTH _blobs _blob_count)
+if(NOT _blob_count EQUAL 3)
+  message(FATAL_ERROR "error: expected 3 blobs (layer, config, manifest), found ${_blob_count}")
+endif()
+foreach(_blob IN LISTS _blobs)
+  get_filename_component(_name "${_blob}" NAME)
+  file(SHA256 "${_blob}" _hash)
+  if(NOT _hash STREQUAL _name)
+    message(FATAL_ERROR "error: blob ${_name} has digest ${_hash}")
+  endif()
+endforeach()
+
+# packaging unchanged content again must give an identical image
+file(SHA256 "${actual_output}" _first)
+run_cpack(actual_output
+          CPack_output
+          CPack_error
+          EXPECTED_FILE_MASK "${expected_file_mask}"
+          CONFIG_ARGS ${config_args}
+          CONFIG_VERBOSE ${config_verbose})
+file(SHA256 "${actual_output}" _second)
+if(NOT _first STREQUAL _second)
+  message(FATAL_ERROR "error: OCI image is not reproducible: ${_first} != ${_second}")
+endif()
@@ -0,0 +1,23 @@
+foreach(ext tar.gz tar.bz2 tar.xz)
+  set(package "${RunCMake_TEST_BINARY_DIR}/threads.${ext}")
+  if(NOT EXISTS "${package}")
+    set(RunCMake_TEST_FAILED "Package not generated:\n  ${package}")
+    return()
+  endif()
+  set(dir "${RunCMake_TEST_BINARY_DIR}/extract-${ext}")
+  file(REMOVE_RECURSE "${dir}")
+  file(MAKE_DIRECTORY "${dir}")
+  execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf "${package}"
+    WORKING_DIRECTORY "${dir}" RESULT_VARIABLE result)
+  set(file "${dir}/threads/foo/big.txt")
+  if(NOT result EQUAL 0 OR NOT EXISTS "${file}")
+    set(RunCMake_TEST_FAILED "Cannot extract ${package}")
+    return()
+  endif()
+  file(SHA1 "${file}" extracted)
+  file(SHA1 "${RunCMake_TEST_BINARY_DIR}/big.txt" expected)
+  if(NOT extracted STREQUAL expected)
+    set(RunCMake_TEST_FAILED "Unexpected content of ${package}")
+    return()
+  endif()
+endforeach()
@@ -0,0 +1,16 @@
+# Write a file of several compression blocks.
+set(data "0123456789abcdef")
+foreach(i RANGE 17)
+  set(data "${data}${data}")
+endforeach()
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/big.txt" "${data}")
+install(FILES "${CMAKE_CURRENT_BINARY_DIR}/big.txt" DESTINATION foo)
+
+set(CPACK_PACKAGE_NAME "threads")
+set(CPACK_PACKAGE_VERSION "1.0")
+set(CPACK_PACKAGE_FILE_NAME "threads")
+if(NOT CPACK_GENERATOR)
+  set(CPACK_GENERATOR "TGZ;TBZ2;TXZ")
+endif()
+set(CPACK_ARCHIVE_THREADS 3)
+include(CPack)
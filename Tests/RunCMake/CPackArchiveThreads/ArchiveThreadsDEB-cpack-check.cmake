@@ -0,0 +1,25 @@
+file(GLOB data "${RunCMake_TEST_BINARY_DIR}/_CPack_Packages/*/DEB/*/data.tar.gz")
+if(NOT data)
+  set(RunCMake_TEST_FAILED "data.tar.gz not generated")
+  return()
+endif()
+# The threads write gzip members with a "CM" extra subfield.
+file(READ "${data}" head LIMIT 16 HEX)
+if(NOT head MATCHES "^1f8b0804................434d")
+  set(RunCMake_TEST_FAILED "data.tar.gz not compressed in blocks:\n${head}")
+  return()
+endif()
+set(dir "${RunCMake_TEST_BINARY_DIR}/extract")
+file(REMOVE_RECURSE "${dir}")
+file(MAKE_DIRECTORY "${dir}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf "${data}"
+  WORKING_DIRECTORY "${dir}" RESULT_VARIABLE result)
+file(SHA1 "${RunCMake_TEST_BINARY_DIR}/big.txt" expected)
+if(result OR NOT EXISTS "${dir}/usr/foo/big.txt")
+  set(RunCMake_TEST_FAILED "Cannot extract ${data}")
+  return()
+endif()
+file(SHA1 "${dir}/usr/foo/big.txt" extracted)
+if(NOT extracted STREQUAL expected)
+  set(RunCMake_TEST_FAILED "Unexpected content of ${data}")
+endif()
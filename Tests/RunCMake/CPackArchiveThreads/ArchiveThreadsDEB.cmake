@@ -0,0 +1,4 @@
+set(CPACK_GENERATOR "DEB")
+set(CPACK_PACKAGE_CONTACT "someone")
+set(CPACK_DEBIAN_PACKAGE_ARCHITECTURE "all")
+include(ArchiveThreads.cmake)
@@ -0,0 +1,14 @@
+include(RunCMake)
+
+function(run_ArchiveThreads case)
+  run_cmake(${case})
+  set(RunCMake_TEST_BINARY_DIR "${RunCMake_BINARY_DIR}/${case}-build")
+  set(RunCMake_TEST_NO_CLEAN TRUE)
+  run_cmake_command(${case}-cpack ${CMAKE_CPACK_COMMAND})
+endfunction()
+
+run_ArchiveThreads(ArchiveThreads)
+# The data.tar of a DEB package is compressed on several threads too.
+if(CMAKE_HOST_UNIX)
+  run_ArchiveThreads(ArchiveThreadsDEB)
+endif()
@@ -0,0 +1,22 @@
+# Each image is built from a context of its dockerfile and staged files.
+foreach(c a b)
+  file(GLOB context "${contexts}/*-${c}.tar")
+  if(NOT context)
+    file(READ "${contexts}/commands.txt" commands)
+    set(RunCMake_TEST_FAILED "No context for ${c}, commands:\n${commands}")
+    return()
+  endif()
+  execute_process(COMMAND ${CMAKE_COMMAND} -E tar tf "${context}"
+    OUTPUT_VARIABLE files RESULT_VARIABLE result)
+  if(result OR NOT files MATCHES "share/${c}/" OR
+     NOT files MATCHES "(^|\n)[^/\n]*-${c}\\.[^/\n]*\n")
+    set(RunCMake_TEST_FAILED "Unexpected context for ${c}:\n${files}")
+    return()
+  endif()
+endforeach()
+
+# No context is left behind.
+file(GLOB_RECURSE left "${RunCMake_TEST_BINARY_DIR}/*.context.tar")
+if(left)
+  set(RunCMake_TEST_FAILED "Context left behind:\n${left}")
+endif()
@@ -0,0 +1,12 @@
+install(FILES CMakeLists.txt DESTINATION share/a COMPONENT a)
+install(FILES DockerBuild.cmake DESTINATION share/b COMPONENT b)
+
+set(CPACK_PACKAGE_NAME "build")
+set(CPACK_PACKAGE_VERSION "1.0")
+set(CPACK_PACKAGE_CONTACT "someone")
+set(CPACK_PACKAGE_DESCRIPTION_SUMMARY "Docker build")
+set(CPACK_GENERATOR "DOCKER")
+set(CPACK_DOCKER_COMPONENT_INSTALL ON)
+set(CPACK_DOCKER_BUILD_CONTAINER ON)
+set(CPACK_DOCKER_PARALLEL_JOBS 2)
+include(CPack)
@@ -0,0 +1 @@
+include(DockerBuild.cmake)
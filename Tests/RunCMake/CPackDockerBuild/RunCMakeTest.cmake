@@ -0,0 +1,36 @@
+include(RunCMake)
+
+# A stub docker saves the build context it is sent on stdin.
+set(path "${RunCMake_BINARY_DIR}/path")
+set(contexts "${RunCMake_BINARY_DIR}/contexts")
+file(REMOVE_RECURSE "${contexts}")
+file(MAKE_DIRECTORY "${path}" "${contexts}")
+file(WRITE "${path}/docker.in" "#!/bin/sh
+echo \"$*\" >> \"${contexts}/commands.txt\"
+if test -n \"$DOCKER_STUB_FAIL\"; then
+  exit 1
+fi
+if test \"$1\" = build; then
+  for a; do
+    case \"$a\" in --tag=*) tag=\${a#--tag=} ;; esac
+  done
+  cat > \"${contexts}/$tag.tar\"
+fi
+")
+file(COPY "${path}/docker.in" DESTINATION "${path}/bin"
+  FILE_PERMISSIONS OWNER_READ OWNER_WRITE OWNER_EXECUTE)
+file(RENAME "${path}/bin/docker.in" "${path}/bin/docker")
+set(ENV{PATH} "${path}/bin:$ENV{PATH}")
+
+function(run_DockerBuild case)
+  run_cmake(${case})
+  set(RunCMake_TEST_BINARY_DIR "${RunCMake_BINARY_DIR}/${case}-build")
+  set(RunCMake_TEST_NO_CLEAN TRUE)
+  run_cmake_command(${case}-cpack ${CMAKE_CPACK_COMMAND} -V)
+endfunction()
+
+run_DockerBuild(DockerBuild)
+# A build that fails without reading its context fails the package.
+set(ENV{DOCKER_STUB_FAIL} 1)
+run_DockerBuild(DockerBuildFail)
+unset(ENV{DOCKER_STUB_FAIL})
@@ -0,0 +1,64 @@
+set(image "${RunCMake_TEST_BINARY_DIR}/oci.oci.tar")
+set(dir "${RunCMake_TEST_BINARY_DIR}/oci")
+file(REMOVE_RECURSE "${dir}")
+file(MAKE_DIRECTORY "${dir}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf "${image}"
+  WORKING_DIRECTORY "${dir}" RESULT_VARIABLE result)
+if(result OR NOT EXISTS "${dir}/oci-layout" OR
+   NOT EXISTS "${dir}/index.json" OR NOT EXISTS "${dir}/manifest.json")
+  set(RunCMake_TEST_FAILED "${image} is not an OCI image layout.")
+  return()
+endif()
+
+# Each blob is named after the digest of its content.
+file(GLOB blobs "${dir}/blobs/sha256/*")
+foreach(blob IN LISTS blobs)
+  get_filename_component(name "${blob}" NAME)
+  file(SHA256 "${blob}" digest)
+  if(NOT digest STREQUAL name)
+    set(RunCMake_TEST_FAILED "Blob ${name} has digest ${digest}.")
+    return()
+  endif()
+endforeach()
+
+# The index refers to the manifest, which refers to the config and layer.
+file(READ "${dir}/index.json" index)
+if(NOT index MATCHES "\"digest\":\"sha256:([0-9a-f]+)\"")
+  set(RunCMake_TEST_FAILED "No manifest in index.json:\n${index}")
+  return()
+endif()
+file(READ "${dir}/blobs/sha256/${CMAKE_MATCH_1}" manifest)
+string(REGEX MATCHALL "sha256:[0-9a-f]+" digests "${manifest}")
+list(LENGTH digests count)
+math(EXPR count "${count} - 1")
+if(NOT count EQUAL layers)
+  set(RunCMake_TEST_FAILED
+    "Expected a config and ${layers} layers in:\n${manifest}")
+  return()
+endif()
+foreach(digest IN LISTS digests)
+  string(SUBSTRING "${digest}" 7 -1 name)
+  if(NOT EXISTS "${dir}/blobs/sha256/${name}")
+    set(RunCMake_TEST_FAILED "Missing blob ${digest}.")
+    return()
+  endif()
+endforeach()
+list(GET digests 0 config)
+list(REMOVE_AT digests 0)
+string(REPLACE ";" "\",\"" diff_ids "${digests}")
+string(SUBSTRING "${config}" 7 -1 config)
+file(READ "${dir}/blobs/sha256/${config}" config)
+if(NOT config MATCHES "\"diff_ids\":\\[\"${diff_ids}\"\\]" OR
+   NOT config MATCHES "\"Cmd\":\\[\"/usr/share/oci/CMakeLists.txt\"\\]")
+  set(RunCMake_TEST_FAILED "Unexpected config:\n${config}")
+  return()
+endif()
+# The files not claimed by a layer come last.
+list(GET digests -1 layer)
+string(SUBSTRING "${layer}" 7 -1 layer)
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar tf
+  "${dir}/blobs/sha256/${layer}" OUTPUT_VARIABLE content)
+if(NOT content MATCHES "usr/share/oci/CMakeLists.txt" OR
+   content MATCHES "usr/share/data/CMakeLists.txt")
+  set(RunCMake_TEST_FAILED "Unexpected content of layer:\n${content}")
+endif()
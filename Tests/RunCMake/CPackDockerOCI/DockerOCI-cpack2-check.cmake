@@ -0,0 +1,5 @@
+file(SHA256 "${RunCMake_TEST_BINARY_DIR}/first.oci.tar" first)
+file(SHA256 "${RunCMake_TEST_BINARY_DIR}/oci.oci.tar" second)
+if(NOT first STREQUAL second)
+  set(RunCMake_TEST_FAILED "The image changed although its content did not.")
+endif()
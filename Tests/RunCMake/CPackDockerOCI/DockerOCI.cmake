@@ -0,0 +1,12 @@
+install(FILES CMakeLists.txt DESTINATION share/oci)
+
+set(CPACK_PACKAGE_NAME "oci")
+set(CPACK_PACKAGE_VERSION "1.0")
+set(CPACK_PACKAGE_CONTACT "someone")
+set(CPACK_PACKAGE_DESCRIPTION_SUMMARY "OCI image")
+set(CPACK_PACKAGE_FILE_NAME "oci")
+set(CPACK_GENERATOR "DOCKER")
+set(CPACK_DOCKER_IMAGE_FORMAT "OCI")
+set(CPACK_DOCKER_IMAGE_ARCHITECTURE "amd64")
+set(CPACK_DOCKER_CMD "/usr/share/oci/CMakeLists.txt")
+include(CPack)
@@ -0,0 +1,18 @@
+include(${RunCMake_SOURCE_DIR}/DockerOCI-cpack-check.cmake)
+if(RunCMake_TEST_FAILED)
+  return()
+endif()
+list(GET digests 0 layer)
+string(SUBSTRING "${layer}" 7 -1 layer)
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar tf
+  "${dir}/blobs/sha256/${layer}" OUTPUT_VARIABLE content)
+if(NOT content MATCHES "usr/share/data/CMakeLists.txt")
+  set(RunCMake_TEST_FAILED "Unexpected content of layer:\n${content}")
+  return()
+endif()
+# The staged files are left where the install put them.
+file(GLOB_RECURSE staged
+  "${RunCMake_TEST_BINARY_DIR}/_CPack_Packages/*/CMakeLists.txt")
+if(NOT staged MATCHES "/oci/usr/share/data/CMakeLists.txt")
+  set(RunCMake_TEST_FAILED "The staged files were moved:\n${staged}")
+endif()
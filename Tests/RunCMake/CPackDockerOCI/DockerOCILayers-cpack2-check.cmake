@@ -0,0 +1 @@
+include(${RunCMake_SOURCE_DIR}/DockerOCI-cpack2-check.cmake)
@@ -0,0 +1,5 @@
+install(FILES CMakeLists.txt DESTINATION share/data)
+set(CPACK_DOCKER_LAYERS data)
+set(CPACK_DOCKER_LAYER_DATA "usr/share/data")
+set(CPACK_INCREMENTAL_INSTALL ON)
+include(DockerOCI.cmake)
@@ -0,0 +1,25 @@
+include(RunCMake)
+
+# The image is written without docker, so make sure none is found.
+find_program(UNAME_EXECUTABLE uname)
+set(path "${RunCMake_BINARY_DIR}/path")
+file(MAKE_DIRECTORY "${path}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E create_symlink
+  "${UNAME_EXECUTABLE}" "${path}/uname")
+set(ENV{PATH} "${path}")
+
+function(run_DockerOCI case)
+  run_cmake(${case})
+  set(RunCMake_TEST_BINARY_DIR "${RunCMake_BINARY_DIR}/${case}-build")
+  set(RunCMake_TEST_NO_CLEAN TRUE)
+  run_cmake_command(${case}-cpack ${CMAKE_CPACK_COMMAND} -V)
+  # The digests of unchanged content do not change.
+  file(RENAME "${RunCMake_TEST_BINARY_DIR}/oci.oci.tar"
+    "${RunCMake_TEST_BINARY_DIR}/first.oci.tar")
+  run_cmake_command(${case}-cpack2 ${CMAKE_CPACK_COMMAND} -V)
+endfunction()
+
+set(layers 1)
+run_DockerOCI(DockerOCI)
+set(layers 2)
+run_DockerOCI(DockerOCILayers)
@@ -0,0 +1,8 @@
+set(package "${RunCMake_TEST_BINARY_DIR}/incremental.tar.gz")
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar tf "${package}"
+  OUTPUT_VARIABLE content)
+if(NOT content MATCHES "incremental/foo/CMakeLists.txt" OR
+   NOT content MATCHES "incremental/generated.txt" OR
+   content MATCHES "stale")
+  set(RunCMake_TEST_FAILED "Unexpected content of ${package}:\n${content}")
+endif()
@@ -0,0 +1,9 @@
+install(FILES CMakeLists.txt DESTINATION foo)
+install(CODE "file(WRITE \"\$ENV{DESTDIR}\${CMAKE_INSTALL_PREFIX}/generated.txt\" \"generated\")")
+
+set(CPACK_PACKAGE_NAME "incremental")
+set(CPACK_PACKAGE_VERSION "1.0")
+set(CPACK_PACKAGE_FILE_NAME "incremental")
+set(CPACK_GENERATOR "TGZ")
+set(CPACK_INCREMENTAL_INSTALL ON)
+include(CPack)
@@ -0,0 +1,9 @@
+include(RunCMake)
+
+run_cmake(IncrementalInstall)
+set(RunCMake_TEST_BINARY_DIR "${RunCMake_BINARY_DIR}/IncrementalInstall-build")
+set(RunCMake_TEST_NO_CLEAN TRUE)
+run_cmake_command(IncrementalInstall-cpack ${CMAKE_CPACK_COMMAND} -V)
+file(GLOB staged "${RunCMake_TEST_BINARY_DIR}/_CPack_Packages/*/TGZ/incremental")
+file(WRITE "${staged}/stale.txt" "stale")
+run_cmake_command(IncrementalInstall-cpack2 ${CMAKE_CPACK_COMMAND} -V)
@@ -0,0 +1,10 @@
+install(FILES CMakeLists.txt DESTINATION a COMPONENT a)
+install(FILES CMakeLists.txt DESTINATION b COMPONENT b)
+install(FILES CMakeLists.txt DESTINATION c COMPONENT c)
+install(CODE "file(WRITE \"\$ENV{DESTDIR}\${CMAKE_INSTALL_PREFIX}/c/generated.txt\" \"generated\")"
+  COMPONENT c)
+
+set(CPACK_PACKAGE_NAME "parallel")
+set(CPACK_PACKAGE_VERSION "1.0")
+set(CPACK_PACKAGE_CONTACT "someone")
+set(CPACK_INSTALL_PARALLEL_JOBS 3)
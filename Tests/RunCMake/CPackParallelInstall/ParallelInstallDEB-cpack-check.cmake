@@ -0,0 +1,14 @@
+set(package "${RunCMake_TEST_BINARY_DIR}/parallel-all.deb")
+set(dir "${RunCMake_TEST_BINARY_DIR}/parallel-all")
+file(REMOVE_RECURSE "${dir}")
+file(MAKE_DIRECTORY "${dir}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf "${package}"
+  WORKING_DIRECTORY "${dir}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar tf "${dir}/data.tar.gz"
+  OUTPUT_VARIABLE content)
+foreach(f a/CMakeLists.txt b/CMakeLists.txt c/CMakeLists.txt c/generated.txt)
+  if(NOT content MATCHES "usr/${f}")
+    set(RunCMake_TEST_FAILED "Unexpected content of ${package}:\n${content}")
+    return()
+  endif()
+endforeach()
@@ -0,0 +1,10 @@
+include(Components.cmake)
+set(CPACK_GENERATOR "DEB")
+set(CPACK_DEB_COMPONENT_INSTALL ON)
+set(CPACK_DEBIAN_PACKAGE_ARCHITECTURE "all")
+set(CPACK_PACKAGE_FILE_NAME "parallel")
+include(CPack)
+cpack_add_component_group(all)
+foreach(c a b c)
+  cpack_add_component(${c} GROUP all)
+endforeach()
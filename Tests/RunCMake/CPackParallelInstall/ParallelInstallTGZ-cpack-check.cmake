@@ -0,0 +1,12 @@
+foreach(c a b c)
+  set(package "${RunCMake_TEST_BINARY_DIR}/parallel-${c}.tar.gz")
+  execute_process(COMMAND ${CMAKE_COMMAND} -E tar tf "${package}"
+    OUTPUT_VARIABLE content)
+  if(NOT content MATCHES "${c}/CMakeLists.txt")
+    set(RunCMake_TEST_FAILED "Unexpected content of ${package}:\n${content}")
+    return()
+  endif()
+endforeach()
+if(NOT content MATCHES "c/generated.txt")
+  set(RunCMake_TEST_FAILED "Unexpected content of ${package}:\n${content}")
+endif()
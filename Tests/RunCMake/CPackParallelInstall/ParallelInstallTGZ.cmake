@@ -0,0 +1,5 @@
+include(Components.cmake)
+set(CPACK_GENERATOR "TGZ")
+set(CPACK_ARCHIVE_COMPONENT_INSTALL ON)
+set(CPACK_PACKAGE_FILE_NAME "parallel")
+include(CPack)
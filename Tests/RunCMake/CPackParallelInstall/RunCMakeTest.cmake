@@ -0,0 +1,15 @@
+include(RunCMake)
+
+function(run_ParallelInstall type)
+  run_cmake(ParallelInstall${type})
+  set(RunCMake_TEST_BINARY_DIR
+    "${RunCMake_BINARY_DIR}/ParallelInstall${type}-build")
+  set(RunCMake_TEST_NO_CLEAN TRUE)
+  run_cmake_command(ParallelInstall${type}-cpack ${CMAKE_CPACK_COMMAND} -V)
+endfunction()
+
+run_ParallelInstall(TGZ)
+# The components of a group share an install directory.
+if(CMAKE_HOST_UNIX)
+  run_ParallelInstall(DEB)
+endif()
@@ -0,0 +1,6 @@
+include(RunCMake)
+
+run_cmake(SharedArchives)
+set(RunCMake_TEST_BINARY_DIR "${RunCMake_BINARY_DIR}/SharedArchives-build")
+set(RunCMake_TEST_NO_CLEAN TRUE)
+run_cmake_command(SharedArchives-cpack ${CMAKE_CPACK_COMMAND} -V)
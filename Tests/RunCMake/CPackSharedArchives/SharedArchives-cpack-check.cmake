@@ -0,0 +1,13 @@
+foreach(ext tar.gz zip)
+  set(package "${RunCMake_TEST_BINARY_DIR}/shared.${ext}")
+  if(NOT EXISTS "${package}")
+    set(RunCMake_TEST_FAILED "Package not generated:\n  ${package}")
+    return()
+  endif()
+  execute_process(COMMAND ${CMAKE_COMMAND} -E tar tf "${package}"
+    OUTPUT_VARIABLE content)
+  if(NOT content MATCHES "shared/foo/CMakeLists.txt")
+    set(RunCMake_TEST_FAILED "Unexpected content of ${package}:\n${content}")
+    return()
+  endif()
+endforeach()
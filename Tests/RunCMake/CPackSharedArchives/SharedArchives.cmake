@@ -0,0 +1,7 @@
+install(FILES CMakeLists.txt DESTINATION foo)
+
+set(CPACK_PACKAGE_NAME "shared")
+set(CPACK_PACKAGE_VERSION "1.0")
+set(CPACK_PACKAGE_FILE_NAME "shared")
+set(CPACK_GENERATOR "TGZ;ZIP")
+include(CPack)
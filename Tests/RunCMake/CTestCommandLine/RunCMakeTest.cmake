@@ -108,3 +108,171 @@ run_TestLoad(test-load-invalid 'two')
 run_TestLoad(test-load-pass 10)
 
 unset(ENV{__CTEST_FAKE_LOAD_AVERAGE_FOR_TESTING})
+
+function(run_Shard name)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/Shard)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(ShardA \"${CMAKE_COMMAND}\" -E echo \"ShardA\")
+add_test(ShardB \"${CMAKE_COMMAND}\" -E echo \"ShardB\")
+add_test(ShardC \"${CMAKE_COMMAND}\" -E echo \"ShardC\")
+add_test(ShardD \"${CMAKE_COMMAND}\" -E echo \"ShardD\")
+add_test(ShardE \"${CMAKE_COMMAND}\" -E echo \"ShardE\")
+set_tests_properties(ShardD PROPERTIES DEPENDS ShardC)
+set_tests_properties(ShardA ShardE PROPERTIES RESOURCE_LOCK ShardLock)
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt"
+"ShardA 1 10
+ShardB 1 6
+ShardC 1 3
+ShardD 1 2
+ShardE 1 1
+---
+")
+  run_cmake_command(${name} ${CMAKE_CTEST_COMMAND} -N ${ARGN})
+endfunction()
+
+# Tests for the --shard-index and --shard-count options of ctest
+run_Shard(shard-0 --shard-index 0 --shard-count 2)
+run_Shard(shard-1 --shard-index 1 --shard-count 2)
+run_Shard(shard-bad --shard-index 2 --shard-count 2)
+
+function(run_TestMemory name memory)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestMemory)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(TestMemory1 \"${CMAKE_COMMAND}\" -E echo \"test of --test-memory\")
+  add_test(TestMemory2 \"${CMAKE_COMMAND}\" -E echo \"test of --test-memory\")
+  set_tests_properties(TestMemory1 TestMemory2 PROPERTIES PEAK_MEMORY 60)
+")
+  run_cmake_command(${name} ${CMAKE_CTEST_COMMAND} -j2 --test-memory ${memory} ${ARGN})
+endfunction()
+
+# Tests for the --test-memory feature of ctest
+#
+# Spoof the host memory state to make these tests more reliable.
+set(ENV{__CTEST_FAKE_AVAILABLE_MEMORY_FOR_TESTING} 1000)
+set(ENV{__CTEST_FAKE_MEMORY_PRESSURE_FOR_TESTING} 0)
+
+# Verify that a test is not started while it would exceed the budget,
+# and that the observed peak memory is recorded in the cost data.
+run_TestMemory(test-memory-budget 100 --debug)
+
+# Verify that warning message is displayed but tests still start when
+# an invalid argument is given.
+run_TestMemory(test-memory-invalid 'two')
+
+# Verify that tests wait out the back-off from memory pressure and still
+# all run once nothing else is running.
+function(run_TestMemoryPressure)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestMemoryPressure)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(TestMemory1 \"${CMAKE_COMMAND}\" -E sleep 0.5)
+  add_test(TestMemory2 \"${CMAKE_COMMAND}\" -E echo \"test of --test-memory\")
+  set_tests_properties(TestMemory1 TestMemory2 PROPERTIES PEAK_MEMORY 60)
+")
+  run_cmake_command(test-memory-pressure ${CMAKE_CTEST_COMMAND} -j2 --test-memory 100 --debug)
+endfunction()
+set(ENV{__CTEST_FAKE_MEMORY_PRESSURE_FOR_TESTING} 50)
+run_TestMemoryPressure()
+
+unset(ENV{__CTEST_FAKE_AVAILABLE_MEMORY_FOR_TESTING})
+unset(ENV{__CTEST_FAKE_MEMORY_PRESSURE_FOR_TESTING})
+
+function(run_StopOnFailure)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/StopOnFailure)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(StopPass1 \"${CMAKE_COMMAND}\" -E echo \"StopPass1\")
+  add_test(StopFail \"${CMAKE_COMMAND}\" -E echo \"StopFail\")
+  add_test(StopPass2 \"${CMAKE_COMMAND}\" -E echo \"StopPass2\")
+  set_tests_properties(StopFail PROPERTIES WILL_FAIL ON)
+")
+  run_cmake_command(stop-on-failure ${CMAKE_CTEST_COMMAND} --stop-on-failure)
+  # Resume with the tests that were not started.
+  run_cmake_command(stop-on-failure-resume ${CMAKE_CTEST_COMMAND} -F)
+endfunction()
+run_StopOnFailure()
+
+function(run_StopOnFailureKill)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/StopOnFailureKill)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(StopSleep \"${CMAKE_COMMAND}\" -E sleep 60)
+  add_test(StopFail \"${CMAKE_COMMAND}\" -E echo \"StopFail\")
+  set_tests_properties(StopFail PROPERTIES WILL_FAIL ON)
+")
+  run_cmake_command(stop-on-failure-kill
+    ${CMAKE_CTEST_COMMAND} -j2 --stop-on-failure kill)
+endfunction()
+run_StopOnFailureKill()
+
+function(run_ResourceReport)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/ResourceReport)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(ResourceReport1 \"${CMAKE_COMMAND}\" -E echo \"test of --resource-report\")
+  add_test(ResourceReport2 \"${CMAKE_COMMAND}\" -E echo \"test of --resource-report\")
+")
+  run_cmake_command(resource-report ${CMAKE_CTEST_COMMAND} --resource-report 1)
+endfunction()
+run_ResourceReport()
+
+function(run_AdaptiveTimeout name)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/AdaptiveTimeout)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(AdaptivePass \"${CMAKE_COMMAND}\" -E echo \"AdaptivePass\")
+  add_test(AdaptiveHang \"${CMAKE_COMMAND}\" -E sleep 10)
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt"
+"AdaptivePass 3 0.1 0 0.1,0.1,0.1
+AdaptiveHang 3 0.1 0 0.1,0.2,0.1
+---
+")
+  run_cmake_command(${name} ${CMAKE_CTEST_COMMAND} ${ARGN})
+endfunction()
+
+# Tests for the --adaptive-timeout option of ctest
+run_AdaptiveTimeout(adaptive-timeout
+  --adaptive-timeout 2 --adaptive-timeout-floor 1)
+run_AdaptiveTimeout(adaptive-timeout-bad --adaptive-timeout 0)
+
+# A test that became slower is killed by the adaptive timeout a few
+# times, then runs with its normal timeout and records its new run time.
+function(run_AdaptiveTimeoutGrow)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/AdaptiveTimeoutGrow)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(AdaptiveGrow \"${CMAKE_COMMAND}\" -E sleep 2)
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt"
+"AdaptiveGrow 3 0.1 0 0.1,0.1,0.1
+---
+")
+  set(args --adaptive-timeout 2 --adaptive-timeout-floor 1)
+  foreach(run 1 2 3)
+    run_cmake_command(adaptive-timeout-grow-killed ${CMAKE_CTEST_COMMAND} ${args})
+  endforeach()
+  foreach(run 1 2)
+    run_cmake_command(adaptive-timeout-grow-passed ${CMAKE_CTEST_COMMAND} ${args})
+  endforeach()
+endfunction()
+run_AdaptiveTimeoutGrow()
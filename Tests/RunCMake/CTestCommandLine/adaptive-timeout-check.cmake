@@ -0,0 +1,6 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt" cost)
+if(NOT cost MATCHES "(^|\n)AdaptivePass 4 [^ \n]+ [0-9]+ 0\\.1,0\\.1,0\\.1,[0-9.e-]+\n")
+  set(RunCMake_TEST_FAILED "Run time not recorded in cost data:\n${cost}")
+elseif(NOT cost MATCHES "(^|\n)AdaptiveHang 3 [^ \n]+ [0-9]+ 0\\.1,0\\.2,0\\.1 1\n")
+  set(RunCMake_TEST_FAILED "Adaptive timeout not counted in cost data:\n${cost}")
+endif()
@@ -0,0 +1,4 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt" cost)
+if(NOT cost MATCHES "(^|\n)AdaptiveGrow 3 [^ \n]+ [0-9]+ 0\\.1,0\\.1,0\\.1 [1-3]\n")
+  set(RunCMake_TEST_FAILED "Adaptive timeout not counted in cost data:\n${cost}")
+endif()
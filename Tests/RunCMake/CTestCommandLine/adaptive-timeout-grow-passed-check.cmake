@@ -0,0 +1,4 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt" cost)
+if(NOT cost MATCHES "(^|\n)AdaptiveGrow [45] [^ \n]+ [0-9]+ 0\\.1,0\\.1,0\\.1(,2[.0-9]*)+\n")
+  set(RunCMake_TEST_FAILED "Longer run time not recorded in cost data:\n${cost}")
+endif()
@@ -0,0 +1,11 @@
+set(json "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestResourceUsage.json")
+if(NOT EXISTS "${json}")
+  set(RunCMake_TEST_FAILED "Resource usage summary not written:\n ${json}")
+  return()
+endif()
+file(READ "${json}" usage)
+foreach(test ResourceReport1 ResourceReport2)
+  if(NOT usage MATCHES "\"name\" : \"${test}\"")
+    set(RunCMake_TEST_FAILED "Test ${test} missing from resource usage:\n${usage}")
+  endif()
+endforeach()
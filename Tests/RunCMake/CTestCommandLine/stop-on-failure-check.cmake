@@ -0,0 +1,9 @@
+set(checkpoint "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCheckpoint.txt")
+if(NOT EXISTS "${checkpoint}")
+  set(RunCMake_TEST_FAILED "Checkpoint file not kept:\n ${checkpoint}")
+  return()
+endif()
+file(READ "${checkpoint}" finished)
+if(NOT finished STREQUAL "1\n2\n")
+  set(RunCMake_TEST_FAILED "Unexpected checkpoint content:\n${finished}")
+endif()
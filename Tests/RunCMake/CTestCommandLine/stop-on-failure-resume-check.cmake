@@ -0,0 +1,3 @@
+if(actual_stdout MATCHES "StopPass1|StopFail")
+  set(RunCMake_TEST_FAILED "Finished tests were run again.")
+endif()
@@ -0,0 +1,4 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt" cost)
+if(NOT cost MATCHES "(^|\n)TestMemory1 1 [^ \n]+ [0-9]+[ \n]")
+  set(RunCMake_TEST_FAILED "Peak memory not recorded in cost data:\n${cost}")
+endif()
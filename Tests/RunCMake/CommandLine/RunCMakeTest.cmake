@@ -10,6 +10,10 @@ run_cmake_command(U-no-arg ${CMAKE_COMMAND} -U)
 run_cmake_command(E-no-arg ${CMAKE_COMMAND} -E)
 run_cmake_command(E_echo_append ${CMAKE_COMMAND} -E echo_append)
 run_cmake_command(E_rename-no-arg ${CMAKE_COMMAND} -E rename)
+run_cmake_command(E_batch ${CMAKE_COMMAND} -E batch -- echo first -- make_directory batch-dir -- echo second)
+run_cmake_command(E_batch-fail ${CMAKE_COMMAND} -E batch -- echo first -- rename batch-no-such-file batch-never -- echo never)
+run_cmake_command(E_batch-file ${CMAKE_COMMAND} -E batch ${RunCMake_SOURCE_DIR}/E_batch-file.txt)
+run_cmake_command(E_batch-no-file ${CMAKE_COMMAND} -E batch batch-no-such-file)
 run_cmake_command(E_touch_nocreate-no-arg ${CMAKE_COMMAND} -E touch_nocreate)
 
 run_cmake_command(E___run_iwyu-no-iwyu ${CMAKE_COMMAND} -E __run_iwyu -- command-does-not-exist)
@@ -15,9 +15,13 @@ external_command_test(end-opt1   tar cvf bad.tar -- --bad)
 external_command_test(end-opt2   tar cvf bad.tar --)
 external_command_test(mtime      tar cvf bad.tar "--mtime=1970-01-01 00:00:00 UTC")
 external_command_test(bad-format tar cvf bad.tar "--format=bad-format")
+external_command_test(bad-threads tar cvf bad.tar --threads=bad)
 external_command_test(zip-bz2    tar cvjf bad.tar "--format=zip")
 external_command_test(7zip-gz    tar cvzf bad.tar "--format=7zip")
 
+run_cmake(threads-gz)
+run_cmake(threads-xz)
+run_cmake(threads-replace)
 run_cmake(7zip)
 run_cmake(gnutar)
 run_cmake(gnutar-gz)
@@ -0,0 +1,11 @@
+set(OUTPUT_NAME "test.tar.gz")
+
+set(COMPRESSION_FLAGS cvzf)
+set(COMPRESSION_OPTIONS --threads=4)
+
+set(DECOMPRESSION_FLAGS xvzf)
+set(DECOMPRESSION_OPTIONS --threads=4)
+
+include(${CMAKE_CURRENT_LIST_DIR}/roundtrip.cmake)
+
+check_magic("1f8b" LIMIT 2 HEX)
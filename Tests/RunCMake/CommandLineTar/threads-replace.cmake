@@ -0,0 +1,23 @@
+# Files extracted on threads replace empty directories as libarchive does.
+set(archive ${CMAKE_CURRENT_BINARY_DIR}/replace.tar)
+set(input ${CMAKE_CURRENT_BINARY_DIR}/replace_in)
+set(output ${CMAKE_CURRENT_BINARY_DIR}/replace_out)
+file(REMOVE_RECURSE ${input} ${output})
+file(WRITE ${input}/f1.txt "f1")
+file(MAKE_DIRECTORY ${output}/f1.txt)
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar cf ${archive} f1.txt
+  WORKING_DIRECTORY ${input} RESULT_VARIABLE result)
+if(NOT result STREQUAL "0")
+  message(FATAL_ERROR "tar failed to create ${archive}")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf ${archive} --threads=4
+  WORKING_DIRECTORY ${output} RESULT_VARIABLE result)
+if(NOT result STREQUAL "0")
+  message(FATAL_ERROR "tar failed to extract ${archive}")
+endif()
+
+file(READ ${output}/f1.txt content)
+if(NOT content STREQUAL "f1")
+  message(SEND_ERROR "Directory not replaced by f1.txt")
+endif()
@@ -0,0 +1,3 @@
+if(NOT EXISTS ${RunCMake_TEST_BINARY_DIR}/dir/copy.txt)
+  set(RunCMake_TEST_FAILED "The custom command did not create dir/copy.txt.")
+endif()
@@ -0,0 +1,17 @@
+# The Makefile and Ninja generators run the operations in one process.
+if(RunCMake_GENERATOR MATCHES "Make|Ninja")
+  file(GLOB_RECURSE build_files
+    ${RunCMake_TEST_BINARY_DIR}/build.make
+    ${RunCMake_TEST_BINARY_DIR}/build.ninja
+    )
+  set(batch FALSE)
+  foreach(f IN LISTS build_files)
+    file(READ "${f}" content)
+    if(content MATCHES "-E batch -- make_directory dir -- touch dir/file.txt -- copy_if_different dir/file.txt dir/copy.txt")
+      set(batch TRUE)
+    endif()
+  endforeach()
+  if(NOT batch)
+    set(RunCMake_TEST_FAILED "The custom command does not use \"cmake -E batch\".")
+  endif()
+endif()
@@ -0,0 +1,8 @@
+add_custom_command(
+  OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/dir/copy.txt
+  COMMAND ${CMAKE_COMMAND} -E make_directory dir
+  COMMAND ${CMAKE_COMMAND} -E touch dir/file.txt
+  COMMAND ${CMAKE_COMMAND} -E copy_if_different dir/file.txt dir/copy.txt
+  VERBATIM
+  )
+add_custom_target(batch ALL DEPENDS ${CMAKE_CURRENT_BINARY_DIR}/dir/copy.txt)
@@ -0,0 +1,17 @@
+# Each redirection applies to its own command only.
+foreach(f first second)
+  if(f STREQUAL "first")
+    set(file ${RunCMake_TEST_BINARY_DIR}/f1.txt)
+  else()
+    set(file ${RunCMake_TEST_BINARY_DIR}/f2.txt)
+  endif()
+  if(NOT EXISTS ${file})
+    set(RunCMake_TEST_FAILED "The custom command did not create ${file}.")
+    return()
+  endif()
+  file(STRINGS ${file} content)
+  if(NOT content STREQUAL "${f}")
+    set(RunCMake_TEST_FAILED "${file} contains \"${content}\", not \"${f}\".")
+    return()
+  endif()
+endforeach()
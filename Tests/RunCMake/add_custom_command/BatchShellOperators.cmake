@@ -0,0 +1,7 @@
+add_custom_command(
+  OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/stamp
+  COMMAND ${CMAKE_COMMAND} -E echo first > f1.txt
+  COMMAND ${CMAKE_COMMAND} -E echo second > f2.txt
+  COMMAND ${CMAKE_COMMAND} -E touch stamp
+  )
+add_custom_target(redirect ALL DEPENDS ${CMAKE_CURRENT_BINARY_DIR}/stamp)
@@ -0,0 +1,17 @@
+execute_process(
+  COMMAND ${CMAKE_COMMAND} -E echo first
+  COMMAND ${CMAKE_COMMAND} -P ${CMAKE_CURRENT_LIST_DIR}/JobsFail.cmake
+  COMMAND ${CMAKE_COMMAND} -E echo third
+  COMMAND no-such-command-for-execute_process
+  JOBS 2
+  RESULT_VARIABLE res
+  OUTPUT_VARIABLE out
+  ERROR_VARIABLE err
+  OUTPUT_STRIP_TRAILING_WHITESPACE
+  ERROR_STRIP_TRAILING_WHITESPACE
+  )
+message("res=[${res}]")
+message("res_2=[${res_2}]")
+message("out_0=[${out_0}]")
+message("out_2=[${out_2}]")
+message("err_1=[${err_1}]")
@@ -0,0 +1 @@
+execute_process(COMMAND ${CMAKE_COMMAND} -E echo first JOBS many)
@@ -0,0 +1,2 @@
+message("Output on stderr")
+message(FATAL_ERROR "Failed")
@@ -0,0 +1,2 @@
+execute_process(COMMAND ${CMAKE_COMMAND} -E echo first JOBS 2
+  OUTPUT_FILE ${CMAKE_CURRENT_BINARY_DIR}/out.txt)
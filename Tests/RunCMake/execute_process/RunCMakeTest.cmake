@@ -6,3 +6,7 @@ unset(RunCMake_TEST_OUTPUT_MERGE)
 
 run_cmake_command(MergeOutputFile ${CMAKE_COMMAND} -P ${RunCMake_SOURCE_DIR}/MergeOutputFile.cmake)
 run_cmake_command(MergeOutputVars ${CMAKE_COMMAND} -P ${RunCMake_SOURCE_DIR}/MergeOutputVars.cmake)
+
+run_cmake_command(Jobs ${CMAKE_COMMAND} -P ${RunCMake_SOURCE_DIR}/Jobs.cmake)
+run_cmake_command(JobsBadValue ${CMAKE_COMMAND} -P ${RunCMake_SOURCE_DIR}/JobsBadValue.cmake)
+run_cmake_command(JobsOutputFile ${CMAKE_COMMAND} -P ${RunCMake_SOURCE_DIR}/JobsOutputFile.cmake)
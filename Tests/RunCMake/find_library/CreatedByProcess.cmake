@@ -0,0 +1,17 @@
+list(APPEND CMAKE_FIND_LIBRARY_PREFIXES lib)
+list(APPEND CMAKE_FIND_LIBRARY_SUFFIXES .a)
+file(MAKE_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/lib)
+find_library(CREATED_LIBRARY
+  NAMES created
+  PATHS ${CMAKE_CURRENT_BINARY_DIR}/lib
+  NO_DEFAULT_PATH
+  )
+message("CREATED_LIBRARY='${CREATED_LIBRARY}'")
+execute_process(COMMAND ${CMAKE_COMMAND} -E touch
+  "${CMAKE_CURRENT_BINARY_DIR}/lib/libcreated.a")
+find_library(CREATED_LIBRARY
+  NAMES created
+  PATHS ${CMAKE_CURRENT_BINARY_DIR}/lib
+  NO_DEFAULT_PATH
+  )
+message("CREATED_LIBRARY='${CREATED_LIBRARY}'")
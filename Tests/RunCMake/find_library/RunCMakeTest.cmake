@@ -1,4 +1,5 @@
 include(RunCMake)
 
 run_cmake(Created)
+run_cmake(CreatedByProcess)
 run_cmake(PrefixInPATH)
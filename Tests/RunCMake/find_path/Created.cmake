@@ -0,0 +1,13 @@
+find_path(CREATED_INCLUDE_DIR
+  NAMES created.h
+  PATHS ${CMAKE_CURRENT_BINARY_DIR}/include
+  NO_DEFAULT_PATH
+  )
+message("CREATED_INCLUDE_DIR='${CREATED_INCLUDE_DIR}'")
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/include/created.h" "")
+find_path(CREATED_INCLUDE_DIR
+  NAMES created.h
+  PATHS ${CMAKE_CURRENT_BINARY_DIR}/include
+  NO_DEFAULT_PATH
+  )
+message("CREATED_INCLUDE_DIR='${CREATED_INCLUDE_DIR}'")
@@ -1,3 +1,4 @@
 include(RunCMake)
 
+run_cmake(Created)
 run_cmake(PrefixInPATH)